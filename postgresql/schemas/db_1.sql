@@ -5,6 +5,10 @@ DROP SCHEMA IF EXISTS ens_schema CASCADE;
 
 CREATE SCHEMA IF NOT EXISTS ens_schema;
 
+DROP TYPE IF EXISTS ens_schema.tenant_tier;
+
+CREATE TYPE ens_schema.tenant_tier AS ENUM ('Basic', 'Standard', 'Premium');
+
 DROP TABLE IF EXISTS ens_schema.user CASCADE;
 
 CREATE TABLE IF NOT EXISTS ens_schema.user
@@ -12,7 +16,8 @@ CREATE TABLE IF NOT EXISTS ens_schema.user
     name          VARCHAR(256) UNIQUE NOT NULL,
     password_hash TEXT                NOT NULL, -- Consider using different type
     password_salt TEXT                NOT NULL,
-    user_id       uuid PRIMARY KEY
+    user_id       uuid PRIMARY KEY,
+    tier          ens_schema.tenant_tier NOT NULL DEFAULT 'Standard' -- Share of the dispatch capacity while the other tenants send
 );
 
 DROP TABLE IF EXISTS ens_schema.notification_template CASCADE;
@@ -23,6 +28,7 @@ CREATE TABLE IF NOT EXISTS ens_schema.notification_template
     message_text             VARCHAR(1024),
     notification_template_id uuid PRIMARY KEY,
     master_id                uuid        NOT NULL,
+    attachment_file          VARCHAR(256), -- Name of a file in the attachments directory sent along with the message
     FOREIGN KEY (master_id) REFERENCES ens_schema.user (user_id) ON DELETE CASCADE
 );
 
@@ -37,6 +43,10 @@ CREATE TABLE IF NOT EXISTS ens_schema.notification_template_draft
     FOREIGN KEY (master_id) REFERENCES ens_schema.user (user_id) ON DELETE CASCADE
 );
 
+DROP TYPE IF EXISTS ens_schema.message_type;
+
+CREATE TYPE ens_schema.message_type AS ENUM ('Telegram', 'SMS', 'Mail', 'TelegramChannel');
+
 DROP TABLE IF EXISTS ens_schema.recipient CASCADE;
 
 CREATE TABLE IF NOT EXISTS ens_schema.recipient
@@ -47,6 +57,7 @@ CREATE TABLE IF NOT EXISTS ens_schema.recipient
     telegram_id  BIGINT,
     recipient_id uuid PRIMARY KEY,
     master_id    uuid        NOT NULL,
+    preferred_channel ens_schema.message_type, -- Channel tried first, the configured priority is followed if NULL
     FOREIGN KEY (master_id) REFERENCES ens_schema.user (user_id) ON DELETE CASCADE
 );
 
@@ -72,6 +83,7 @@ CREATE TABLE IF NOT EXISTS ens_schema.recipient_group
     recipient_group_id uuid PRIMARY KEY,
     master_id          uuid        NOT NULL,
     template_id        uuid,
+    telegram_channel_id BIGINT, -- Notifications are posted to the channel instead of direct messages if set
     FOREIGN KEY (master_id) REFERENCES ens_schema.user (user_id) ON DELETE CASCADE,
     FOREIGN KEY (template_id) REFERENCES ens_schema.notification_template (notification_template_id) ON DELETE SET NULL
 );
@@ -100,6 +112,10 @@ CREATE TABLE IF NOT EXISTS ens_schema.recipient_recipient_group
     FOREIGN KEY (recipient_group_id) REFERENCES ens_schema.recipient_group (recipient_group_id) ON DELETE CASCADE
 );
 
+DROP TYPE IF EXISTS ens_schema.batch_priority;
+
+CREATE TYPE ens_schema.batch_priority AS ENUM ('Emergency', 'High', 'Routine');
+
 DROP TABLE IF EXISTS ens_schema.notifications_batch CASCADE;
 
 CREATE TABLE IF NOT EXISTS ens_schema.notifications_batch
@@ -107,13 +123,11 @@ CREATE TABLE IF NOT EXISTS ens_schema.notifications_batch
     sent    BOOLEAN NOT NULL,
     batch_id  uuid PRIMARY KEY,
     master_id uuid    NOT NULL,
+    priority  ens_schema.batch_priority NOT NULL DEFAULT 'Routine', -- Lane the sends of the batch wait in
+    scheduled_at BIGINT, -- Unix time in milliseconds the batch is sent at, NULL if it is not scheduled
     FOREIGN KEY (master_id) REFERENCES ens_schema.user (user_id) ON DELETE CASCADE
 );
 
-DROP TYPE IF EXISTS ens_schema.message_type;
-
-CREATE TYPE ens_schema.message_type AS ENUM ('Telegram', 'SMS', 'Mail');
-
 DROP TABLE IF EXISTS ens_schema.notification CASCADE;
 
 CREATE TABLE IF NOT EXISTS ens_schema.notification
@@ -123,17 +137,118 @@ CREATE TABLE IF NOT EXISTS ens_schema.notification
     completion_timestamp BIGINT,
     notification_id      uuid PRIMARY KEY,
     batch_id             uuid,
-    recipient_id         uuid                    NOT NULL,
+    recipient_id         uuid, -- NULL for a channel post delivered to the whole group
     group_id             uuid                    NOT NULL,
     FOREIGN KEY (batch_id) REFERENCES ens_schema.notifications_batch ON DELETE SET NULL,
     FOREIGN KEY (recipient_id) REFERENCES ens_schema.recipient (recipient_id) ON DELETE CASCADE,
     FOREIGN KEY (group_id) REFERENCES ens_schema.recipient_group (recipient_group_id) ON DELETE CASCADE
 );
 
+DROP TYPE IF EXISTS ens_schema.response_status;
+
+CREATE TYPE ens_schema.response_status AS ENUM ('Safe', 'NeedHelp');
+
+DROP TABLE IF EXISTS ens_schema.notification_response CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.notification_response
+(
+    notification_id    uuid PRIMARY KEY, -- Written before the notification itself, so it isn't a foreign key
+    batch_id           uuid                       NOT NULL,
+    status             ens_schema.response_status NOT NULL,
+    telegram_id        BIGINT                     NOT NULL,
+    response_timestamp BIGINT                     NOT NULL,
+    FOREIGN KEY (batch_id) REFERENCES ens_schema.notifications_batch (batch_id) ON DELETE CASCADE
+);
+
+DROP TABLE IF EXISTS ens_schema.batch_counters CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.batch_counters
+(
+    batch_id  uuid PRIMARY KEY,
+    targeted  BIGINT  NOT NULL DEFAULT 0,
+    sent      BIGINT  NOT NULL DEFAULT 0,
+    failed    BIGINT  NOT NULL DEFAULT 0, -- Notifications not delivered over any of the channels
+    responded BIGINT  NOT NULL DEFAULT 0, -- Notifications a recipient has responded to
+    finished  BOOLEAN NOT NULL DEFAULT false,
+    FOREIGN KEY (batch_id) REFERENCES ens_schema.notifications_batch (batch_id) ON DELETE CASCADE
+);
+
+DROP TABLE IF EXISTS ens_schema.batch_partition CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.batch_partition
+(
+    batch_id         uuid    NOT NULL,
+    partition        INTEGER NOT NULL, -- Recipients whose id hash modulo partitions equals the partition
+    partitions       INTEGER NOT NULL,
+    direct_groups    uuid[]  NOT NULL, -- Groups whose channel post failed, their subscribers are messaged directly
+    holder_id        uuid, -- Instance of the service dispatching the partition
+    expires_at       BIGINT  NOT NULL DEFAULT 0, -- Unix time in milliseconds by the database clock
+    done             BOOLEAN NOT NULL DEFAULT false,
+    notification_ids uuid[],
+    PRIMARY KEY (batch_id, partition),
+    FOREIGN KEY (batch_id) REFERENCES ens_schema.notifications_batch (batch_id) ON DELETE CASCADE
+);
+
+DROP TABLE IF EXISTS ens_schema.partition_delivery CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.partition_delivery
+(
+    batch_id        uuid                    NOT NULL,
+    partition       INTEGER                 NOT NULL,
+    notification_id uuid                    NOT NULL,
+    recipient_id    uuid                    NOT NULL,
+    group_id        uuid                    NOT NULL,
+    type            ens_schema.message_type NOT NULL, -- Channel which accepted the notification
+    PRIMARY KEY (batch_id, partition, recipient_id, group_id),
+    FOREIGN KEY (batch_id, partition) REFERENCES ens_schema.batch_partition (batch_id, partition) ON DELETE CASCADE
+);
+
+DROP TABLE IF EXISTS ens_schema.batch_response_tally CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.batch_response_tally
+(
+    batch_id  uuid                       NOT NULL,
+    status    ens_schema.response_status NOT NULL,
+    responses BIGINT                     NOT NULL, -- Notifications of the batch whose latest response has the status
+    PRIMARY KEY (batch_id, status),
+    FOREIGN KEY (batch_id) REFERENCES ens_schema.notifications_batch (batch_id) ON DELETE CASCADE
+);
+
 DROP TABLE IF EXISTS ens_schema.telegram_contact CASCADE;
 
 CREATE TABLE IF NOT EXISTS ens_schema.telegram_contact
 (
-    user_id BIGINT PRIMARY KEY,
-    active  BOOLEAN NOT NULL
+    user_id   BIGINT PRIMARY KEY,
+    active    BOOLEAN NOT NULL,
+    bot_index INTEGER NOT NULL DEFAULT 0, -- Bot of the pool the user has subscribed through
+    channel_opt_out BOOLEAN NOT NULL DEFAULT false -- Direct messages are sent even for groups posting to a channel
+);
+
+DROP TABLE IF EXISTS ens_schema.rate_budget CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.rate_budget
+(
+    name         TEXT PRIMARY KEY, -- Rate limit shared by the instances of the service
+    window_start BIGINT NOT NULL, -- Unix time in seconds of the second the budget is leased for
+    leased       BIGINT NOT NULL -- Messages of the second leased by the instances
+);
+
+DROP TABLE IF EXISTS ens_schema.rate_budget_holder CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.rate_budget_holder
+(
+    name      TEXT NOT NULL, -- Rate limit shared by the instances of the service
+    holder_id UUID NOT NULL, -- Instance leasing the budget
+    leased_at BIGINT NOT NULL, -- Unix time in seconds of the last second the instance has leased the budget for
+    PRIMARY KEY (name, holder_id)
+);
+
+DROP TABLE IF EXISTS ens_schema.telegram_poller_lease CASCADE;
+
+CREATE TABLE IF NOT EXISTS ens_schema.telegram_poller_lease
+(
+    bot_index     INTEGER PRIMARY KEY,
+    holder_id     uuid   NOT NULL, -- Instance of the service polling the updates of the bot
+    expires_at    BIGINT NOT NULL, -- Unix time in milliseconds by the database clock
+    update_offset BIGINT NOT NULL DEFAULT 0 -- Offset following the last handled update
 );
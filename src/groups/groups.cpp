@@ -296,6 +296,28 @@ void ens::groups::GroupManager::AddRecipient(const boost::uuids::uuid &user_id,
   }
 }
 
+void ens::groups::GroupManager::SetTelegramChannel(const boost::uuids::uuid &user_id,
+                                                  const boost::uuids::uuid &group_id,
+                                                  const std::optional<int64_t> &channel_id) {
+  const userver::storages::postgres::Query update_query{
+      "UPDATE ens_schema.recipient_group "
+      "SET telegram_channel_id = $3 "
+      "WHERE master_id = $1 AND recipient_group_id = $2"
+  };
+  userver::storages::postgres::Transaction update_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet
+      update_res = update_transaction.Execute(update_query,
+                                              user_id,
+                                              group_id,
+                                              channel_id);
+  if (not update_res.RowsAffected()) {
+    update_transaction.Rollback();
+    throw RecipientGroupNotFoundException{boost::uuids::to_string(group_id)};
+  }
+  update_transaction.Commit();
+}
+
 void ens::groups::GroupManager::DeleteGroup(const boost::uuids::uuid &user_id, const boost::uuids::uuid &group_id) {
   const userver::storages::postgres::Query delete_query{
       "DELETE "
@@ -37,6 +37,10 @@ class GroupManager : public userver::components::ComponentBase {
   void AddRecipient(const boost::uuids::uuid &user_id,
                     const boost::uuids::uuid &group_id,
                     const boost::uuids::uuid &recipient_id);
+  // Group notifications are posted to the telegram channel instead of direct messages, nullopt restores direct messages
+  void SetTelegramChannel(const boost::uuids::uuid &user_id,
+                          const boost::uuids::uuid &group_id,
+                          const std::optional<int64_t> &channel_id);
   void DeleteGroup(const boost::uuids::uuid &user_id, const boost::uuids::uuid &group_id);
   void DeleteRecipient(const boost::uuids::uuid &user_id,
                        const boost::uuids::uuid &group_id,
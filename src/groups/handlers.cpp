@@ -416,3 +416,45 @@ userver::formats::json::Value ens::groups::GroupDeleteGroupHandler::HandleReques
 void ens::groups::AppendGroupDeleteGroupHandler(userver::components::ComponentList &component_list) {
   component_list.Append<GroupDeleteGroupHandler>();
 }
+
+userver::formats::json::Value ens::groups::GroupSetTelegramChannelHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                  const userver::formats::json::Value &,
+                                                                                                  userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid group_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("group_id"));
+    // Missing channel_id switches the group back to direct messages
+    std::optional<int64_t> channel_id;
+    if (request.HasArg("channel_id")) {
+      channel_id = boost::lexical_cast<int64_t>(request.GetArg("channel_id"));
+    }
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    this->_group_manager.SetTelegramChannel(user_id, group_id, channel_id);
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const RecipientGroupNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  return userver::formats::json::Value{};
+}
+
+void ens::groups::AppendGroupSetTelegramChannelHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<GroupSetTelegramChannelHandler>();
+}
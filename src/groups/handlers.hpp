@@ -132,4 +132,15 @@ class GroupDeleteGroupHandler : public GroupJsonHandlerBase {
 
 void AppendGroupDeleteGroupHandler(userver::components::ComponentList &component_list);
 
+class GroupSetTelegramChannelHandler : public GroupJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-groups-setTelegramChannel";
+  using GroupJsonHandlerBase::GroupJsonHandlerBase;
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+};
+
+void AppendGroupSetTelegramChannelHandler(userver::components::ComponentList &component_list);
+
 }
\ No newline at end of file
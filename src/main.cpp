@@ -19,8 +19,15 @@
 #include "groups/groups.hpp"
 #include "groups/handlers.hpp"
 #include "notifications/telegram/telegram_bot.hpp"
+#include "notifications/telegram/handlers.hpp"
+#include "notifications/email/email_sender.hpp"
+#include "notifications/sms/sms_gateway.hpp"
 #include "notifications/handlers.hpp"
 #include "notifications/notifications.hpp"
+#include "notifications/batch_scheduler.hpp"
+#include "utils/hedged_reads.hpp"
+#include "notifications/partition_worker.hpp"
+#include "notifications/dispatch_scheduler.hpp"
 #include "utils/utils.hpp"
 
 int main(int argc, char *argv[]) {
@@ -34,6 +41,7 @@ int main(int argc, char *argv[]) {
       .Append<userver::components::Secdist>()
       .Append<userver::components::DefaultSecdistProvider>()
       .Append<userver::telegram::bot::TelegramBotClient>();
+  ens::utils::AppendHedgedReads(component_list);
   ens::user::AppendUserManager(component_list);
   ens::auth::AppendJWTManager(component_list);
   ens::user::AppendUserCreateHandler(component_list);
@@ -48,6 +56,7 @@ int main(int argc, char *argv[]) {
   ens::recipients::AppendRecipientConfirmCreationHandler(component_list);
   ens::recipients::AppendRecipientModifyHandler(component_list);
   ens::recipients::AppendRecipientDeleteHandler(component_list);
+  ens::recipients::AppendRecipientSetPreferredChannelHandler(component_list);
   ens::templates::AppendTemplateManager(component_list);
   ens::templates::AppendTemplateCreateHandler(component_list);
   ens::templates::AppendTemplateGetByIdHandler(component_list);
@@ -55,6 +64,7 @@ int main(int argc, char *argv[]) {
   ens::templates::AppendTemplateConfirmCreationHandler(component_list);
   ens::templates::AppendTemplateModifyHandler(component_list);
   ens::templates::AppendTemplateDeleteHandler(component_list);
+  ens::templates::AppendTemplateSetAttachmentHandler(component_list);
   ens::groups::AppendGroupManager(component_list);
   ens::groups::AppendGroupCreateHandler(component_list);
   ens::groups::AppendGroupGetByIdHandler(component_list);
@@ -66,13 +76,27 @@ int main(int argc, char *argv[]) {
   ens::groups::AppendGroupAddRecipientHandler(component_list);
   ens::groups::AppendGroupDeleteRecipientHandler(component_list);
   ens::groups::AppendGroupDeleteGroupHandler(component_list);
+  ens::groups::AppendGroupSetTelegramChannelHandler(component_list);
+  ens::notifications::AppendDispatchScheduler(component_list);
+  ens::notifications::AppendBatchProgressTracker(component_list);
+  ens::notifications::AppendNotificationsWriter(component_list);
+  ens::notifications::AppendDispatchJournal(component_list);
   ens::notifications::telegram::AppendTelegramNotificationsBot(component_list);
+  ens::notifications::email::AppendEmailSender(component_list);
+  ens::notifications::sms::AppendSmsGateway(component_list);
+  ens::notifications::telegram::AppendTelegramWebhookHandler(component_list);
   ens::notifications::AppendNotificationsManager(component_list);
+  ens::notifications::AppendBatchScheduler(component_list);
+  ens::notifications::AppendPartitionWorker(component_list);
   ens::notifications::AppendNotificationCreateBatchHandler(component_list);
   ens::notifications::AppendNotificationGetByIdHandler(component_list);
   ens::notifications::AppendNotificationGetPendingHandler(component_list);
   ens::notifications::AppendNotificationGetAllHandler(component_list);
   ens::notifications::AppendNotificationSendBatchHandler(component_list);
+  ens::notifications::AppendNotificationScheduleBatchHandler(component_list);
+  ens::notifications::AppendNotificationGetBatchResponsesHandler(component_list);
+  ens::notifications::AppendNotificationGetBatchSummaryHandler(component_list);
+  ens::notifications::AppendNotificationBatchProgressHandler(component_list);
   ens::notifications::AppendNotificationCancelNotificationHandler(component_list);
   return userver::utils::DaemonMain(argc, argv, component_list);
 }
@@ -0,0 +1,217 @@
+#include "batch_progress.hpp"
+
+#include <mutex>
+#include <vector>
+
+#include <userver/logging/log.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+bool ens::notifications::BatchProgressSnapshot::operator==(const BatchProgressSnapshot &other) const {
+  return targeted == other.targeted and sent == other.sent and failed == other.failed
+      and responded == other.responded and finished == other.finished;
+}
+
+ens::notifications::BatchProgressSnapshot ens::notifications::BatchProgress::Snapshot() const {
+  return {targeted.load(), sent.load(), failed.load(), responded.load(), finished.load()};
+}
+
+userver::yaml_config::Schema ens::notifications::BatchProgressTracker::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component keeping the counters of the batches
+    additionalProperties: false
+    properties:
+        retention:
+            type: string
+            description: Period the counters of a finished batch are cached for
+            defaultDescription: 1h
+        flush-interval:
+            type: string
+            description: Interval during which the changes of the counters are collected into a single database write
+            defaultDescription: 1s
+        refresh-interval:
+            type: string
+            description: Age after which the cached counters are reloaded to get the changes made by the other instances
+            defaultDescription: 1s
+  )");
+}
+
+std::shared_ptr<ens::notifications::BatchProgress> ens::notifications::BatchProgressTracker::Track(const boost::uuids::uuid &batch_id,
+                                                                                                 const boost::uuids::uuid &master_id) {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  Entry &entry = _batches[batch_id];
+  if (not entry.progress) {
+    entry.progress = std::make_shared<BatchProgress>();
+  }
+  entry.master_id = master_id;
+  return entry.progress;
+}
+
+std::shared_ptr<ens::notifications::BatchProgress> ens::notifications::BatchProgressTracker::Get(const boost::uuids::uuid &user_id,
+                                                                                               const boost::uuids::uuid &batch_id) {
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    const auto entry_it = _batches.find(batch_id);
+    if (entry_it != _batches.cend() and entry_it->second.refreshed_at.has_value()
+        and std::chrono::steady_clock::now() - entry_it->second.refreshed_at.value() < _refresh_interval) {
+      return entry_it->second.master_id == user_id ? entry_it->second.progress : nullptr;
+    }
+  }
+  if (not Refresh(batch_id)) {
+    return nullptr;
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  const auto entry_it = _batches.find(batch_id);
+  if (entry_it == _batches.cend() or entry_it->second.master_id != user_id) {
+    return nullptr;
+  }
+  return entry_it->second.progress;
+}
+
+void ens::notifications::BatchProgressTracker::AddResponded(const boost::uuids::uuid &batch_id, int64_t responded) {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  Entry &entry = _batches[batch_id];
+  if (not entry.progress) {
+    // The owner of the batch is loaded by the first read
+    entry.progress = std::make_shared<BatchProgress>();
+  }
+  entry.progress->responded += responded;
+}
+
+void ens::notifications::BatchProgressTracker::Finish(const boost::uuids::uuid &batch_id) {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  const auto entry_it = _batches.find(batch_id);
+  if (entry_it == _batches.end()) {
+    return;
+  }
+  entry_it->second.progress->finished = true;
+  entry_it->second.finished_at = std::chrono::steady_clock::now();
+}
+
+bool ens::notifications::BatchProgressTracker::Refresh(const boost::uuids::uuid &batch_id) {
+  const userver::storages::postgres::Query counters_query{
+      "SELECT notifications_batch.master_id, "
+      "COALESCE(batch_counters.targeted, 0) AS targeted, COALESCE(batch_counters.sent, 0) AS sent_count, "
+      "COALESCE(batch_counters.failed, 0) AS failed, COALESCE(batch_counters.responded, 0) AS responded, "
+      "COALESCE(batch_counters.finished, false) AS finished "
+      "FROM ens_schema.notifications_batch "
+      "LEFT JOIN ens_schema.batch_counters ON notifications_batch.batch_id = batch_counters.batch_id "
+      "WHERE notifications_batch.batch_id = $1"
+  };
+  std::lock_guard<userver::engine::Mutex> db_lock(_db_mutex);
+  // Read from the master, a replica may not have the changes this instance has already written
+  userver::storages::postgres::ResultSet counters_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                                                                             counters_query,
+                                                                             batch_id);
+  if (counters_res.IsEmpty()) {
+    return false;
+  }
+  const auto row = counters_res[0];
+  const BatchProgressSnapshot stored{row["targeted"].As<int64_t>(),
+                                     row["sent_count"].As<int64_t>(),
+                                     row["failed"].As<int64_t>(),
+                                     row["responded"].As<int64_t>(),
+                                     row["finished"].As<bool>()};
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  Entry &entry = _batches[batch_id];
+  if (not entry.progress) {
+    entry.progress = std::make_shared<BatchProgress>();
+  }
+  entry.master_id = row["master_id"].As<boost::uuids::uuid>();
+  // Only the difference is added, the changes this instance hasn't written yet stay in the counters
+  BatchProgress &progress = *entry.progress;
+  progress.targeted += stored.targeted - entry.flushed.targeted;
+  progress.sent += stored.sent - entry.flushed.sent;
+  progress.failed += stored.failed - entry.flushed.failed;
+  progress.responded += stored.responded - entry.flushed.responded;
+  if (stored.finished and not progress.finished.exchange(true)) {
+    entry.finished_at = std::chrono::steady_clock::now();
+  }
+  entry.flushed = stored;
+  entry.refreshed_at = std::chrono::steady_clock::now();
+  return true;
+}
+
+void ens::notifications::BatchProgressTracker::Flush() {
+  const userver::storages::postgres::Query increment_query{
+      "INSERT INTO ens_schema.batch_counters "
+      "(batch_id, targeted, sent, failed, responded, finished) "
+      "SELECT changes.batch_id, changes.targeted, changes.sent, changes.failed, changes.responded, "
+      "changes.batch_id = ANY($6) "
+      "FROM UNNEST($1::uuid[], $2::BIGINT[], $3::BIGINT[], $4::BIGINT[], $5::BIGINT[]) "
+      "AS changes(batch_id, targeted, sent, failed, responded) "
+      "INNER JOIN ens_schema.notifications_batch ON changes.batch_id = notifications_batch.batch_id "
+      "ON CONFLICT (batch_id) DO UPDATE "
+      "SET targeted = batch_counters.targeted + EXCLUDED.targeted, "
+      "sent = batch_counters.sent + EXCLUDED.sent, "
+      "failed = batch_counters.failed + EXCLUDED.failed, "
+      "responded = batch_counters.responded + EXCLUDED.responded, "
+      "finished = batch_counters.finished OR EXCLUDED.finished"
+  };
+  std::lock_guard<userver::engine::Mutex> db_lock(_db_mutex);
+  std::vector<boost::uuids::uuid> batch_ids;
+  std::vector<int64_t> targeted;
+  std::vector<int64_t> sent;
+  std::vector<int64_t> failed;
+  std::vector<int64_t> responded;
+  std::vector<boost::uuids::uuid> finished_ids;
+  std::vector<BatchProgressSnapshot> written;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    for (const auto &[batch_id, entry] : _batches) {
+      const BatchProgressSnapshot current = entry.progress->Snapshot();
+      if (current == entry.flushed) {
+        continue;
+      }
+      batch_ids.push_back(batch_id);
+      targeted.push_back(current.targeted - entry.flushed.targeted);
+      sent.push_back(current.sent - entry.flushed.sent);
+      failed.push_back(current.failed - entry.flushed.failed);
+      responded.push_back(current.responded - entry.flushed.responded);
+      if (current.finished) {
+        finished_ids.push_back(batch_id);
+      }
+      written.push_back(current);
+    }
+  }
+  if (batch_ids.empty()) {
+    return;
+  }
+  try {
+    userver::storages::postgres::Transaction increment_transaction =
+        _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+    increment_transaction.Execute(increment_query, batch_ids, targeted, sent, failed, responded, finished_ids);
+    increment_transaction.Commit();
+  }
+  catch (const std::exception &e) {
+    // The changes stay unwritten and are retried by the next flush
+    LOG_ERROR() << "Error writing the counters of " << batch_ids.size() << " batches: " << e.what();
+    return;
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  for (size_t i = 0; i < batch_ids.size(); ++i) {
+    const auto entry_it = _batches.find(batch_ids[i]);
+    if (entry_it != _batches.end()) {
+      entry_it->second.flushed = written[i];
+    }
+  }
+}
+
+void ens::notifications::BatchProgressTracker::Cleanup() {
+  const auto expired_before = std::chrono::steady_clock::now() - _retention;
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  for (auto entry_it = _batches.begin(); entry_it != _batches.end();) {
+    const Entry &entry = entry_it->second;
+    // References are only taken under the lock, so an unused entry stays unused
+    const bool unused = entry.progress.use_count() == 1 and entry.progress->Snapshot() == entry.flushed;
+    if (entry.finished_at.has_value() ? entry.finished_at.value() < expired_before and unused : unused) {
+      entry_it = _batches.erase(entry_it);
+    } else {
+      ++entry_it;
+    }
+  }
+}
+
+void ens::notifications::AppendBatchProgressTracker(userver::components::ComponentList &component_list) {
+  component_list.Append<BatchProgressTracker>();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "utils/utils.hpp"
+
+namespace ens::notifications {
+struct BatchProgressSnapshot {
+  int64_t targeted;
+  int64_t sent;
+  int64_t failed;
+  int64_t responded;
+  bool finished;
+  bool operator==(const BatchProgressSnapshot &other) const;
+};
+
+// Counters of a batch, updated by the sending tasks without locking
+struct BatchProgress {
+  std::atomic<int64_t> targeted{0};
+  std::atomic<int64_t> sent{0};
+  // Notifications not delivered over any of the channels of the recipient
+  std::atomic<int64_t> failed{0};
+  // Notifications a recipient has responded to
+  std::atomic<int64_t> responded{0};
+  std::atomic<bool> finished{false};
+  BatchProgressSnapshot Snapshot() const;
+};
+
+// Component keeping the counters of the batches. The counters are cached in memory and their changes
+// are written to the database in periodic batched increments, so the instances of the service share them.
+// Cached counters are reloaded on reads once they are older than the refresh interval
+class BatchProgressTracker : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "batch-progress";
+  static constexpr std::chrono::milliseconds kDefaultRetention{3600000};
+  static constexpr std::chrono::milliseconds kDefaultFlushInterval{1000};
+  static constexpr std::chrono::milliseconds kDefaultRefreshInterval{1000};
+  static constexpr std::chrono::seconds kCleanupPeriod{60};
+  BatchProgressTracker(const userver::components::ComponentConfig &config,
+                       const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _pg_cluster(
+          component_context
+              .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
+              .GetCluster()),
+      _retention(config["retention"].As<std::chrono::milliseconds>(kDefaultRetention)),
+      _refresh_interval(config["refresh-interval"].As<std::chrono::milliseconds>(kDefaultRefreshInterval)) {
+    _flush_task.Start("batch-progress-flush",
+                      {config["flush-interval"].As<std::chrono::milliseconds>(kDefaultFlushInterval)},
+                      [this] { Flush(); });
+    _cleanup_task.Start("batch-progress-cleanup", {kCleanupPeriod}, [this] { Cleanup(); });
+  }
+  ~BatchProgressTracker() override {
+    _cleanup_task.Stop();
+    _flush_task.Stop();
+    Flush();
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Starts tracking the batch if it isn't tracked yet
+  std::shared_ptr<BatchProgress> Track(const boost::uuids::uuid &batch_id, const boost::uuids::uuid &master_id);
+  // Cached counters of the batch, loaded if they are missing or stale. nullptr if the user has no such batch
+  std::shared_ptr<BatchProgress> Get(const boost::uuids::uuid &user_id, const boost::uuids::uuid &batch_id);
+  // Counts the first responses to the notifications of the batch, whichever instance has sent it
+  void AddResponded(const boost::uuids::uuid &batch_id, int64_t responded);
+  void Finish(const boost::uuids::uuid &batch_id);
+ private:
+  struct Entry {
+    std::shared_ptr<BatchProgress> progress;
+    boost::uuids::uuid master_id;
+    // Part of the counters the database already has
+    BatchProgressSnapshot flushed{0, 0, 0, 0, false};
+    std::optional<std::chrono::steady_clock::time_point> refreshed_at;
+    std::optional<std::chrono::steady_clock::time_point> finished_at;
+  };
+  // Adds the changes made by the other instances, returns false if the batch doesn't exist
+  bool Refresh(const boost::uuids::uuid &batch_id);
+  void Flush();
+  // Drops the batches which finished before the retention period and the ones nobody sends or watches,
+  // unless they have unwritten changes
+  void Cleanup();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  const std::chrono::milliseconds _retention;
+  const std::chrono::milliseconds _refresh_interval;
+  userver::engine::Mutex _mutex;
+  std::unordered_map<boost::uuids::uuid, Entry, boost::hash<boost::uuids::uuid>> _batches;
+  // Serializes the writes and the reloads, so that a reload never misses or repeats a written change
+  userver::engine::Mutex _db_mutex;
+  userver::utils::PeriodicTask _flush_task;
+  userver::utils::PeriodicTask _cleanup_task;
+};
+
+void AppendBatchProgressTracker(userver::components::ComponentList &component_list);
+}
@@ -0,0 +1,143 @@
+#include "batch_scheduler.hpp"
+
+#include <mutex>
+#include <vector>
+
+#include <userver/logging/log.hpp>
+#include <userver/utils/datetime.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+userver::yaml_config::Schema ens::notifications::BatchScheduler::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component sending the batches at their scheduled time
+    additionalProperties: false
+    properties:
+        tick:
+            type: string
+            description: Resolution of the schedules, the batches are sent no earlier than their time and at most a tick later
+            defaultDescription: 10ms
+        sync-period:
+            type: string
+            description: Period of loading the schedules made through the other instances of the service
+            defaultDescription: 60s
+  )");
+}
+
+int64_t ens::notifications::BatchScheduler::NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      userver::utils::datetime::Now().time_since_epoch()).count();
+}
+
+void ens::notifications::BatchScheduler::ScheduleBatch(const boost::uuids::uuid &user_id,
+                                                       const boost::uuids::uuid &batch_id,
+                                                       const std::optional<int64_t> &scheduled_at) {
+  const userver::storages::postgres::Query schedule_query{
+      "UPDATE ens_schema.notifications_batch "
+      "SET scheduled_at = $3 "
+      "WHERE master_id = $1 AND batch_id = $2 AND NOT sent"
+  };
+  userver::storages::postgres::Transaction schedule_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet schedule_res = schedule_transaction.Execute(schedule_query,
+                                                                                     user_id,
+                                                                                     batch_id,
+                                                                                     scheduled_at);
+  if (not schedule_res.RowsAffected()) {
+    throw NotificationBatchNotFoundException{boost::uuids::to_string(batch_id)};
+  }
+  schedule_transaction.Commit();
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _scheduled_during_sync.insert(batch_id);
+  if (scheduled_at.has_value()) {
+    AddSchedule(batch_id, scheduled_at.value());
+  } else {
+    _schedules.erase(batch_id);
+  }
+}
+
+void ens::notifications::BatchScheduler::AddSchedule(const boost::uuids::uuid &batch_id, int64_t scheduled_at) {
+  _schedules[batch_id] = scheduled_at;
+  _wheel.Insert(scheduled_at, {batch_id, scheduled_at});
+}
+
+void ens::notifications::BatchScheduler::Tick() {
+  std::vector<Schedule> expired;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    _wheel.Advance(NowMs(), [this, &expired](Schedule schedule) {
+      const auto schedule_it = _schedules.find(schedule.batch_id);
+      // The batch has been rescheduled or its schedule has been cancelled
+      if (schedule_it == _schedules.end() or schedule_it->second != schedule.scheduled_at) {
+        return;
+      }
+      _schedules.erase(schedule_it);
+      expired.push_back(schedule);
+    });
+  }
+  for (const Schedule &schedule : expired) {
+    _send_tasks.AsyncDetach("batch-scheduled-send", [this, schedule] { Fire(schedule); });
+  }
+}
+
+void ens::notifications::BatchScheduler::Sync() {
+  const userver::storages::postgres::Query schedules_query{
+      "SELECT batch_id, scheduled_at "
+      "FROM ens_schema.notifications_batch "
+      "WHERE scheduled_at IS NOT NULL AND NOT sent"
+  };
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    _scheduled_during_sync.clear();
+  }
+  // A replica could return a schedule older than the one just made through another instance
+  userver::storages::postgres::ResultSet
+      schedules_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster, schedules_query);
+  size_t added = 0;
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  for (auto row : schedules_res) {
+    const auto batch_id = row["batch_id"].As<boost::uuids::uuid>();
+    const auto scheduled_at = row["scheduled_at"].As<int64_t>();
+    // The schedule written through this instance after the query started is newer than the one read
+    if (_scheduled_during_sync.count(batch_id) != 0) {
+      continue;
+    }
+    const auto schedule_it = _schedules.find(batch_id);
+    if (schedule_it == _schedules.end() or schedule_it->second != scheduled_at) {
+      AddSchedule(batch_id, scheduled_at);
+      ++added;
+    }
+  }
+  if (added != 0) {
+    LOG_INFO() << "Loaded " << added << " batch schedules, pending=" << _wheel.Size();
+  }
+}
+
+void ens::notifications::BatchScheduler::Fire(const Schedule &schedule) {
+  // The batch is sent by the instance whose claim clears the schedule, the others find it claimed
+  const int64_t delay_ms = NowMs() - schedule.scheduled_at;
+  try {
+    if (_notifications_manager.SendScheduledBatch(schedule.batch_id, schedule.scheduled_at)) {
+      LOG_INFO() << "Sent scheduled batch, batch_id=" << boost::uuids::to_string(schedule.batch_id)
+                 << ", delay_ms=" << delay_ms;
+    }
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error sending scheduled batch, batch_id=" << boost::uuids::to_string(schedule.batch_id)
+                << ": " << e.what();
+  }
+}
+
+void ens::notifications::BatchScheduler::Resume(const UnfinishedBatch &batch) {
+  try {
+    _notifications_manager.ResumeBatch(batch);
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error resuming batch dispatch, batch_id=" << boost::uuids::to_string(batch.batch_id)
+                << ": " << e.what();
+  }
+}
+
+void ens::notifications::AppendBatchScheduler(userver::components::ComponentList &component_list) {
+  component_list.Append<BatchScheduler>();
+}
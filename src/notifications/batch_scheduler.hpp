@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/concurrent/background_task_storage.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/logging/level.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "utils/utils.hpp"
+#include "notifications/dispatch_journal.hpp"
+#include "notifications/notifications.hpp"
+#include "notifications/timing_wheel.hpp"
+
+namespace ens::notifications {
+// Component sending the batches at their scheduled time. Schedules are persisted in Postgres
+// and kept in a timing wheel, the ones missed while the service was down are sent on start
+// along with the rest of the dispatches interrupted by the restart
+class BatchScheduler : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "batch-scheduler";
+  static constexpr std::chrono::milliseconds kDefaultTick{10};
+  static constexpr std::chrono::milliseconds kDefaultSyncPeriod{60000};
+  BatchScheduler(const userver::components::ComponentConfig &config,
+                 const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _pg_cluster(
+          component_context
+              .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
+              .GetCluster()),
+      _notifications_manager(component_context.FindComponent<NotificationsManager>()),
+      _tick(config["tick"].As<std::chrono::milliseconds>(kDefaultTick)),
+      _wheel(_tick.count(), NowMs()) {
+    // Ticks are frequent, their spans are only logged at the trace level
+    _tick_task.Start("batch-scheduler-tick",
+                     {_tick, {userver::utils::PeriodicTask::Flags::kStrong}, userver::logging::Level::kTrace},
+                     [this] { Tick(); });
+    // Dispatches interrupted by the previous run are finished first
+    for (UnfinishedBatch &batch : component_context.FindComponent<DispatchJournal>().TakeUnfinished()) {
+      _send_tasks.AsyncDetach("batch-resume", [this, batch = std::move(batch)] { Resume(batch); });
+    }
+    // The first sync loads the schedules missed while the service was down
+    _sync_task.Start("batch-scheduler-sync",
+                     {config["sync-period"].As<std::chrono::milliseconds>(kDefaultSyncPeriod),
+                      {userver::utils::PeriodicTask::Flags::kNow}},
+                     [this] { Sync(); });
+  }
+  ~BatchScheduler() override {
+    _sync_task.Stop();
+    _tick_task.Stop();
+    _send_tasks.CancelAndWait();
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Schedules the batch to be sent at scheduled_at (Unix time in milliseconds), nullopt cancels the schedule
+  void ScheduleBatch(const boost::uuids::uuid &user_id,
+                     const boost::uuids::uuid &batch_id,
+                     const std::optional<int64_t> &scheduled_at);
+ private:
+  struct Schedule {
+    boost::uuids::uuid batch_id;
+    int64_t scheduled_at;
+  };
+  static int64_t NowMs();
+  void AddSchedule(const boost::uuids::uuid &batch_id, int64_t scheduled_at);
+  void Tick();
+  // Loads the schedules made by the other instances of the service
+  void Sync();
+  void Fire(const Schedule &schedule);
+  void Resume(const UnfinishedBatch &batch);
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  NotificationsManager &_notifications_manager;
+  const std::chrono::milliseconds _tick;
+  userver::engine::Mutex _mutex;
+  TimingWheel<Schedule> _wheel;
+  // Current time of every pending schedule, the wheel entries of the changed schedules are skipped when expired
+  std::unordered_map<boost::uuids::uuid, int64_t, boost::hash<boost::uuids::uuid>> _schedules;
+  // Batches scheduled through this instance since the current sync started, the sync may read their older schedules
+  std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>> _scheduled_during_sync;
+  userver::concurrent::BackgroundTaskStorage _send_tasks;
+  userver::utils::PeriodicTask _tick_task;
+  userver::utils::PeriodicTask _sync_task;
+};
+
+void AppendBatchScheduler(userver::components::ComponentList &component_list);
+
+class IncorrectScheduleException : public std::exception {
+ private:
+  static constexpr std::string_view FORMAT{"Incorrect batch schedule scheduled_at={}"};
+  const std::string _msg;
+ public:
+  IncorrectScheduleException(const std::string &scheduled_at) : _msg(fmt::format(this->FORMAT, scheduled_at)) {};
+  [[nodiscard]] const char *what() const
+  noexcept override { return this->_msg.c_str(); };
+};
+}
@@ -0,0 +1,145 @@
+#include "circuit_breaker.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <userver/logging/log.hpp>
+
+ens::notifications::CircuitBreakerSettings ens::notifications::ParseCircuitBreakerSettings(const userver::yaml_config::YamlConfig &config) {
+  return {config["window"].As<std::chrono::milliseconds>(std::chrono::seconds{10}),
+          config["min-calls"].As<size_t>(20),
+          config["failure-rate-threshold"].As<double>(0.5),
+          config["slow-call-duration"].As<std::chrono::milliseconds>(std::chrono::seconds{2}),
+          config["slow-call-rate-threshold"].As<double>(0.8),
+          config["open-duration"].As<std::chrono::milliseconds>(std::chrono::seconds{30}),
+          config["half-open-probes"].As<size_t>(3)};
+}
+
+ens::notifications::CircuitBreaker::CircuitBreaker(std::string name, const CircuitBreakerSettings &settings)
+    : _name(std::move(name)),
+      _settings(settings),
+      _bucket_duration(std::max<std::chrono::steady_clock::duration>(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(settings.window) / kBucketsCount,
+          std::chrono::milliseconds{1})) {}
+
+std::optional<ens::notifications::CircuitBreaker::Call> ens::notifications::CircuitBreaker::AllowCall() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  UpdateState(std::chrono::steady_clock::now());
+  switch (_state) {
+    case State::Closed: {
+      return Call{_generation};
+    }
+    case State::Open: {
+      return std::nullopt;
+    }
+    case State::HalfOpen: {
+      if (_probes_taken >= _settings.half_open_probes) {
+        return std::nullopt;
+      }
+      ++_probes_taken;
+      return Call{_generation};
+    }
+  }
+  return std::nullopt;
+}
+
+bool ens::notifications::CircuitBreaker::IsAvailable() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  UpdateState(std::chrono::steady_clock::now());
+  return _state != State::Open;
+}
+
+void ens::notifications::CircuitBreaker::RecordSuccess(const Call &call, std::chrono::steady_clock::duration latency) {
+  RecordCall(call, false, latency >= _settings.slow_call_duration);
+}
+
+void ens::notifications::CircuitBreaker::RecordFailure(const Call &call) {
+  RecordCall(call, true, false);
+}
+
+ens::notifications::CircuitBreaker::State ens::notifications::CircuitBreaker::GetState() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  UpdateState(std::chrono::steady_clock::now());
+  return _state;
+}
+
+void ens::notifications::CircuitBreaker::RecordCall(const Call &call, bool failed, bool slow) {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  const auto now = std::chrono::steady_clock::now();
+  UpdateState(now);
+  // Outcome of a call allowed in an earlier state, such as one made before the breaker opened
+  if (call.generation != _generation) {
+    return;
+  }
+  switch (_state) {
+    case State::Open: {
+      return;
+    }
+    case State::HalfOpen: {
+      if (failed or slow) {
+        LOG_WARNING() << "Circuit breaker probe failed, name=" << _name;
+        Open(now);
+      } else if (++_probes_succeeded >= _settings.half_open_probes) {
+        Close();
+      }
+      return;
+    }
+    case State::Closed: {
+      break;
+    }
+  }
+  Bucket &current = CurrentBucket(now);
+  ++current.calls;
+  current.failures += failed;
+  current.slow_calls += slow;
+  size_t calls = 0;
+  size_t failures = 0;
+  size_t slow_calls = 0;
+  for (const Bucket &bucket : _buckets) {
+    if (bucket.index > current.index - static_cast<int64_t>(kBucketsCount)) {
+      calls += bucket.calls;
+      failures += bucket.failures;
+      slow_calls += bucket.slow_calls;
+    }
+  }
+  if (calls < _settings.min_calls) {
+    return;
+  }
+  if (failures >= _settings.failure_rate_threshold * calls
+      or slow_calls >= _settings.slow_call_rate_threshold * calls) {
+    LOG_WARNING() << "Circuit breaker opened, name=" << _name << ", calls=" << calls
+                  << ", failures=" << failures << ", slow_calls=" << slow_calls;
+    Open(now);
+  }
+}
+
+void ens::notifications::CircuitBreaker::UpdateState(std::chrono::steady_clock::time_point now) {
+  if (_state == State::Open and now - _opened_at >= _settings.open_duration) {
+    _state = State::HalfOpen;
+    ++_generation;
+    _probes_taken = 0;
+    _probes_succeeded = 0;
+  }
+}
+
+void ens::notifications::CircuitBreaker::Open(std::chrono::steady_clock::time_point now) {
+  _state = State::Open;
+  ++_generation;
+  _opened_at = now;
+}
+
+void ens::notifications::CircuitBreaker::Close() {
+  LOG_INFO() << "Circuit breaker closed, name=" << _name;
+  _state = State::Closed;
+  ++_generation;
+  _buckets.fill(Bucket{});
+}
+
+ens::notifications::CircuitBreaker::Bucket &ens::notifications::CircuitBreaker::CurrentBucket(std::chrono::steady_clock::time_point now) {
+  const int64_t index = now.time_since_epoch() / _bucket_duration;
+  Bucket &bucket = _buckets[index % kBucketsCount];
+  if (bucket.index != index) {
+    bucket = Bucket{index};
+  }
+  return bucket;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include <userver/engine/mutex.hpp>
+#include <userver/yaml_config/yaml_config.hpp>
+
+namespace ens::notifications {
+struct CircuitBreakerSettings {
+  // Calls older than the window don't affect the state
+  std::chrono::milliseconds window;
+  // The breaker doesn't open until the window holds this many calls
+  size_t min_calls;
+  double failure_rate_threshold;
+  // Successful calls slower than this are counted as slow
+  std::chrono::milliseconds slow_call_duration;
+  double slow_call_rate_threshold;
+  std::chrono::milliseconds open_duration;
+  // Number of successful trial calls closing a half-open breaker
+  size_t half_open_probes;
+};
+
+CircuitBreakerSettings ParseCircuitBreakerSettings(const userver::yaml_config::YamlConfig &config);
+
+// Stops the calls to a provider whose recent calls mostly fail or are slow, after the open duration
+// a few probe calls are let through to find out whether the provider has recovered
+class CircuitBreaker {
+ public:
+  enum class State {
+    Closed,
+    Open,
+    HalfOpen
+  };
+  // Call let through by the breaker. Its outcome is ignored once the breaker has left the state the call was
+  // allowed in, so that the calls made before the breaker opened aren't taken for the probes
+  struct Call {
+    uint64_t generation;
+  };
+  CircuitBreaker(std::string name, const CircuitBreakerSettings &settings);
+  // nullopt if no call may be made now, takes one of the probes of a half-open breaker
+  std::optional<Call> AllowCall();
+  // Whether the calls are expected to be allowed, doesn't take the probes
+  bool IsAvailable();
+  void RecordSuccess(const Call &call, std::chrono::steady_clock::duration latency);
+  void RecordFailure(const Call &call);
+  State GetState();
+ private:
+  static constexpr size_t kBucketsCount = 10;
+  struct Bucket {
+    int64_t index = -1;
+    size_t calls = 0;
+    size_t failures = 0;
+    size_t slow_calls = 0;
+  };
+  void RecordCall(const Call &call, bool failed, bool slow);
+  void UpdateState(std::chrono::steady_clock::time_point now);
+  void Open(std::chrono::steady_clock::time_point now);
+  void Close();
+  Bucket &CurrentBucket(std::chrono::steady_clock::time_point now);
+  const std::string _name;
+  const CircuitBreakerSettings _settings;
+  const std::chrono::steady_clock::duration _bucket_duration;
+  userver::engine::Mutex _mutex;
+  State _state = State::Closed;
+  // Incremented on every change of the state
+  uint64_t _generation = 0;
+  std::chrono::steady_clock::time_point _opened_at{};
+  size_t _probes_taken = 0;
+  size_t _probes_succeeded = 0;
+  std::array<Bucket, kBucketsCount> _buckets{};
+};
+}
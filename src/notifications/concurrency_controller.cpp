@@ -0,0 +1,79 @@
+#include "concurrency_controller.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+ens::notifications::ConcurrencyControllerSettings ens::notifications::ParseConcurrencyControllerSettings(
+    const userver::yaml_config::YamlConfig &config,
+    size_t max_limit) {
+  const auto min_limit = std::min(config["min-limit"].As<size_t>(1), max_limit);
+  return {std::clamp(config["initial-limit"].As<size_t>(16), min_limit, max_limit),
+          min_limit,
+          max_limit,
+          config["enabled"].As<bool>(true),
+          config["backoff"].As<double>(0.7),
+          config["latency-tolerance"].As<double>(2.0)};
+}
+
+ens::notifications::ConcurrencyController::ConcurrencyController(const ConcurrencyControllerSettings &settings)
+    : _settings(settings),
+      _limit(static_cast<double>(settings.enabled ? settings.initial_limit : settings.max_limit)),
+      _period_started_at(std::chrono::steady_clock::now()),
+      _current_limit(settings.enabled ? settings.initial_limit : settings.max_limit) {}
+
+size_t ens::notifications::ConcurrencyController::GetLimit() const {
+  return _current_limit.load();
+}
+
+uint64_t ens::notifications::ConcurrencyController::GetDecreases() const {
+  return _decreases.load();
+}
+
+void ens::notifications::ConcurrencyController::RecordSuccess(std::chrono::steady_clock::duration latency) {
+  if (not _settings.enabled) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _period_min = std::min(_period_min, latency);
+  if (now - _period_started_at >= kBaselinePeriod) {
+    // The baseline follows the provider when it gets slower for good
+    _baseline = _period_min;
+    _period_min = std::chrono::steady_clock::duration::max();
+    _period_started_at = now;
+  }
+  const auto baseline = std::min(_baseline, _period_min);
+  if (latency > std::chrono::duration_cast<std::chrono::steady_clock::duration>(baseline * _settings.latency_tolerance)) {
+    Decrease(now);
+    return;
+  }
+  _limit = std::min(static_cast<double>(_settings.max_limit), _limit + 1.0 / _limit);
+  Publish();
+}
+
+void ens::notifications::ConcurrencyController::RecordOverload() {
+  if (not _settings.enabled) {
+    return;
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  Decrease(std::chrono::steady_clock::now());
+}
+
+void ens::notifications::ConcurrencyController::Decrease(std::chrono::steady_clock::time_point now) {
+  const auto baseline = std::min(_baseline, _period_min);
+  const auto cooldown = baseline == std::chrono::steady_clock::duration::max()
+                        ? std::chrono::steady_clock::duration{std::chrono::seconds{1}}
+                        : std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            baseline * _settings.latency_tolerance);
+  if (now - _last_decrease_at < cooldown) {
+    return;
+  }
+  _last_decrease_at = now;
+  _limit = std::max(static_cast<double>(_settings.min_limit), _limit * _settings.backoff);
+  ++_decreases;
+  Publish();
+}
+
+void ens::notifications::ConcurrencyController::Publish() {
+  _current_limit = static_cast<size_t>(_limit);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <userver/engine/mutex.hpp>
+#include <userver/yaml_config/yaml_config.hpp>
+
+namespace ens::notifications {
+struct ConcurrencyControllerSettings {
+  size_t initial_limit;
+  size_t min_limit;
+  // Fixed limit of the sends awaiting the reply if the controller is disabled
+  size_t max_limit;
+  bool enabled;
+  // Share of the limit kept after an overload
+  double backoff;
+  // Replies slower than the baseline latency times the tolerance are taken as a sign of an overload
+  double latency_tolerance;
+};
+
+ConcurrencyControllerSettings ParseConcurrencyControllerSettings(const userver::yaml_config::YamlConfig &config,
+                                                                 size_t max_limit);
+
+// Adjusts the number of the sends awaiting the reply at the same time by AIMD: every timely reply adds
+// about one send per round trip, a throttled, failed or slow reply cuts the limit by the backoff.
+// The baseline latency is the fastest reply of the recent period
+class ConcurrencyController {
+ public:
+  explicit ConcurrencyController(const ConcurrencyControllerSettings &settings);
+  size_t GetLimit() const;
+  uint64_t GetDecreases() const;
+  void RecordSuccess(std::chrono::steady_clock::duration latency);
+  // Rate limited, server errors and timeouts
+  void RecordOverload();
+ private:
+  static constexpr std::chrono::seconds kBaselinePeriod{30};
+  // Called under the lock
+  void Decrease(std::chrono::steady_clock::time_point now);
+  void Publish();
+  const ConcurrencyControllerSettings _settings;
+  userver::engine::Mutex _mutex;
+  double _limit;
+  std::chrono::steady_clock::duration _baseline = std::chrono::steady_clock::duration::max();
+  std::chrono::steady_clock::duration _period_min = std::chrono::steady_clock::duration::max();
+  std::chrono::steady_clock::time_point _period_started_at;
+  // The replies of the sends made before a decrease don't cut the limit again
+  std::chrono::steady_clock::time_point _last_decrease_at{};
+  std::atomic<size_t> _current_limit;
+  std::atomic<uint64_t> _decreases{0};
+};
+}
@@ -0,0 +1,354 @@
+#include "dispatch_journal.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+namespace {
+std::array<uint8_t, 16> ToBytes(const boost::uuids::uuid &uuid) {
+  std::array<uint8_t, 16> bytes{};
+  std::copy(uuid.begin(), uuid.end(), bytes.begin());
+  return bytes;
+}
+
+boost::uuids::uuid FromBytes(const std::array<uint8_t, 16> &bytes) {
+  boost::uuids::uuid uuid{};
+  std::copy(bytes.cbegin(), bytes.cend(), uuid.begin());
+  return uuid;
+}
+}
+
+userver::yaml_config::Schema ens::notifications::DispatchJournal::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component keeping a local journal of the batch dispatches to resume them after a restart
+    additionalProperties: false
+    properties:
+        path:
+            type: string
+            description: Journal file
+            defaultDescription: the journal is disabled
+        capacity:
+            type: integer
+            description: Size of the journal file in bytes, every journaled notification takes 80 bytes in one of its two halves
+            defaultDescription: 67108864
+            minimum: 4096
+        sync-interval:
+            type: string
+            description: Period of syncing the journal to the disk, the notifications accepted in the last period may be sent again after a crash of the host
+            defaultDescription: 50ms
+        fs-task-processor:
+            type: string
+            description: Task processor for the journal file access
+            defaultDescription: fs-task-processor
+  )");
+}
+
+uint32_t ens::notifications::DispatchJournal::ComputeChecksum(Record record) {
+  // FNV-1a over the record with the checksum field zeroed
+  record.checksum = 0;
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&record);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(Record); ++i) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+void ens::notifications::DispatchJournal::Open(size_t capacity) {
+  userver::utils::Async(_fs_task_processor, "dispatch-journal-open", [this, capacity] {
+    _fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_fd < 0) {
+      throw std::system_error{errno, std::generic_category(), "Error opening dispatch journal " + _path};
+    }
+    struct stat file_stat{};
+    if (::fstat(_fd, &file_stat) != 0) {
+      throw std::system_error{errno, std::generic_category(), "Error reading dispatch journal size"};
+    }
+    // A journal made with a larger capacity is kept whole, so that its records are recovered
+    _capacity = std::max(capacity, static_cast<size_t>(file_stat.st_size)) / (2 * sizeof(Record)) * (2 * sizeof(Record));
+    _region_capacity = _capacity / 2;
+    if (static_cast<size_t>(file_stat.st_size) < _capacity and ::ftruncate(_fd, static_cast<off_t>(_capacity)) != 0) {
+      throw std::system_error{errno, std::generic_category(), "Error resizing dispatch journal"};
+    }
+    void *data = ::mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+      throw std::system_error{errno, std::generic_category(), "Error mapping dispatch journal"};
+    }
+    _data = static_cast<char *>(data);
+  }).Get();
+}
+
+void ens::notifications::DispatchJournal::Close() {
+  userver::utils::Async(_fs_task_processor, "dispatch-journal-close", [this] {
+    ::munmap(_data, _capacity);
+    ::close(_fd);
+  }).Get();
+}
+
+void ens::notifications::DispatchJournal::Recover() {
+  // The region sealed with the latest epoch is current, the other one may hold a copy cut short by a crash
+  std::optional<size_t> region_begin;
+  for (const size_t begin : {size_t{0}, _region_capacity}) {
+    Record seal{};
+    std::memcpy(&seal, _data + begin, sizeof(Record));
+    if (seal.kind == RecordKind::kSeal and seal.checksum == ComputeChecksum(seal)
+        and (not region_begin.has_value() or seal.epoch > _epoch)) {
+      region_begin = begin;
+      _epoch = seal.epoch;
+    }
+  }
+  // A journal without a sealed region starts over, the first compaction seals the first region
+  _region_begin = region_begin.value_or(_region_capacity);
+  // A copy cut short before its seal has left the records of a later epoch in the other region,
+  // the epochs of the next copies follow it so that these records are never taken for theirs
+  Record copied{};
+  std::memcpy(&copied, _data + (_region_begin == 0 ? _region_capacity : 0) + sizeof(Record), sizeof(Record));
+  const uint32_t copied_epoch = copied.kind != RecordKind::kEmpty and copied.checksum == ComputeChecksum(copied)
+                                ? copied.epoch
+                                : 0;
+  std::vector<boost::uuids::uuid> order;
+  std::unordered_map<boost::uuids::uuid, UnfinishedBatch, boost::hash<boost::uuids::uuid>> batches;
+  size_t offset = sizeof(Record);
+  for (; region_begin.has_value() and offset + sizeof(Record) <= _region_capacity; offset += sizeof(Record)) {
+    Record record{};
+    std::memcpy(&record, _data + _region_begin + offset, sizeof(Record));
+    if (record.kind == RecordKind::kEmpty or record.kind == RecordKind::kSeal
+        or record.checksum != ComputeChecksum(record) or record.epoch != _epoch) {
+      break;
+    }
+    const boost::uuids::uuid batch_id = FromBytes(record.batch_id);
+    switch (record.kind) {
+      case RecordKind::kBegin: {
+        if (batches.find(batch_id) == batches.end()) {
+          order.push_back(batch_id);
+        }
+        batches[batch_id] = {batch_id,
+                             {static_cast<BatchPriority>(record.lane),
+                              FromBytes(record.id),
+                              static_cast<TenantTier>(record.tier)},
+                             {}};
+        break;
+      }
+      case RecordKind::kAck: {
+        const auto batch_it = batches.find(batch_id);
+        if (batch_it == batches.end()) {
+          break;
+        }
+        const boost::uuids::uuid recipient_id = FromBytes(record.recipient_id);
+        batch_it->second.delivered.push_back({FromBytes(record.id),
+                                              recipient_id.is_nil() ? std::nullopt
+                                                                    : std::optional<boost::uuids::uuid>{recipient_id},
+                                              FromBytes(record.group_id),
+                                              static_cast<schemas::Notification::Type>(record.channel)});
+        break;
+      }
+      case RecordKind::kFinish: {
+        batches.erase(batch_id);
+        break;
+      }
+      case RecordKind::kEmpty:
+      case RecordKind::kSeal: {
+        break;
+      }
+    }
+  }
+  _size = offset;
+  _epoch = std::max(_epoch, copied_epoch);
+  for (const boost::uuids::uuid &batch_id : order) {
+    const auto batch_it = batches.find(batch_id);
+    if (batch_it != batches.end()) {
+      _active.insert(batch_id);
+      _unfinished.push_back(std::move(batch_it->second));
+      batches.erase(batch_it);
+    }
+  }
+  if (not _unfinished.empty()) {
+    LOG_WARNING() << "Recovered " << _unfinished.size() << " unfinished batch dispatches from the journal";
+  }
+  // The records following the recovered ones may be left by an older epoch or torn, they are dropped
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  Compact();
+}
+
+void ens::notifications::DispatchJournal::Append(Record record) {
+  if (_size + sizeof(Record) > _region_capacity and _has_finished and not _unsealed) {
+    Compact();
+  }
+  if (_size + sizeof(Record) > _region_capacity) {
+    LOG_LIMITED_ERROR() << "Dispatch journal is full, the dispatch isn't journaled";
+    return;
+  }
+  record.epoch = _epoch;
+  record.checksum = ComputeChecksum(record);
+  const size_t offset = _region_begin + _size;
+  std::memcpy(_data + offset, &record, sizeof(Record));
+  _size += sizeof(Record);
+  EndRegion(offset);
+}
+
+void ens::notifications::DispatchJournal::EndRegion(size_t changed_from) {
+  size_t changed_to = _region_begin + _size;
+  if (_size + sizeof(Record) <= _region_capacity) {
+    std::memset(_data + changed_to, 0, sizeof(Record));
+    changed_to += sizeof(Record);
+  }
+  _dirty_from = std::min(_dirty_from, changed_from);
+  _dirty_to = std::max(_dirty_to, changed_to);
+}
+
+void ens::notifications::DispatchJournal::Compact() {
+  const uint32_t epoch = _epoch + 1;
+  const size_t target_begin = _region_begin == 0 ? _region_capacity : 0;
+  size_t compacted_size = sizeof(Record);
+  for (size_t offset = sizeof(Record); offset < _size; offset += sizeof(Record)) {
+    Record record{};
+    std::memcpy(&record, _data + _region_begin + offset, sizeof(Record));
+    if (_active.find(FromBytes(record.batch_id)) == _active.end()) {
+      continue;
+    }
+    record.epoch = epoch;
+    record.checksum = ComputeChecksum(record);
+    std::memcpy(_data + target_begin + compacted_size, &record, sizeof(Record));
+    compacted_size += sizeof(Record);
+  }
+  // The region the copy is made from is left intact, it is recovered until the copy is sealed
+  _region_begin = target_begin;
+  _size = compacted_size;
+  _epoch = epoch;
+  _has_finished = false;
+  _unsealed = true;
+  EndRegion(target_begin + sizeof(Record));
+}
+
+void ens::notifications::DispatchJournal::BeginBatch(const boost::uuids::uuid &batch_id, const DispatchTag &tag) {
+  if (_path.empty()) {
+    return;
+  }
+  Record record{};
+  record.kind = RecordKind::kBegin;
+  record.lane = static_cast<uint8_t>(tag.lane);
+  record.tier = static_cast<uint8_t>(tag.tier);
+  record.batch_id = ToBytes(batch_id);
+  record.id = ToBytes(tag.tenant_id);
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _active.insert(batch_id);
+  Append(record);
+}
+
+void ens::notifications::DispatchJournal::Acknowledge(const boost::uuids::uuid &batch_id,
+                                                      const std::vector<DeliveryAck> &acks) {
+  if (_path.empty() or acks.empty()) {
+    return;
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  for (const DeliveryAck &ack : acks) {
+    Record record{};
+    record.kind = RecordKind::kAck;
+    record.channel = static_cast<uint8_t>(ack.type);
+    record.batch_id = ToBytes(batch_id);
+    record.id = ToBytes(ack.notification_id);
+    record.recipient_id = ToBytes(ack.recipient_id.value_or(boost::uuids::nil_uuid()));
+    record.group_id = ToBytes(ack.group_id);
+    Append(record);
+  }
+}
+
+void ens::notifications::DispatchJournal::FinishBatch(const boost::uuids::uuid &batch_id) {
+  if (_path.empty()) {
+    return;
+  }
+  Record record{};
+  record.kind = RecordKind::kFinish;
+  record.batch_id = ToBytes(batch_id);
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _active.erase(batch_id);
+  if (_active.empty() and not _unsealed) {
+    // Nothing is left to resume, the journal starts over
+    Compact();
+    return;
+  }
+  _has_finished = true;
+  Append(record);
+}
+
+std::vector<ens::notifications::UnfinishedBatch> ens::notifications::DispatchJournal::TakeUnfinished() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  return std::move(_unfinished);
+}
+
+void ens::notifications::DispatchJournal::Sync() {
+  size_t dirty_from = 0;
+  size_t dirty_to = 0;
+  std::optional<size_t> seal_begin;
+  Record seal{};
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    if (_dirty_from >= _dirty_to and not _unsealed) {
+      return;
+    }
+    dirty_from = _dirty_from;
+    dirty_to = _dirty_to;
+    _dirty_from = _capacity;
+    _dirty_to = 0;
+    if (_unsealed) {
+      seal_begin = _region_begin;
+      seal.kind = RecordKind::kSeal;
+      seal.epoch = _epoch;
+      seal.checksum = ComputeChecksum(seal);
+    }
+  }
+  if (dirty_from < dirty_to and not SyncRange(dirty_from, dirty_to)) {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    _dirty_from = std::min(_dirty_from, dirty_from);
+    _dirty_to = std::max(_dirty_to, dirty_to);
+    return;
+  }
+  if (not seal_begin.has_value()) {
+    return;
+  }
+  // The copy is on the disk, so the seal may reach it in any order from now on. The seal slot is only written here
+  // and nothing compacts the journal again until it is sealed
+  std::memcpy(_data + seal_begin.value(), &seal, sizeof(Record));
+  if (not SyncRange(seal_begin.value(), seal_begin.value() + sizeof(Record))) {
+    return;
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _unsealed = false;
+}
+
+bool ens::notifications::DispatchJournal::SyncRange(size_t from, size_t to) {
+  // msync takes a page aligned address
+  const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  from = from / page_size * page_size;
+  try {
+    userver::utils::Async(_fs_task_processor, "dispatch-journal-msync", [this, from, to] {
+      if (::msync(_data + from, to - from, MS_SYNC) != 0) {
+        throw std::system_error{errno, std::generic_category(), "Error syncing dispatch journal"};
+      }
+    }).Get();
+    return true;
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << e.what();
+    return false;
+  }
+}
+
+void ens::notifications::AppendDispatchJournal(userver::components::ComponentList &component_list) {
+  component_list.Append<DispatchJournal>();
+}
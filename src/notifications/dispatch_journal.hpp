@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "schemas/schemas.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+
+namespace ens::notifications {
+// Notification accepted by a channel
+struct DeliveryAck {
+  boost::uuids::uuid notification_id;
+  // nullopt for a channel post delivered to the whole group
+  std::optional<boost::uuids::uuid> recipient_id;
+  boost::uuids::uuid group_id;
+  schemas::Notification::Type type;
+};
+
+// Batch whose dispatch was interrupted by a restart, along with the notifications delivered before it
+struct UnfinishedBatch {
+  boost::uuids::uuid batch_id;
+  DispatchTag tag;
+  std::vector<DeliveryAck> delivered;
+};
+
+// Component keeping a local journal of the batch dispatches in a memory-mapped file. A batch is journaled
+// when its dispatch starts, then every accepted notification and finally the end of the dispatch. Appends are
+// memory writes, the file is synced to the disk periodically. Batches left unfinished are loaded on start.
+// The file is split into two regions, the records of the unfinished batches are copied to the other one once
+// the current one fills up or all the journaled batches have finished. The appends go to the copy right away,
+// the next sync seals it once it is on the disk, so until then a crash leaves the previous region to be recovered
+class DispatchJournal : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "dispatch-journal";
+  static constexpr size_t kDefaultCapacity = 64 * 1024 * 1024;
+  static constexpr std::chrono::milliseconds kDefaultSyncInterval{50};
+  static constexpr std::string_view kDefaultFsTaskProcessor = "fs-task-processor";
+  DispatchJournal(const userver::components::ComponentConfig &config,
+                  const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _fs_task_processor(component_context.GetTaskProcessor(config["fs-task-processor"].As<std::string>(kDefaultFsTaskProcessor))),
+      _path(config["path"].As<std::string>("")) {
+    if (_path.empty()) {
+      return;
+    }
+    Open(config["capacity"].As<size_t>(kDefaultCapacity));
+    Recover();
+    _sync_task.Start("dispatch-journal-sync",
+                     {config["sync-interval"].As<std::chrono::milliseconds>(kDefaultSyncInterval)},
+                     [this] { Sync(); });
+  }
+  ~DispatchJournal() override {
+    _sync_task.Stop();
+    if (not _path.empty()) {
+      Sync();
+      Close();
+    }
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  void BeginBatch(const boost::uuids::uuid &batch_id, const DispatchTag &tag);
+  void Acknowledge(const boost::uuids::uuid &batch_id, const std::vector<DeliveryAck> &acks);
+  void FinishBatch(const boost::uuids::uuid &batch_id);
+  // Batches left unfinished by the previous run, returned once
+  std::vector<UnfinishedBatch> TakeUnfinished();
+ private:
+  enum class RecordKind : uint8_t {
+    kEmpty,
+    kBegin,
+    kAck,
+    kFinish,
+    kSeal
+  };
+  // Fixed size entry of the journal. A region starts with the seal of its epoch, the records of the epoch
+  // follow it up to the first empty, torn or older one
+  struct Record {
+    RecordKind kind;
+    uint8_t channel;
+    uint8_t lane;
+    uint8_t tier;
+    uint32_t epoch;
+    uint32_t checksum;
+    uint32_t reserved;
+    std::array<uint8_t, 16> batch_id;
+    // Master user of a begun batch, notification of an acknowledgement
+    std::array<uint8_t, 16> id;
+    // Nil for a channel post
+    std::array<uint8_t, 16> recipient_id;
+    std::array<uint8_t, 16> group_id;
+  };
+  static uint32_t ComputeChecksum(Record record);
+  void Open(size_t capacity);
+  void Close();
+  void Recover();
+  // Called under the lock
+  void Append(Record record);
+  // Copies the records of the unfinished batches to the other region under a new epoch and makes it current,
+  // called under the lock. The copy isn't synced, the next sync seals it
+  void Compact();
+  // Writes an empty record after the last one, so that the records left by an older copy aren't read after it.
+  // Called under the lock
+  void EndRegion(size_t changed_from);
+  void Sync();
+  // Returns false if the range couldn't be synced
+  bool SyncRange(size_t from, size_t to);
+  userver::engine::TaskProcessor &_fs_task_processor;
+  const std::string _path;
+  int _fd = -1;
+  char *_data = nullptr;
+  size_t _capacity = 0;
+  size_t _region_capacity = 0;
+  userver::engine::Mutex _mutex;
+  // Offset of the current region in the file, the size of its part in use including the seal
+  size_t _region_begin = 0;
+  size_t _size = 0;
+  uint32_t _epoch = 0;
+  // Range of the file changed since the last sync
+  size_t _dirty_from = 0;
+  size_t _dirty_to = 0;
+  std::unordered_set<boost::uuids::uuid, boost::hash<boost::uuids::uuid>> _active;
+  // Whether a compaction would drop the records of a finished batch
+  bool _has_finished = false;
+  // Whether the current region is still to be sealed, the previous one is recovered until then
+  bool _unsealed = false;
+  std::vector<UnfinishedBatch> _unfinished;
+  userver::utils::PeriodicTask _sync_task;
+};
+
+void AppendDispatchJournal(userver::components::ComponentList &component_list);
+}
@@ -0,0 +1,246 @@
+#include "dispatch_scheduler.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <userver/yaml_config/merge_schemas.hpp>
+
+std::string_view ens::notifications::ToString(BatchPriority priority) {
+  return kBatchPriorityMapping.TryFindByFirst(priority).value();
+}
+
+std::optional<ens::notifications::BatchPriority> ens::notifications::BatchPriorityFromString(std::string_view value) {
+  return kBatchPriorityMapping.TryFindBySecond(value);
+}
+
+userver::yaml_config::Schema ens::notifications::DispatchScheduler::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component ordering the sends of the batches by their priority lanes
+    additionalProperties: false
+    properties:
+        mode:
+            type: string
+            description: strict to serve a lane only when the more urgent lanes are empty, weighted to share the channels between the lanes
+            defaultDescription: weighted
+            enum:
+              - strict
+              - weighted
+        emergency-weight:
+            type: integer
+            description: Share of the Emergency lane in the weighted mode
+            defaultDescription: 16
+            minimum: 1
+        high-weight:
+            type: integer
+            description: Share of the High lane in the weighted mode
+            defaultDescription: 4
+            minimum: 1
+        routine-weight:
+            type: integer
+            description: Share of the Routine lane in the weighted mode
+            defaultDescription: 1
+            minimum: 1
+        basic-tier-weight:
+            type: integer
+            description: Sends granted in a turn to a tenant of the Basic tier while the other tenants wait in the same lane
+            defaultDescription: 1
+            minimum: 1
+        standard-tier-weight:
+            type: integer
+            description: Sends granted in a turn to a tenant of the Standard tier while the other tenants wait in the same lane
+            defaultDescription: 2
+            minimum: 1
+        premium-tier-weight:
+            type: integer
+            description: Sends granted in a turn to a tenant of the Premium tier while the other tenants wait in the same lane
+            defaultDescription: 4
+            minimum: 1
+  )");
+}
+
+bool ens::notifications::DispatchScheduler::IsStrict() const {
+  return _strict;
+}
+
+int64_t ens::notifications::DispatchScheduler::GetWeight(size_t lane) const {
+  return _weights.at(lane);
+}
+
+int64_t ens::notifications::DispatchScheduler::GetTierWeight(TenantTier tier) const {
+  return _tier_weights.at(static_cast<size_t>(tier));
+}
+
+void ens::notifications::DispatchScheduler::AccountWait(BatchPriority lane, std::chrono::steady_clock::duration wait) {
+  LaneStatistics &statistics = _lane_statistics[static_cast<size_t>(lane)];
+  ++statistics.grants;
+  statistics.wait_ms.GetCurrentCounter().Account(
+      std::chrono::duration_cast<std::chrono::milliseconds>(wait).count());
+}
+
+void ens::notifications::DispatchScheduler::WriteStatistics(userver::utils::statistics::Writer &writer) const {
+  for (size_t lane = 0; lane < kLanesCount; ++lane) {
+    const LaneStatistics &statistics = _lane_statistics[lane];
+    const WaitPercentile wait_ms = statistics.wait_ms.GetStatsForPeriod();
+    const userver::utils::statistics::LabelView label{"lane", ToString(static_cast<BatchPriority>(lane))};
+    writer["grants"].ValueWithLabels(statistics.grants.load(), {label});
+    writer["wait-ms"]["p50"].ValueWithLabels(wait_ms.GetPercentile(50), {label});
+    writer["wait-ms"]["p95"].ValueWithLabels(wait_ms.GetPercentile(95), {label});
+    writer["wait-ms"]["p99"].ValueWithLabels(wait_ms.GetPercentile(99), {label});
+  }
+}
+
+void ens::notifications::AppendDispatchScheduler(userver::components::ComponentList &component_list) {
+  component_list.Append<DispatchScheduler>();
+}
+
+ens::notifications::LaneWaiters::LaneWaiters(const DispatchScheduler &scheduler) : _scheduler(scheduler) {}
+
+bool ens::notifications::LaneWaiters::Empty() const {
+  return std::all_of(_lanes.cbegin(), _lanes.cend(), [](const Lane &lane) { return lane.waiting == 0; });
+}
+
+void ens::notifications::LaneWaiters::Push(Waiter &waiter) {
+  Lane &lane = _lanes[static_cast<size_t>(waiter.tag.lane)];
+  const auto [queue_it, inserted] = lane.tenants.try_emplace(waiter.tag.tenant_id);
+  if (inserted) {
+    lane.active_tenants.push_back(waiter.tag.tenant_id);
+  }
+  queue_it->second.waiters.push_back(&waiter);
+  ++lane.waiting;
+}
+
+void ens::notifications::LaneWaiters::Remove(Waiter &waiter) {
+  Lane &lane = _lanes[static_cast<size_t>(waiter.tag.lane)];
+  const auto queue_it = lane.tenants.find(waiter.tag.tenant_id);
+  if (queue_it == lane.tenants.end()) {
+    return;
+  }
+  std::deque<Waiter *> &waiters = queue_it->second.waiters;
+  const auto removed_it = std::remove(waiters.begin(), waiters.end(), &waiter);
+  lane.waiting -= static_cast<size_t>(waiters.end() - removed_it);
+  waiters.erase(removed_it, waiters.end());
+  if (waiters.empty()) {
+    lane.tenants.erase(queue_it);
+    lane.active_tenants.erase(std::remove(lane.active_tenants.begin(), lane.active_tenants.end(), waiter.tag.tenant_id),
+                              lane.active_tenants.end());
+  }
+}
+
+ens::notifications::LaneWaiters::Waiter *ens::notifications::LaneWaiters::PopNext() {
+  std::optional<size_t> next_lane;
+  if (_scheduler.IsStrict()) {
+    for (size_t lane = 0; lane < kLanesCount and not next_lane.has_value(); ++lane) {
+      if (_lanes[lane].waiting > 0) {
+        next_lane = lane;
+      }
+    }
+  } else {
+    // Every non-empty lane earns its weight, the richest one is served and pays the total
+    int64_t total_weight = 0;
+    for (size_t lane = 0; lane < kLanesCount; ++lane) {
+      if (_lanes[lane].waiting == 0) {
+        continue;
+      }
+      _credits[lane] += _scheduler.GetWeight(lane);
+      total_weight += _scheduler.GetWeight(lane);
+      if (not next_lane.has_value() or _credits[lane] > _credits[next_lane.value()]) {
+        next_lane = lane;
+      }
+    }
+    if (next_lane.has_value()) {
+      _credits[next_lane.value()] -= total_weight;
+    }
+  }
+  if (not next_lane.has_value()) {
+    return nullptr;
+  }
+  Waiter *waiter = PopFromLane(_lanes[next_lane.value()]);
+  // Idle lanes don't accumulate credits
+  for (size_t lane = 0; lane < kLanesCount; ++lane) {
+    if (_lanes[lane].waiting == 0 and lane != next_lane.value()) {
+      _credits[lane] = 0;
+    }
+  }
+  return waiter;
+}
+
+ens::notifications::LaneWaiters::Waiter *ens::notifications::LaneWaiters::PopFromLane(Lane &lane) {
+  while (true) {
+    const boost::uuids::uuid tenant_id = lane.active_tenants.front();
+    TenantQueue &queue = lane.tenants.at(tenant_id);
+    if (queue.waiters.empty()) {
+      // The tenant has nothing to send when its turn comes again, an idle tenant doesn't save up its deficit
+      lane.tenants.erase(tenant_id);
+      lane.active_tenants.pop_front();
+      continue;
+    }
+    Waiter *waiter = queue.waiters.front();
+    queue.waiters.pop_front();
+    --lane.waiting;
+    // The tenant starting its turn gets the quantum of its tier, every grant costs a single send
+    if (queue.deficit == 0) {
+      queue.deficit = _scheduler.GetTierWeight(waiter->tag.tier);
+    }
+    --queue.deficit;
+    if (queue.deficit == 0) {
+      lane.active_tenants.pop_front();
+      if (queue.waiters.empty()) {
+        lane.tenants.erase(tenant_id);
+      } else {
+        lane.active_tenants.push_back(tenant_id);
+      }
+    }
+    // Otherwise the turn goes on even with the queue empty, a batch sending its messages one by one
+    // queues the next one right after the grant
+    return waiter;
+  }
+}
+
+ens::notifications::LaneSemaphore::LaneSemaphore(size_t capacity, DispatchScheduler &scheduler)
+    : _scheduler(scheduler), _available(capacity), _waiters(scheduler) {}
+
+bool ens::notifications::LaneSemaphore::Acquire(const DispatchTag &tag) {
+  const auto started_at = std::chrono::steady_clock::now();
+  std::unique_lock<userver::engine::Mutex> lock(_mutex);
+  if (_available > 0 and _waiters.Empty()) {
+    --_available;
+    lock.unlock();
+    _scheduler.AccountWait(tag.lane, std::chrono::steady_clock::now() - started_at);
+    return true;
+  }
+  LaneWaiters::Waiter waiter{tag};
+  _waiters.Push(waiter);
+  if (not _cv.Wait(lock, [&waiter] { return waiter.granted; })) {
+    _waiters.Remove(waiter);
+    return false;
+  }
+  lock.unlock();
+  _scheduler.AccountWait(tag.lane, std::chrono::steady_clock::now() - started_at);
+  return true;
+}
+
+void ens::notifications::LaneSemaphore::Release() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  LaneWaiters::Waiter *next = _waiters.PopNext();
+  if (next == nullptr) {
+    ++_available;
+    return;
+  }
+  // The unit passes to the waiter directly, so that a newcomer can't take it first
+  next->granted = true;
+  _cv.NotifyAll();
+}
+
+ens::notifications::LaneSemaphoreLock::LaneSemaphoreLock(LaneSemaphore &semaphore, const DispatchTag &tag)
+    : _semaphore(semaphore), _owns_lock(semaphore.Acquire(tag)) {}
+
+ens::notifications::LaneSemaphoreLock::~LaneSemaphoreLock() {
+  if (_owns_lock) {
+    _semaphore.Release();
+  }
+}
+
+bool ens::notifications::LaneSemaphoreLock::OwnsLock() const {
+  return _owns_lock;
+}
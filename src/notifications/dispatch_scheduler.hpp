@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/io/enum_types.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/utils/statistics/percentile.hpp>
+#include <userver/utils/statistics/recentperiod.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/utils/trivial_map.hpp>
+
+namespace ens::notifications {
+// Lanes of the dispatched traffic, the lanes are listed from the most urgent one
+enum class BatchPriority {
+  kEmergency,
+  kHigh,
+  kRoutine
+};
+
+inline constexpr size_t kLanesCount = 3;
+
+inline constexpr userver::utils::TrivialBiMap kBatchPriorityMapping = [](auto selector) {
+  return selector()
+      .template Type<BatchPriority, std::string_view>()
+      .Case(BatchPriority::kEmergency, "Emergency")
+      .Case(BatchPriority::kHigh, "High")
+      .Case(BatchPriority::kRoutine, "Routine");
+};
+
+std::string_view ToString(BatchPriority priority);
+std::optional<BatchPriority> BatchPriorityFromString(std::string_view value);
+
+// Tiers of the tenants, a tier sets the share of the dispatch capacity the tenant gets while the others send too
+enum class TenantTier {
+  kBasic,
+  kStandard,
+  kPremium
+};
+
+inline constexpr size_t kTiersCount = 3;
+
+inline constexpr userver::utils::TrivialBiMap kTenantTierMapping = [](auto selector) {
+  return selector()
+      .template Type<TenantTier, std::string_view>()
+      .Case(TenantTier::kBasic, "Basic")
+      .Case(TenantTier::kStandard, "Standard")
+      .Case(TenantTier::kPremium, "Premium");
+};
+
+// Identifies the queue a send waits in: the lane of the batch and the tenant (master user) who sent it
+struct DispatchTag {
+  BatchPriority lane;
+  boost::uuids::uuid tenant_id;
+  TenantTier tier;
+};
+
+// Component holding the lanes policy shared by all the rate limits and capacity limits of the channels
+class DispatchScheduler : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "dispatch-scheduler";
+  static constexpr std::string_view kDefaultMode = "weighted";
+  static constexpr int64_t kDefaultEmergencyWeight = 16;
+  static constexpr int64_t kDefaultHighWeight = 4;
+  static constexpr int64_t kDefaultRoutineWeight = 1;
+  static constexpr int64_t kDefaultBasicTierWeight = 1;
+  static constexpr int64_t kDefaultStandardTierWeight = 2;
+  static constexpr int64_t kDefaultPremiumTierWeight = 4;
+  DispatchScheduler(const userver::components::ComponentConfig &config,
+                    const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _strict(config["mode"].As<std::string>(kDefaultMode) == "strict"),
+      _weights{config["emergency-weight"].As<int64_t>(kDefaultEmergencyWeight),
+               config["high-weight"].As<int64_t>(kDefaultHighWeight),
+               config["routine-weight"].As<int64_t>(kDefaultRoutineWeight)},
+      _tier_weights{config["basic-tier-weight"].As<int64_t>(kDefaultBasicTierWeight),
+                    config["standard-tier-weight"].As<int64_t>(kDefaultStandardTierWeight),
+                    config["premium-tier-weight"].As<int64_t>(kDefaultPremiumTierWeight)} {
+    _statistics_holder = component_context.FindComponent<userver::components::StatisticsStorage>().GetStorage()
+        .RegisterWriter("ens.dispatch-lanes", [this](userver::utils::statistics::Writer &writer) {
+          WriteStatistics(writer);
+        });
+  }
+  ~DispatchScheduler() override { _statistics_holder.Unregister(); }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Strict lanes are served only when all the more urgent lanes are empty,
+  // weighted lanes share the grants in proportion to their weights
+  bool IsStrict() const;
+  int64_t GetWeight(size_t lane) const;
+  // Number of the sends a tenant of the tier is granted in its turn of the round-robin
+  int64_t GetTierWeight(TenantTier tier) const;
+  void AccountWait(BatchPriority lane, std::chrono::steady_clock::duration wait);
+ private:
+  // Wait times are kept in milliseconds, waits up to 27.6s are told apart
+  using WaitPercentile = userver::utils::statistics::Percentile<2000, uint32_t, 256, 100>;
+  struct LaneStatistics {
+    std::atomic<uint64_t> grants{0};
+    userver::utils::statistics::RecentPeriod<WaitPercentile, WaitPercentile> wait_ms;
+  };
+  void WriteStatistics(userver::utils::statistics::Writer &writer) const;
+  const bool _strict;
+  const std::array<int64_t, kLanesCount> _weights;
+  const std::array<int64_t, kTiersCount> _tier_weights;
+  std::array<LaneStatistics, kLanesCount> _lane_statistics;
+  userver::utils::statistics::Entry _statistics_holder;
+};
+
+void AppendDispatchScheduler(userver::components::ComponentList &component_list);
+
+// Waiters for a shared resource, ordered by their lanes. Within a lane every tenant has its own queue,
+// the queues are served by deficit round-robin weighted by the tiers of the tenants, so a large batch
+// of one tenant doesn't hold back the sends of the others. Not synchronized, used under the lock of the resource
+class LaneWaiters {
+ public:
+  struct Waiter {
+    DispatchTag tag;
+    bool granted = false;
+    std::chrono::steady_clock::time_point slot{};
+  };
+  explicit LaneWaiters(const DispatchScheduler &scheduler);
+  bool Empty() const;
+  void Push(Waiter &waiter);
+  void Remove(Waiter &waiter);
+  // Pops the waiter to be served next, nullptr if there are none
+  Waiter *PopNext();
+ private:
+  struct TenantQueue {
+    std::deque<Waiter *> waiters;
+    // Sends the tenant may still be granted in its current turn
+    int64_t deficit = 0;
+  };
+  struct Lane {
+    std::unordered_map<boost::uuids::uuid, TenantQueue, boost::hash<boost::uuids::uuid>> tenants;
+    // Round-robin order of the tenants having waiters or a turn in progress
+    std::deque<boost::uuids::uuid> active_tenants;
+    size_t waiting = 0;
+  };
+  Waiter *PopFromLane(Lane &lane);
+  const DispatchScheduler &_scheduler;
+  std::array<Lane, kLanesCount> _lanes;
+  // Smooth weighted round-robin state
+  std::array<int64_t, kLanesCount> _credits{};
+};
+
+// Counting semaphore handing the freed units to the waiters of the most urgent lanes first
+class LaneSemaphore {
+ public:
+  LaneSemaphore(size_t capacity, DispatchScheduler &scheduler);
+  // Returns false if the task was cancelled while waiting
+  bool Acquire(const DispatchTag &tag);
+  void Release();
+ private:
+  DispatchScheduler &_scheduler;
+  userver::engine::Mutex _mutex;
+  userver::engine::ConditionVariable _cv;
+  size_t _available;
+  LaneWaiters _waiters;
+};
+
+class LaneSemaphoreLock {
+ public:
+  LaneSemaphoreLock(LaneSemaphore &semaphore, const DispatchTag &tag);
+  LaneSemaphoreLock(const LaneSemaphoreLock &) = delete;
+  LaneSemaphoreLock &operator=(const LaneSemaphoreLock &) = delete;
+  ~LaneSemaphoreLock();
+  bool OwnsLock() const;
+ private:
+  LaneSemaphore &_semaphore;
+  const bool _owns_lock;
+};
+}
+
+// Postgres to cpp type mappings
+namespace USERVER_NAMESPACE::storages::postgres::io {
+template<>
+struct CppToUserPg<ens::notifications::BatchPriority> {
+  static constexpr userver::storages::postgres::DBTypeName postgres_name = "ens_schema.batch_priority";
+  static constexpr userver::utils::TrivialBiMap enumerators = ens::notifications::kBatchPriorityMapping;
+};
+
+template<>
+struct CppToUserPg<ens::notifications::TenantTier> {
+  static constexpr userver::storages::postgres::DBTypeName postgres_name = "ens_schema.tenant_tier";
+  static constexpr userver::utils::TrivialBiMap enumerators = ens::notifications::kTenantTierMapping;
+};
+}
@@ -0,0 +1,247 @@
+#include "email_sender.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <unordered_set>
+
+#include <userver/crypto/base64.hpp>
+#include <userver/engine/exception.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/boost_uuid7.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+namespace {
+// Base64 lines are limited to 76 characters, RFC 2045
+constexpr size_t kBase64LineBytes = 57;
+// Encoded words are limited to 75 characters, RFC 2047
+constexpr size_t kEncodedWordBytes = 45;
+
+std::string EncodeHeader(std::string_view value) {
+  std::string encoded;
+  while (not value.empty()) {
+    size_t chunk_size = std::min(value.size(), kEncodedWordBytes);
+    // Multibyte characters can't be split between the encoded words
+    while (chunk_size < value.size() and (static_cast<unsigned char>(value[chunk_size]) & 0xC0) == 0x80) {
+      --chunk_size;
+    }
+    if (not encoded.empty()) {
+      encoded.append("\r\n ");
+    }
+    encoded.append("=?UTF-8?B?");
+    encoded.append(userver::crypto::base64::Base64Encode(value.substr(0, chunk_size)));
+    encoded.append("?=");
+    value.remove_prefix(chunk_size);
+  }
+  return encoded;
+}
+
+std::string FormatDate() {
+  const std::time_t now = std::time(nullptr);
+  std::tm now_tm{};
+  gmtime_r(&now, &now_tm);
+  char date[64];
+  const size_t date_size = std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S +0000", &now_tm);
+  return {date, date_size};
+}
+
+bool IsValidAddress(const std::string &address) {
+  return not address.empty() and address.find_first_of("\r\n<> ") == std::string::npos;
+}
+}
+
+userver::yaml_config::Schema ens::notifications::email::EmailSender::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component for email delivery through a pool of persistent SMTP sessions
+    additionalProperties: false
+    properties:
+        host:
+            type: string
+            description: SMTP server host
+            defaultDescription: email is disabled
+        port:
+            type: integer
+            description: SMTP server port
+            defaultDescription: 25
+        from-address:
+            type: string
+            description: Sender address of the notifications
+            defaultDescription: email is disabled
+        helo-name:
+            type: string
+            description: Domain name introduced to the server in EHLO
+            defaultDescription: localhost
+        starttls:
+            type: boolean
+            description: Whether the sessions are upgraded to TLS with STARTTLS
+            defaultDescription: false
+        max-connections:
+            type: integer
+            description: Maximum number of SMTP sessions opened at the same time
+            defaultDescription: 8
+            minimum: 1
+        messages-per-second:
+            type: integer
+            description: Maximum rate of messages sent through each SMTP session
+            defaultDescription: 100
+            minimum: 1
+        max-recipients-per-message:
+            type: integer
+            description: Maximum number of recipients of a single message
+            defaultDescription: 100
+            minimum: 1
+        timeout:
+            type: string
+            description: Timeout of every SMTP command
+            defaultDescription: 10s
+  )");
+}
+
+bool ens::notifications::email::EmailSender::IsEnabled() const {
+  return not _settings.host.empty() and not _from_address.empty();
+}
+
+std::vector<std::string> ens::notifications::email::EmailSender::SendBulk(const std::string &subject,
+                                                                          const std::string &body,
+                                                                          const std::vector<std::string> &recipients,
+                                                                          CircuitBreaker &breaker,
+                                                                          const DispatchTag &tag,
+                                                                          const std::function<void(const std::vector<std::string> &)> &accepted,
+                                                                          const std::function<bool()> &stopped) {
+  std::vector<std::string> failed;
+  std::vector<std::string> valid_recipients;
+  for (const std::string &recipient : recipients) {
+    if (IsValidAddress(recipient)) {
+      valid_recipients.push_back(recipient);
+    } else {
+      failed.push_back(recipient);
+    }
+  }
+  // The message is built once, every chunk of recipients gets the same copy in a single transaction
+  const std::string data = MakeMailData(subject, body);
+  std::vector<userver::engine::TaskWithResult<std::vector<std::string>>> chunk_tasks;
+  for (size_t begin = 0; begin < valid_recipients.size(); begin += _max_recipients_per_message) {
+    const size_t end = std::min(valid_recipients.size(), begin + _max_recipients_per_message);
+    std::vector<std::string> chunk(valid_recipients.begin() + begin, valid_recipients.begin() + end);
+    chunk_tasks.push_back(userver::utils::Async("email-send",
+                                                [this, &data, &breaker, tag, &accepted, &stopped, chunk = std::move(chunk)] {
+                                                  std::vector<std::string> chunk_failed = SendChunk(data, chunk, breaker, tag,
+                                                                                                    stopped);
+                                                  const std::unordered_set<std::string> failed_set(chunk_failed.cbegin(),
+                                                                                                   chunk_failed.cend());
+                                                  std::vector<std::string> chunk_accepted;
+                                                  for (const std::string &recipient : chunk) {
+                                                    if (failed_set.count(recipient) == 0) {
+                                                      chunk_accepted.push_back(recipient);
+                                                    }
+                                                  }
+                                                  accepted(chunk_accepted);
+                                                  return chunk_failed;
+                                                }));
+  }
+  for (auto &task : chunk_tasks) {
+    std::vector<std::string> chunk_failed = task.Get();
+    failed.insert(failed.end(), chunk_failed.begin(), chunk_failed.end());
+  }
+  return failed;
+}
+
+std::string ens::notifications::email::EmailSender::MakeMailData(const std::string &subject,
+                                                                 const std::string &body) const {
+  std::string data = fmt::format("From: <{}>\r\n"
+                                 "To: undisclosed-recipients:;\r\n"
+                                 "Subject: {}\r\n"
+                                 "Date: {}\r\n"
+                                 "Message-ID: <{}@{}>\r\n"
+                                 "MIME-Version: 1.0\r\n"
+                                 "Content-Type: text/plain; charset=UTF-8\r\n"
+                                 "Content-Transfer-Encoding: base64\r\n"
+                                 "\r\n",
+                                 _from_address,
+                                 EncodeHeader(subject),
+                                 FormatDate(),
+                                 boost::uuids::to_string(userver::utils::generators::GenerateBoostUuidV7()),
+                                 _settings.helo_name);
+  // Base64 lines never start with a dot, so the content needs no dot-stuffing
+  const std::string_view body_view{body};
+  for (size_t pos = 0; pos < body_view.size(); pos += kBase64LineBytes) {
+    data.append(userver::crypto::base64::Base64Encode(body_view.substr(pos, kBase64LineBytes)));
+    data.append("\r\n");
+  }
+  data.append(".\r\n");
+  return data;
+}
+
+std::vector<std::string> ens::notifications::email::EmailSender::SendChunk(const std::string &data,
+                                                                           std::vector<std::string> recipients,
+                                                                           CircuitBreaker &breaker,
+                                                                           const DispatchTag &tag,
+                                                                           const std::function<bool()> &stopped) {
+  LaneSemaphoreLock connection_lock(_connections_semaphore, tag);
+  if (not connection_lock.OwnsLock()) {
+    return recipients;
+  }
+  std::unique_ptr<SmtpConnection> connection = TakeIdleConnection();
+  std::vector<std::string> failed;
+  for (size_t attempt = 0; attempt < kMaxSendAttempts and not recipients.empty(); ++attempt) {
+    if (stopped()) {
+      break;
+    }
+    const std::optional<CircuitBreaker::Call> breaker_call = breaker.AllowCall();
+    if (not breaker_call.has_value()) {
+      break;
+    }
+    const auto started_at = std::chrono::steady_clock::now();
+    try {
+      if (not connection) {
+        connection = std::make_unique<SmtpConnection>(_settings, _resolver, _scheduler);
+      }
+      SmtpSendResult result = connection->Send(_from_address, recipients, data, tag);
+      breaker.RecordSuccess(breaker_call.value(), std::chrono::steady_clock::now() - started_at);
+      failed.insert(failed.end(), result.rejected.begin(), result.rejected.end());
+      recipients = std::move(result.deferred);
+    }
+    catch (const userver::engine::TaskCancelledException &) {
+      // The message has not been sent, the server is not to blame
+      break;
+    }
+    catch (const std::exception &e) {
+      // Idle sessions may have been closed by the server meanwhile, the transaction is retried over a new one
+      LOG_WARNING() << "Error sending email, attempt=" << attempt + 1 << ": " << e.what();
+      breaker.RecordFailure(breaker_call.value());
+      connection.reset();
+    }
+    if (connection and connection->IsBroken()) {
+      connection.reset();
+    }
+  }
+  if (not recipients.empty()) {
+    LOG_ERROR() << "Email was not delivered to " << recipients.size() << " recipients";
+    failed.insert(failed.end(), recipients.begin(), recipients.end());
+  }
+  if (connection) {
+    ReturnIdleConnection(std::move(connection));
+  }
+  return failed;
+}
+
+std::unique_ptr<ens::notifications::email::SmtpConnection> ens::notifications::email::EmailSender::TakeIdleConnection() {
+  std::lock_guard<userver::engine::Mutex> lock(_idle_connections_mutex);
+  if (_idle_connections.empty()) {
+    return nullptr;
+  }
+  std::unique_ptr<SmtpConnection> connection = std::move(_idle_connections.back());
+  _idle_connections.pop_back();
+  return connection;
+}
+
+void ens::notifications::email::EmailSender::ReturnIdleConnection(std::unique_ptr<SmtpConnection> connection) {
+  std::lock_guard<userver::engine::Mutex> lock(_idle_connections_mutex);
+  _idle_connections.push_back(std::move(connection));
+}
+
+void ens::notifications::email::AppendEmailSender(userver::components::ComponentList &component_list) {
+  component_list.Append<EmailSender>();
+}
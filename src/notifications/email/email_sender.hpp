@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <userver/clients/dns/component.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_base.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/secdist/component.hpp>
+
+#include "utils/utils.hpp"
+#include "notifications/circuit_breaker.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+#include "notifications/email/smtp_connection.hpp"
+
+namespace ens::notifications::email {
+// Component for email delivery through a pool of persistent SMTP sessions
+class EmailSender : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "email-sender";
+  static constexpr uint16_t kDefaultPort = 25;
+  static constexpr std::string_view kDefaultHeloName = "localhost";
+  static constexpr size_t kDefaultMaxConnections = 8;
+  static constexpr size_t kDefaultMessagesPerSecond = 100;
+  static constexpr size_t kDefaultMaxRecipientsPerMessage = 100;
+  static constexpr std::chrono::milliseconds kDefaultTimeout{10000};
+  static constexpr size_t kMaxSendAttempts = 3;
+  EmailSender(const userver::components::ComponentConfig &config,
+              const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _resolver(component_context.FindComponent<userver::clients::dns::Component>().GetResolver()),
+      _scheduler(component_context.FindComponent<DispatchScheduler>()),
+      _secdist_config(
+          component_context.FindComponent<userver::components::Secdist>().Get().Get<ens::utils::SmtpSecdistConfig>()
+      ),
+      _settings{config["host"].As<std::string>(""),
+                static_cast<uint16_t>(config["port"].As<int>(kDefaultPort)),
+                config["helo-name"].As<std::string>(kDefaultHeloName),
+                config["starttls"].As<bool>(false),
+                _secdist_config._username,
+                _secdist_config._password,
+                config["timeout"].As<std::chrono::milliseconds>(kDefaultTimeout),
+                config["messages-per-second"].As<size_t>(kDefaultMessagesPerSecond)},
+      _from_address(config["from-address"].As<std::string>("")),
+      _max_recipients_per_message(config["max-recipients-per-message"].As<size_t>(kDefaultMaxRecipientsPerMessage)),
+      _connections_semaphore(config["max-connections"].As<size_t>(kDefaultMaxConnections), _scheduler) {}
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Email is disabled unless the SMTP server is configured
+  bool IsEnabled() const;
+  // Sends the message to all the recipients, returns the addresses it was not delivered to.
+  // The transactions are reported to the breaker and aren't started while it is open.
+  // The addresses every transaction is accepted for are passed to accepted as soon as it ends.
+  // No transaction is started once stopped returns true, its recipients are returned
+  std::vector<std::string> SendBulk(const std::string &subject,
+                                    const std::string &body,
+                                    const std::vector<std::string> &recipients,
+                                    CircuitBreaker &breaker,
+                                    const DispatchTag &tag,
+                                    const std::function<void(const std::vector<std::string> &)> &accepted,
+                                    const std::function<bool()> &stopped);
+ private:
+  std::string MakeMailData(const std::string &subject, const std::string &body) const;
+  std::vector<std::string> SendChunk(const std::string &data,
+                                     std::vector<std::string> recipients,
+                                     CircuitBreaker &breaker,
+                                     const DispatchTag &tag,
+                                     const std::function<bool()> &stopped);
+  std::unique_ptr<SmtpConnection> TakeIdleConnection();
+  void ReturnIdleConnection(std::unique_ptr<SmtpConnection> connection);
+  userver::clients::dns::Resolver &_resolver;
+  DispatchScheduler &_scheduler;
+  const ens::utils::SmtpSecdistConfig _secdist_config;
+  const SmtpSettings _settings;
+  const std::string _from_address;
+  const size_t _max_recipients_per_message;
+  // Bounds the number of sessions opened to the server at the same time
+  LaneSemaphore _connections_semaphore;
+  userver::engine::Mutex _idle_connections_mutex;
+  std::vector<std::unique_ptr<SmtpConnection>> _idle_connections;
+};
+
+void AppendEmailSender(userver::components::ComponentList &component_list);
+}
@@ -0,0 +1,268 @@
+#include "smtp_connection.hpp"
+
+#include <charconv>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <userver/crypto/base64.hpp>
+#include <userver/engine/exception.hpp>
+#include <userver/engine/io/exception.hpp>
+#include <userver/engine/task/cancel.hpp>
+
+namespace {
+constexpr size_t kReadChunkSize = 4096;
+constexpr size_t kMaxLineLength = 64 * 1024;
+
+bool IsPositive(const ens::notifications::email::SmtpReply &reply) {
+  return reply.code >= 200 and reply.code < 400;
+}
+
+void ClassifyRecipient(const ens::notifications::email::SmtpReply &reply,
+                       const std::string &recipient,
+                       std::vector<std::string> &accepted,
+                       ens::notifications::email::SmtpSendResult &result) {
+  if (IsPositive(reply)) {
+    accepted.push_back(recipient);
+  } else if (reply.code < 500) {
+    result.deferred.push_back(recipient);
+  } else {
+    result.rejected.push_back(recipient);
+  }
+}
+}
+
+ens::notifications::email::SmtpConnection::SmtpConnection(const SmtpSettings &settings,
+                                                          userver::clients::dns::Resolver &resolver,
+                                                          DispatchScheduler &scheduler)
+    : _settings(settings), _rate_limiter(settings.messages_per_second, scheduler) {
+  Connect(resolver);
+  const SmtpReply greeting = ReadReply();
+  if (greeting.code != 220) {
+    throw SmtpException{"greeting", fmt::format("{}", greeting.code)};
+  }
+  Hello();
+  if (_settings.starttls) {
+    if (not _starttls_supported) {
+      throw SmtpException{"STARTTLS", "not supported by the server"};
+    }
+    const SmtpReply starttls_reply = Command("STARTTLS\r\n");
+    if (starttls_reply.code != 220) {
+      throw SmtpException{"STARTTLS", fmt::format("{}", starttls_reply.code)};
+    }
+    _tls.emplace(userver::engine::io::TlsWrapper::StartTlsClient(std::move(_socket), _settings.host, MakeDeadline()));
+    _read_buffer.clear();
+    _read_pos = 0;
+    // Capabilities announced before the handshake are discarded
+    Hello();
+  }
+  if (not _settings.username.empty()) {
+    Authenticate();
+  }
+}
+
+void ens::notifications::email::SmtpConnection::Connect(userver::clients::dns::Resolver &resolver) {
+  const userver::engine::Deadline deadline = MakeDeadline();
+  std::string last_error = "host is not resolved";
+  for (auto addr : resolver.Resolve(_settings.host, deadline)) {
+    addr.SetPort(_settings.port);
+    try {
+      _socket = userver::engine::io::Socket{addr.Domain(), userver::engine::io::SocketType::kStream};
+      _socket.Connect(addr, deadline);
+      return;
+    }
+    catch (const userver::engine::io::IoException &e) {
+      last_error = e.what();
+    }
+  }
+  throw SmtpException{"connection", last_error};
+}
+
+void ens::notifications::email::SmtpConnection::Hello() {
+  const SmtpReply ehlo_reply = Command(fmt::format("EHLO {}\r\n", _settings.helo_name));
+  if (ehlo_reply.code != 250) {
+    throw SmtpException{"EHLO", fmt::format("{}", ehlo_reply.code)};
+  }
+  _pipelining = false;
+  _starttls_supported = false;
+  // The first line is the server greeting, the rest are the supported extensions
+  for (size_t i = 1; i < ehlo_reply.lines.size(); ++i) {
+    const std::string keyword = boost::algorithm::to_upper_copy(ehlo_reply.lines[i].substr(0, ehlo_reply.lines[i].find(' ')));
+    if (keyword == "PIPELINING") {
+      _pipelining = true;
+    } else if (keyword == "STARTTLS") {
+      _starttls_supported = true;
+    }
+  }
+}
+
+void ens::notifications::email::SmtpConnection::Authenticate() {
+  std::string credentials;
+  credentials.push_back('\0');
+  credentials.append(_settings.username);
+  credentials.push_back('\0');
+  credentials.append(_settings.password);
+  const SmtpReply auth_reply = Command(fmt::format("AUTH PLAIN {}\r\n",
+                                                   userver::crypto::base64::Base64Encode(credentials)));
+  if (auth_reply.code != 235) {
+    throw SmtpException{"authentication", fmt::format("{}", auth_reply.code)};
+  }
+}
+
+ens::notifications::email::SmtpSendResult ens::notifications::email::SmtpConnection::Send(const std::string &from,
+                                                                                          const std::vector<std::string> &recipients,
+                                                                                          std::string_view data,
+                                                                                          const DispatchTag &tag) {
+  if (not _rate_limiter.Acquire(tag)) {
+    throw userver::engine::TaskCancelledException{userver::engine::current_task::CancellationReason()};
+  }
+  SmtpSendResult result;
+  std::vector<std::string> accepted;
+  const std::string mail_command = fmt::format("MAIL FROM:<{}>\r\n", from);
+  SmtpReply mail_reply;
+  SmtpReply data_reply;
+  if (_pipelining) {
+    // The whole envelope is sent in a single write and the replies are read back in the same order
+    std::string envelope = mail_command;
+    for (const std::string &recipient : recipients) {
+      envelope.append(fmt::format("RCPT TO:<{}>\r\n", recipient));
+    }
+    envelope.append("DATA\r\n");
+    Write(envelope);
+    mail_reply = ReadReply();
+    for (const std::string &recipient : recipients) {
+      const SmtpReply rcpt_reply = ReadReply();
+      ClassifyRecipient(IsPositive(mail_reply) ? rcpt_reply : mail_reply, recipient, accepted, result);
+    }
+    data_reply = ReadReply();
+  } else {
+    mail_reply = Command(mail_command);
+    for (const std::string &recipient : recipients) {
+      if (not IsPositive(mail_reply)) {
+        ClassifyRecipient(mail_reply, recipient, accepted, result);
+        continue;
+      }
+      ClassifyRecipient(Command(fmt::format("RCPT TO:<{}>\r\n", recipient)), recipient, accepted, result);
+    }
+    if (accepted.empty()) {
+      Reset();
+      return result;
+    }
+    data_reply = Command("DATA\r\n");
+  }
+  if (data_reply.code != 354) {
+    auto &failed = data_reply.code < 500 ? result.deferred : result.rejected;
+    failed.insert(failed.end(), accepted.begin(), accepted.end());
+    Reset();
+    return result;
+  }
+  if (accepted.empty()) {
+    // Some servers accept DATA of a transaction without recipients, the empty message is discarded
+    Write(".\r\n");
+    ReadReply();
+    Reset();
+    return result;
+  }
+  Write(data);
+  const SmtpReply final_reply = ReadReply();
+  if (not IsPositive(final_reply)) {
+    auto &failed = final_reply.code < 500 ? result.deferred : result.rejected;
+    failed.insert(failed.end(), accepted.begin(), accepted.end());
+  }
+  return result;
+}
+
+bool ens::notifications::email::SmtpConnection::IsBroken() const {
+  return _broken;
+}
+
+ens::notifications::email::SmtpReply ens::notifications::email::SmtpConnection::Command(std::string_view command) {
+  Write(command);
+  return ReadReply();
+}
+
+void ens::notifications::email::SmtpConnection::Reset() {
+  if (Command("RSET\r\n").code != 250) {
+    _broken = true;
+  }
+}
+
+void ens::notifications::email::SmtpConnection::Write(std::string_view data) {
+  size_t sent = 0;
+  try {
+    sent = Stream().WriteAll(data.data(), data.size(), MakeDeadline());
+  }
+  catch (const std::exception &e) {
+    _broken = true;
+    throw SmtpException{"write", e.what()};
+  }
+  if (sent != data.size()) {
+    _broken = true;
+    throw SmtpException{"write", "connection closed by the server"};
+  }
+}
+
+ens::notifications::email::SmtpReply ens::notifications::email::SmtpConnection::ReadReply() {
+  SmtpReply reply;
+  while (true) {
+    const std::string line = ReadLine();
+    int code = 0;
+    if (line.size() < 3 or std::from_chars(line.data(), line.data() + 3, code).ptr != line.data() + 3
+        or (line.size() > 3 and line[3] != ' ' and line[3] != '-')) {
+      _broken = true;
+      throw SmtpException{"reply", fmt::format("malformed line '{}'", line)};
+    }
+    reply.code = code;
+    reply.lines.push_back(line.size() > 4 ? line.substr(4) : std::string{});
+    if (line.size() == 3 or line[3] == ' ') {
+      break;
+    }
+  }
+  if (reply.code == 421) {
+    // The server is closing the session
+    _broken = true;
+    throw SmtpException{"session", "closed by the server"};
+  }
+  return reply;
+}
+
+std::string ens::notifications::email::SmtpConnection::ReadLine() {
+  while (true) {
+    const size_t line_end = _read_buffer.find("\r\n", _read_pos);
+    if (line_end != std::string::npos) {
+      std::string line = _read_buffer.substr(_read_pos, line_end - _read_pos);
+      _read_pos = line_end + 2;
+      return line;
+    }
+    if (_read_buffer.size() - _read_pos > kMaxLineLength) {
+      _broken = true;
+      throw SmtpException{"reply", "line is too long"};
+    }
+    _read_buffer.erase(0, _read_pos);
+    _read_pos = 0;
+    const size_t buffer_size = _read_buffer.size();
+    _read_buffer.resize(buffer_size + kReadChunkSize);
+    size_t received = 0;
+    try {
+      received = Stream().ReadSome(_read_buffer.data() + buffer_size, kReadChunkSize, MakeDeadline());
+    }
+    catch (const std::exception &e) {
+      _broken = true;
+      throw SmtpException{"read", e.what()};
+    }
+    _read_buffer.resize(buffer_size + received);
+    if (received == 0) {
+      _broken = true;
+      throw SmtpException{"read", "connection closed by the server"};
+    }
+  }
+}
+
+userver::engine::io::RwBase &ens::notifications::email::SmtpConnection::Stream() {
+  if (_tls.has_value()) {
+    return _tls.value();
+  }
+  return _socket;
+}
+
+userver::engine::Deadline ens::notifications::email::SmtpConnection::MakeDeadline() const {
+  return userver::engine::Deadline::FromDuration(_settings.timeout);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+#include <userver/clients/dns/resolver.hpp>
+#include <userver/engine/deadline.hpp>
+#include <userver/engine/io/common.hpp>
+#include <userver/engine/io/socket.hpp>
+#include <userver/engine/io/tls_wrapper.hpp>
+
+#include "notifications/dispatch_scheduler.hpp"
+#include "notifications/rate_limiter.hpp"
+
+namespace ens::notifications::email {
+struct SmtpSettings {
+  std::string host;
+  uint16_t port;
+  std::string helo_name;
+  bool starttls;
+  std::string username;
+  std::string password;
+  std::chrono::milliseconds timeout;
+  size_t messages_per_second;
+};
+
+struct SmtpReply {
+  int code = 0;
+  std::vector<std::string> lines;
+};
+
+struct SmtpSendResult {
+  // Refused by the server for good
+  std::vector<std::string> rejected;
+  // Refused temporarily (e.g. too many recipients in a transaction), worth retrying in another transaction
+  std::vector<std::string> deferred;
+};
+
+// Persistent SMTP session, every message sent through it is a separate transaction
+class SmtpConnection {
+ public:
+  SmtpConnection(const SmtpSettings &settings,
+                 userver::clients::dns::Resolver &resolver,
+                 DispatchScheduler &scheduler);
+  // Sends a single copy of the message to all the recipients,
+  // data is the dot-stuffed message content terminated with <CRLF>.<CRLF>
+  SmtpSendResult Send(const std::string &from,
+                      const std::vector<std::string> &recipients,
+                      std::string_view data,
+                      const DispatchTag &tag);
+  // The session can't be used anymore and has to be replaced with a new one
+  bool IsBroken() const;
+ private:
+  void Connect(userver::clients::dns::Resolver &resolver);
+  void Hello();
+  void Authenticate();
+  SmtpReply Command(std::string_view command);
+  void Reset();
+  void Write(std::string_view data);
+  SmtpReply ReadReply();
+  std::string ReadLine();
+  userver::engine::io::RwBase &Stream();
+  userver::engine::Deadline MakeDeadline() const;
+  const SmtpSettings &_settings;
+  userver::engine::io::Socket _socket;
+  std::optional<userver::engine::io::TlsWrapper> _tls;
+  std::string _read_buffer;
+  size_t _read_pos = 0;
+  bool _pipelining = false;
+  bool _starttls_supported = false;
+  bool _broken = false;
+  // Each session is throttled on its own, the pool size multiplies the total rate
+  SendRateLimiter _rate_limiter;
+};
+
+class SmtpException : public std::exception {
+ private:
+  static constexpr std::string_view FORMAT{"SMTP {} failed: {}"};
+  const std::string _msg;
+ public:
+  SmtpException(std::string_view stage, std::string_view reason) : _msg(fmt::format(this->FORMAT,
+                                                                                    stage,
+                                                                                    reason)) {};
+  [[nodiscard]] const char *what() const
+  noexcept override { return this->_msg.c_str(); };
+};
+}
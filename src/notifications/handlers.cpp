@@ -1,12 +1,28 @@
 #include "handlers.hpp"
 
+#include <optional>
+
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
 userver::formats::json::Value ens::notifications::NotificationCreateBatchHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
                                                                                                          const userver::formats::json::Value &,
                                                                                                          userver::server::request::RequestContext &) const {
   const std::string &access_token = request.GetHeader("Authorization");
   try {
     const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
-    const std::string batch_id = this->_notification_manager.CreateBatch(user_id);
+    BatchPriority priority = BatchPriority::kRoutine;
+    if (request.HasArg("priority")) {
+      const std::string &priority_str = request.GetArg("priority");
+      const std::optional<BatchPriority> parsed_priority = BatchPriorityFromString(priority_str);
+      if (not parsed_priority.has_value()) {
+        throw IncorrectPriorityException{priority_str};
+      }
+      priority = parsed_priority.value();
+    }
+    const std::string batch_id = this->_notification_manager.CreateBatch(user_id, priority);
     userver::formats::json::ValueBuilder vb{batch_id};
     return vb.ExtractValue();
   }
@@ -17,6 +33,14 @@ userver::formats::json::Value ens::notifications::NotificationCreateBatchHandler
         userver::server::handlers::ExternalBody{e.what()}
     };
   }
+  catch (const IncorrectPriorityException &e) {
+    throw userver::server::http::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::http::HttpStatus::kUnprocessableEntity,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
 }
 
 void ens::notifications::AppendNotificationCreateBatchHandler(userver::components::ComponentList &component_list) {
@@ -158,6 +182,255 @@ void ens::notifications::AppendNotificationSendBatchHandler(userver::components:
   component_list.Append<NotificationSendBatchHandler>();
 }
 
+userver::formats::json::Value ens::notifications::NotificationScheduleBatchHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                           const userver::formats::json::Value &,
+                                                                                                           userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid batch_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("batch_id"));
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    // Missing time cancels the schedule
+    std::optional<int64_t> scheduled_at;
+    if (request.HasArg("scheduled_at")) {
+      const std::string &scheduled_at_str = request.GetArg("scheduled_at");
+      int64_t parsed_scheduled_at = 0;
+      if (not boost::conversion::try_lexical_convert(scheduled_at_str, parsed_scheduled_at) or parsed_scheduled_at < 0) {
+        throw IncorrectScheduleException{scheduled_at_str};
+      }
+      scheduled_at = parsed_scheduled_at;
+    }
+    this->_batch_scheduler.ScheduleBatch(user_id, batch_id, scheduled_at);
+    return userver::formats::json::Value{};
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const NotificationBatchNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const IncorrectScheduleException &e) {
+    throw userver::server::http::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::http::HttpStatus::kUnprocessableEntity,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+}
+
+void ens::notifications::AppendNotificationScheduleBatchHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<NotificationScheduleBatchHandler>();
+}
+
+userver::formats::json::Value ens::notifications::NotificationGetBatchResponsesHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                               const userver::formats::json::Value &,
+                                                                                                               userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid batch_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("batch_id"));
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    const telegram::ResponseTally tally = this->_notification_manager.GetBatchResponses(user_id, batch_id);
+    userver::formats::json::ValueBuilder responses_json(userver::formats::common::Type::kObject);
+    for (size_t status = 0; status < telegram::kResponseStatusesCount; ++status) {
+      responses_json[std::string{telegram::ToString(static_cast<telegram::ResponseStatus>(status))}] = tally[status];
+    }
+    return responses_json.ExtractValue();
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const NotificationBatchNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+}
+
+void ens::notifications::AppendNotificationGetBatchResponsesHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<NotificationGetBatchResponsesHandler>();
+}
+
+userver::formats::json::Value ens::notifications::NotificationGetBatchSummaryHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                             const userver::formats::json::Value &,
+                                                                                                             userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid batch_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("batch_id"));
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    const BatchProgressSnapshot summary = this->_notification_manager.GetBatchSummary(user_id, batch_id);
+    userver::formats::json::ValueBuilder summary_json;
+    summary_json["targeted"] = summary.targeted;
+    summary_json["sent"] = summary.sent;
+    summary_json["failed"] = summary.failed;
+    summary_json["pending"] = summary.targeted - summary.sent - summary.failed;
+    summary_json["responded"] = summary.responded;
+    summary_json["finished"] = summary.finished;
+    return summary_json.ExtractValue();
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const NotificationBatchNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+}
+
+void ens::notifications::AppendNotificationGetBatchSummaryHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<NotificationGetBatchSummaryHandler>();
+}
+
+userver::yaml_config::Schema ens::notifications::NotificationBatchProgressHandler::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::server::handlers::HttpHandlerBase>(R"(
+    type: object
+    description: Handler streaming the progress of a batch as server-sent events
+    additionalProperties: false
+    properties:
+        update-interval:
+            type: string
+            description: Period the counters of the batch are checked for changes
+            defaultDescription: 500ms
+        heartbeat-interval:
+            type: string
+            description: Period of the comments sent while the counters don't change, so that proxies keep the stream open
+            defaultDescription: 15s
+        max-duration:
+            type: string
+            description: Period after which the stream is closed, the client reconnects to continue
+            defaultDescription: 1h
+  )");
+}
+
+std::string ens::notifications::NotificationBatchProgressHandler::HandleRequestThrow(const userver::server::http::HttpRequest &,
+                                                                                    userver::server::request::RequestContext &) const {
+  // The handler is configured with response-body-stream, its responses are made by HandleStreamRequest
+  return {};
+}
+
+void ens::notifications::NotificationBatchProgressHandler::HandleStreamRequest(userver::server::http::HttpRequest &request,
+                                                                               userver::server::request::RequestContext &,
+                                                                               userver::server::http::ResponseBodyStream &response_body_stream) const {
+  // Errors are reported before the stream starts, once the headers are sent the status can't change
+  auto reject = [&response_body_stream](userver::server::http::HttpStatus status, const std::string &message) {
+    response_body_stream.SetStatusCode(status);
+    response_body_stream.SetEndOfHeaders();
+    response_body_stream.PushBodyChunk(std::string{message}, userver::engine::Deadline{});
+  };
+  const std::string &access_token = request.GetHeader("Authorization");
+  boost::uuids::uuid batch_id;
+  boost::uuids::uuid user_id;
+  std::shared_ptr<const BatchProgress> progress;
+  try {
+    batch_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("batch_id"));
+    user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    progress = this->_notification_manager.WatchBatch(user_id, batch_id);
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    reject(userver::server::http::HttpStatus::kUnauthorized, e.what());
+    return;
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    reject(userver::server::http::HttpStatus::kNotFound, e.what());
+    return;
+  }
+  catch (const NotificationBatchNotFoundException &e) {
+    reject(userver::server::http::HttpStatus::kNotFound, e.what());
+    return;
+  }
+  response_body_stream.SetHeader(std::string{"Content-Type"}, std::string{"text/event-stream"});
+  response_body_stream.SetHeader(std::string{"Cache-Control"}, std::string{"no-cache"});
+  response_body_stream.SetStatusCode(userver::server::http::HttpStatus::kOk);
+  response_body_stream.SetEndOfHeaders();
+  // Counters are read from memory, the stale ones are reloaded once per refresh interval for all the watchers
+  const auto started_at = std::chrono::steady_clock::now();
+  auto last_push_at = started_at;
+  std::optional<BatchProgressSnapshot> last_snapshot;
+  bool deleted = false;
+  while (not userver::engine::current_task::ShouldCancel()
+      and std::chrono::steady_clock::now() - started_at < _max_duration) {
+    try {
+      progress = this->_notification_manager.WatchBatch(user_id, batch_id);
+    }
+    catch (const NotificationBatchNotFoundException &) {
+      // The batch has been deleted
+      deleted = true;
+      break;
+    }
+    const BatchProgressSnapshot snapshot = progress->Snapshot();
+    const auto now = std::chrono::steady_clock::now();
+    if (not last_snapshot.has_value() or not (last_snapshot.value() == snapshot)) {
+      userver::formats::json::ValueBuilder event_json;
+      event_json["targeted"] = snapshot.targeted;
+      event_json["sent"] = snapshot.sent;
+      event_json["failed"] = snapshot.failed;
+      event_json["pending"] = snapshot.targeted - snapshot.sent - snapshot.failed;
+      event_json["responded"] = snapshot.responded;
+      event_json["finished"] = snapshot.finished;
+      response_body_stream.PushBodyChunk(
+          "event: progress\ndata: " + userver::formats::json::ToString(event_json.ExtractValue()) + "\n\n",
+          userver::engine::Deadline{});
+      last_snapshot = snapshot;
+      last_push_at = now;
+    } else if (now - last_push_at >= _heartbeat_interval) {
+      response_body_stream.PushBodyChunk(": heartbeat\n\n", userver::engine::Deadline{});
+      last_push_at = now;
+    }
+    userver::engine::InterruptibleSleepFor(_update_interval);
+  }
+  // Most of the responses come after the dispatch, so a finished batch is streamed until the max duration too.
+  // Its stream is then ended by an event telling the client not to reconnect, the unfinished ones are reopened
+  if (not userver::engine::current_task::ShouldCancel()
+      and (deleted or (last_snapshot.has_value() and last_snapshot->finished))) {
+    response_body_stream.PushBodyChunk("event: end\ndata: {}\n\n", userver::engine::Deadline{});
+  }
+}
+
+void ens::notifications::AppendNotificationBatchProgressHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<NotificationBatchProgressHandler>();
+}
+
 userver::formats::json::Value ens::notifications::NotificationCancelNotificationHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
                                                                                                                 const userver::formats::json::Value &,
                                                                                                                 userver::server::request::RequestContext &) const {
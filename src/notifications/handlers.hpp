@@ -1,11 +1,15 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <userver/server/handlers/http_handler_base.hpp>
 #include <userver/server/handlers/http_handler_json_base.hpp>
+#include <userver/server/http/http_response_body_stream.hpp>
 #include <userver/components/component.hpp>
 #include <userver/components/component_list.hpp>
 
+#include "notifications/batch_scheduler.hpp"
 #include "notifications/notifications.hpp"
 #include "user/auth.hpp"
 
@@ -77,6 +81,76 @@ class NotificationSendBatchHandler : public NotificationJsonHandlerBase {
 
 void AppendNotificationSendBatchHandler(userver::components::ComponentList &component_list);
 
+class NotificationScheduleBatchHandler : public NotificationJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-notifications-scheduleBatch";
+  NotificationScheduleBatchHandler(const userver::components::ComponentConfig &config,
+                                   const userver::components::ComponentContext &context)
+      : NotificationJsonHandlerBase(config, context),
+        _batch_scheduler(context.FindComponent<BatchScheduler>()) {}
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+ private:
+  BatchScheduler &_batch_scheduler;
+};
+
+void AppendNotificationScheduleBatchHandler(userver::components::ComponentList &component_list);
+
+class NotificationGetBatchResponsesHandler : public NotificationJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-notifications-getBatchResponses";
+  using NotificationJsonHandlerBase::NotificationJsonHandlerBase;
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+};
+
+void AppendNotificationGetBatchResponsesHandler(userver::components::ComponentList &component_list);
+
+class NotificationGetBatchSummaryHandler : public NotificationJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-notifications-getBatchSummary";
+  using NotificationJsonHandlerBase::NotificationJsonHandlerBase;
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+};
+
+void AppendNotificationGetBatchSummaryHandler(userver::components::ComponentList &component_list);
+
+// Streams the progress of a batch as server-sent events, an event is pushed whenever the counters change.
+// The stream of a finished batch ends with an end event, after which the client doesn't reconnect
+class NotificationBatchProgressHandler : public userver::server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-notifications-batchProgress";
+  static constexpr std::chrono::milliseconds kDefaultUpdateInterval{500};
+  static constexpr std::chrono::milliseconds kDefaultHeartbeatInterval{15000};
+  static constexpr std::chrono::milliseconds kDefaultMaxDuration{3600000};
+  NotificationBatchProgressHandler(const userver::components::ComponentConfig &config,
+                                   const userver::components::ComponentContext &context)
+      : HttpHandlerBase(config, context),
+        _notification_manager(context.FindComponent<NotificationsManager>()),
+        _jwt_verif_manager(context.FindComponent<ens::auth::JWTManager>()),
+        _update_interval(config["update-interval"].As<std::chrono::milliseconds>(kDefaultUpdateInterval)),
+        _heartbeat_interval(config["heartbeat-interval"].As<std::chrono::milliseconds>(kDefaultHeartbeatInterval)),
+        _max_duration(config["max-duration"].As<std::chrono::milliseconds>(kDefaultMaxDuration)) {}
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  std::string HandleRequestThrow(const userver::server::http::HttpRequest &request,
+                                 userver::server::request::RequestContext &) const override;
+  void HandleStreamRequest(userver::server::http::HttpRequest &request,
+                           userver::server::request::RequestContext &,
+                           userver::server::http::ResponseBodyStream &response_body_stream) const override;
+ private:
+  NotificationsManager &_notification_manager;
+  ens::auth::JWTManager &_jwt_verif_manager;
+  const std::chrono::milliseconds _update_interval;
+  const std::chrono::milliseconds _heartbeat_interval;
+  const std::chrono::milliseconds _max_duration;
+};
+
+void AppendNotificationBatchProgressHandler(userver::components::ComponentList &component_list);
+
 class NotificationCancelNotificationHandler : public NotificationJsonHandlerBase {
  public:
   static constexpr std::string_view kName = "handler-notifications-cancelNotification";
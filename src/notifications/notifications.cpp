@@ -1,7 +1,20 @@
 #include "notifications.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <unordered_map>
 
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/nil_generator.hpp>
+#include <userver/engine/exception.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/fs/read.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/scope_guard.hpp>
 #include <userver/yaml_config/merge_schemas.hpp>
 
 #include "schemas/schemas.hpp"
@@ -11,22 +24,166 @@ userver::yaml_config::Schema ens::notifications::NotificationsManager::GetStatic
     type: object
     description: Component for notifications management logic
     additionalProperties: false
-    properties: {}
+    properties:
+        max-in-flight-sends:
+            type: integer
+            description: Maximum number of telegram messages of a batch awaiting the reply at the same time
+            defaultDescription: 256
+            minimum: 1
+        concurrency-control:
+            type: object
+            description: Settings of the controllers adjusting the number of telegram messages awaiting the reply to the latency and the errors of every bot
+            additionalProperties: false
+            properties:
+                enabled:
+                    type: boolean
+                    description: Adjust the limit, otherwise max-in-flight-sends messages are awaited at the same time
+                    defaultDescription: true
+                initial-limit:
+                    type: integer
+                    description: Limit the controller starts from
+                    defaultDescription: 16
+                    minimum: 1
+                min-limit:
+                    type: integer
+                    description: Limit is never cut below this
+                    defaultDescription: 1
+                    minimum: 1
+                backoff:
+                    type: number
+                    description: Share of the limit kept after a rate limited, failed or slow reply
+                    defaultDescription: 0.7
+                latency-tolerance:
+                    type: number
+                    description: Replies slower than the fastest recent reply times the tolerance cut the limit
+                    defaultDescription: 2.0
+        attachments-dir:
+            type: string
+            description: Directory with the files attached to the templates
+            defaultDescription: attachments are disabled
+        fs-task-processor:
+            type: string
+            description: Task processor for the attachments directory access
+            defaultDescription: fs-task-processor
+        channel-priority:
+            type: array
+            description: Channels tried in turn after the preferred channel of the recipient
+            defaultDescription: '[Telegram, Mail, SMS]'
+            items:
+                type: string
+                description: Telegram, Mail or SMS
+        circuit-breaker:
+            type: object
+            description: Settings of the circuit breakers stopping the calls to a failing channel
+            additionalProperties: false
+            properties:
+                window:
+                    type: string
+                    description: Period the error and slow call rates are computed over
+                    defaultDescription: 10s
+                min-calls:
+                    type: integer
+                    description: Minimum number of calls in the window for the breaker to open
+                    defaultDescription: 20
+                    minimum: 1
+                failure-rate-threshold:
+                    type: number
+                    description: Share of failed calls opening the breaker
+                    defaultDescription: 0.5
+                slow-call-duration:
+                    type: string
+                    description: Successful calls slower than this are counted as slow
+                    defaultDescription: 2s
+                slow-call-rate-threshold:
+                    type: number
+                    description: Share of slow calls opening the breaker
+                    defaultDescription: 0.8
+                open-duration:
+                    type: string
+                    description: Period the calls are stopped for before the probe calls
+                    defaultDescription: 30s
+                half-open-probes:
+                    type: integer
+                    description: Number of successful probe calls closing the breaker
+                    defaultDescription: 3
+                    minimum: 1
+        dispatch-partitions:
+            type: integer
+            description: Number of the parts the recipients of a batch are split into by the hash of the recipient id, the parts are dispatched by all the instances of the service
+            defaultDescription: 1
+            minimum: 1
+        partition-lease-duration:
+            type: string
+            description: Time a partition stays with the instance dispatching it without renewing the lease, then it is dispatched by another instance
+            defaultDescription: 10s
+        partition-poll-interval:
+            type: string
+            description: Period of checking the partitions dispatched by the other instances while the batch is being sent
+            defaultDescription: 100ms
   )");
 }
 
-std::string ens::notifications::NotificationsManager::CreateBatch(const boost::uuids::uuid &user_id) {
+std::vector<schemas::Notification::Type> ens::notifications::NotificationsManager::ParseChannelPriority(
+    const userver::yaml_config::YamlConfig &config) {
+  if (config.IsMissing()) {
+    return {schemas::Notification::Type::kTelegram,
+            schemas::Notification::Type::kMail,
+            schemas::Notification::Type::kSms};
+  }
+  std::vector<schemas::Notification::Type> priority;
+  for (const std::string &channel : config.As<std::vector<std::string>>()) {
+    const schemas::Notification::Type type =
+        schemas::FromString(channel, userver::formats::parse::To<schemas::Notification::Type>{});
+    if (type == schemas::Notification::Type::kTelegramChannel) {
+      throw std::runtime_error{"TelegramChannel can't be used in channel-priority"};
+    }
+    if (std::find(priority.cbegin(), priority.cend(), type) == priority.cend()) {
+      priority.push_back(type);
+    }
+  }
+  return priority;
+}
+
+void ens::notifications::NotificationsManager::WriteStatistics(userver::utils::statistics::Writer &writer) const {
+  for (size_t bot_index = 0; bot_index < _telegram_concurrency.size(); ++bot_index) {
+    const ConcurrencyController &controller = *_telegram_concurrency[bot_index];
+    const std::string bot = std::to_string(bot_index);
+    const userver::utils::statistics::LabelView label{"bot", bot};
+    writer["telegram"]["limit"].ValueWithLabels(controller.GetLimit(), {label});
+    writer["telegram"]["decreases"].ValueWithLabels(controller.GetDecreases(), {label});
+  }
+}
+
+ens::notifications::CircuitBreaker &ens::notifications::NotificationsManager::GetBreaker(const schemas::Notification::Type &type) {
+  switch (type) {
+    case schemas::Notification::Type::kMail: {
+      return _email_breaker;
+    }
+    case schemas::Notification::Type::kSms: {
+      return _sms_breaker;
+    }
+    case schemas::Notification::Type::kTelegram:
+    case schemas::Notification::Type::kTelegramChannel: {
+      return _telegram_breaker;
+    }
+  }
+  return _telegram_breaker;
+}
+
+std::string ens::notifications::NotificationsManager::CreateBatch(const boost::uuids::uuid &user_id,
+                                                                  BatchPriority priority) {
   const userver::storages::postgres::Query create_batch_query{
       "INSERT INTO ens_schema.notifications_batch "
-      "(batch_id, master_id, sent) "
-      "VALUES ($1, $2, false)"
+      "(batch_id, master_id, sent, priority) "
+      "VALUES ($1, $2, false, $3)"
   };
   boost::uuids::uuid batch_id = userver::utils::generators::GenerateBoostUuidV7();
   userver::storages::postgres::Transaction insert_transaction =
       _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
   userver::storages::postgres::ResultSet insert_res = insert_transaction.Execute(create_batch_query,
                                                                                  batch_id,
-                                                                                 user_id);
+                                                                                 user_id,
+                                                                                 priority);
   insert_transaction.Commit();
   return boost::uuids::to_string(batch_id);
 }
@@ -39,17 +196,17 @@ std::unique_ptr<schemas::Notification> ens::notifications::NotificationsManager:
       "WHERE master_id = $1 AND notification_id = $2",
   };
   userver::storages::postgres::ResultSet
-      select_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
-                                        notification_info_query,
-                                        user_id,
-                                        notification_id);
+      select_res = _hedged_reads.Execute(ens::utils::ReadClass::kGetById,
+                                         notification_info_query,
+                                         user_id,
+                                         notification_id);
   if (select_res.IsEmpty()) {
     throw NotificationNotFoundException{boost::uuids::to_string(notification_id)};
   }
   userver::storages::postgres::Row notification_row = select_res[0];
   schemas::Notification notification_data{boost::uuids::to_string(notification_id),
                                           boost::uuids::to_string(notification_row["batch_id"].As<boost::uuids::uuid>()),
-                                          boost::uuids::to_string(notification_row["recipient_id"].As<boost::uuids::uuid>()),
+                                          ens::utils::optional_uuid_to_str(notification_row["recipient_id"].As<std::optional<boost::uuids::uuid>>()),
                                           boost::uuids::to_string(notification_row["group_id"].As<boost::uuids::uuid>()),
                                           notification_row["message_type"].As<schemas::Notification::Type>(),
                                           notification_row["creation_timestamp"].As<std::string>(),
@@ -74,7 +231,7 @@ std::unique_ptr<schemas::NotificationList> ens::notifications::NotificationsMana
     schemas::Notification
         notification_data{boost::uuids::to_string(notification_row["notification_id"].As<boost::uuids::uuid>()),
                           boost::uuids::to_string(notification_row["batch_id"].As<boost::uuids::uuid>()),
-                          boost::uuids::to_string(notification_row["recipient_id"].As<boost::uuids::uuid>()),
+                          ens::utils::optional_uuid_to_str(notification_row["recipient_id"].As<std::optional<boost::uuids::uuid>>()),
                           boost::uuids::to_string(notification_row["group_id"].As<boost::uuids::uuid>()),
                           notification_row["message_type"].As<schemas::Notification::Type>(),
                           notification_row["creation_timestamp"].As<std::string>(),
@@ -101,7 +258,7 @@ std::unique_ptr<schemas::NotificationList> ens::notifications::NotificationsMana
     schemas::Notification
         notification_data{boost::uuids::to_string(notification_row["notification_id"].As<boost::uuids::uuid>()),
                           boost::uuids::to_string(notification_row["batch_id"].As<boost::uuids::uuid>()),
-                          boost::uuids::to_string(notification_row["recipient_id"].As<boost::uuids::uuid>()),
+                          ens::utils::optional_uuid_to_str(notification_row["recipient_id"].As<std::optional<boost::uuids::uuid>>()),
                           boost::uuids::to_string(notification_row["group_id"].As<boost::uuids::uuid>()),
                           notification_row["message_type"].As<schemas::Notification::Type>(),
                           notification_row["creation_timestamp"].As<std::string>(),
@@ -114,90 +271,973 @@ std::unique_ptr<schemas::NotificationList> ens::notifications::NotificationsMana
 
 // TODO: Add functionality to keep track of notifications status
 std::string ens::notifications::NotificationsManager::CreateNotification(const schemas::Notification::Type &type,
+                                                                         const boost::uuids::uuid &notification_id,
                                                                          const boost::uuids::uuid &batch_id,
-                                                                         const boost::uuids::uuid &recipient_id,
+                                                                         const std::optional<boost::uuids::uuid> &recipient_id,
                                                                          const boost::uuids::uuid &group_id) {
-  const userver::storages::postgres::Query create_notification_query{
-      "INSERT INTO ens_schema.notification "
-      "(type, creation_timestamp, notification_id, batch_id, recipient_id, group_id) "
-      "VALUES ($1, $2, $3, $4, $5, $6)"
-  };
-  const boost::uuids::uuid notification_id = userver::utils::generators::GenerateBoostUuidV7();
-  std::time_t creation_timestamp = userver::utils::datetime::Timestamp();
-  userver::storages::postgres::Transaction insert_transaction =
-      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
-  userver::storages::postgres::ResultSet insert_res = insert_transaction.Execute(create_notification_query,
-                                                                                 type,
-                                                                                 creation_timestamp,
-                                                                                 notification_id,
-                                                                                 batch_id,
-                                                                                 recipient_id,
-                                                                                 group_id);
-  insert_transaction.Commit();
+  _notifications_writer.Write({{type,
+                                userver::utils::datetime::Timestamp(),
+                                notification_id,
+                                batch_id,
+                                recipient_id,
+                                group_id}});
   return boost::uuids::to_string(notification_id);
 }
 
+void ens::notifications::NotificationsManager::CreateNotifications(const schemas::Notification::Type &type,
+                                                                   const boost::uuids::uuid &batch_id,
+                                                                   const std::vector<boost::uuids::uuid> &notification_ids,
+                                                                   const std::vector<boost::uuids::uuid> &recipient_ids,
+                                                                   const std::vector<boost::uuids::uuid> &group_ids) {
+  const int64_t creation_timestamp = userver::utils::datetime::Timestamp();
+  std::vector<NotificationRecord> records;
+  records.reserve(notification_ids.size());
+  for (size_t i = 0; i < notification_ids.size(); ++i) {
+    records.push_back({type, creation_timestamp, notification_ids[i], batch_id, recipient_ids[i], group_ids[i]});
+  }
+  _notifications_writer.Write(records);
+}
+
 std::unique_ptr<std::vector<std::string>> ens::notifications::NotificationsManager::SendBatch(const boost::uuids::uuid &user_id,
                                                                                               const boost::uuids::uuid &batch_id) {
-  const userver::storages::postgres::Query batch_exists_query{
-      "SELECT EXISTS ( "
-      "SELECT 1 "
-      "FROM ens_schema.notifications_batch "
-      "WHERE master_id = $1 AND batch_id = $2 AND NOT sent)"
+  // The batch is claimed and its dispatch settings are read in a single round trip before the first send.
+  // A pending schedule is cleared along with the claim
+  const userver::storages::postgres::Query claim_batch_query{
+      "UPDATE ens_schema.notifications_batch "
+      "SET sent = true, scheduled_at = NULL "
+      "FROM ens_schema.user AS tenant "
+      "WHERE notifications_batch.master_id = $1 AND notifications_batch.batch_id = $2 AND NOT notifications_batch.sent "
+      "AND notifications_batch.master_id = tenant.user_id "
+      "RETURNING notifications_batch.priority, tenant.tier"
   };
-  const userver::storages::postgres::Query set_batch_sent_query{
+  userver::storages::postgres::Transaction claim_batch_tr = _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet batch_dispatch_res = claim_batch_tr.Execute(claim_batch_query,
+                                                                                    user_id,
+                                                                                    batch_id);
+  claim_batch_tr.Commit();
+  if (batch_dispatch_res.IsEmpty()) {
+    throw NotificationBatchNotFoundException{boost::uuids::to_string(batch_id)};
+  }
+  // Every send of the batch waits for the channel capacity in the lane of its priority, in the queue of its tenant
+  const DispatchTag tag{batch_dispatch_res[0]["priority"].As<BatchPriority>(),
+                        user_id,
+                        batch_dispatch_res[0]["tier"].As<TenantTier>()};
+  return DispatchClaimed(batch_id, tag);
+}
+
+bool ens::notifications::NotificationsManager::SendScheduledBatch(const boost::uuids::uuid &batch_id,
+                                                                  int64_t scheduled_at) {
+  // The schedule is cleared by the claim of the batch itself, so a failed claim leaves it for the next sync
+  // of the schedules, and once the batch is claimed its dispatch is journaled
+  const userver::storages::postgres::Query claim_batch_query{
       "UPDATE ens_schema.notifications_batch "
-      "SET sent = true "
-      "WHERE master_id = $1 AND batch_id = $2"
+      "SET sent = true, scheduled_at = NULL "
+      "FROM ens_schema.user AS tenant "
+      "WHERE notifications_batch.batch_id = $1 AND notifications_batch.scheduled_at = $2 AND NOT notifications_batch.sent "
+      "AND notifications_batch.master_id = tenant.user_id "
+      "RETURNING notifications_batch.master_id, notifications_batch.priority, tenant.tier"
   };
+  userver::storages::postgres::Transaction claim_batch_tr = _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet batch_dispatch_res = claim_batch_tr.Execute(claim_batch_query,
+                                                                                    batch_id,
+                                                                                    scheduled_at);
+  claim_batch_tr.Commit();
+  if (batch_dispatch_res.IsEmpty()) {
+    return false;
+  }
+  const DispatchTag tag{batch_dispatch_res[0]["priority"].As<BatchPriority>(),
+                        batch_dispatch_res[0]["master_id"].As<boost::uuids::uuid>(),
+                        batch_dispatch_res[0]["tier"].As<TenantTier>()};
+  DispatchClaimed(batch_id, tag);
+  return true;
+}
+
+std::unique_ptr<std::vector<std::string>> ens::notifications::NotificationsManager::DispatchClaimed(const boost::uuids::uuid &batch_id,
+                                                                                                    const DispatchTag &tag) {
+  if (_dispatch_partitions > 1) {
+    return DispatchPartitioned(batch_id, tag);
+  }
+  _dispatch_journal.BeginBatch(batch_id, tag);
+  return DispatchBatch(batch_id, tag, {}, false);
+}
+
+void ens::notifications::NotificationsManager::ResumeBatch(const UnfinishedBatch &batch) {
+  LOG_INFO() << "Resuming batch dispatch, batch_id=" << boost::uuids::to_string(batch.batch_id)
+             << ", delivered=" << batch.delivered.size();
+  DispatchBatch(batch.batch_id, batch.tag, batch.delivered, true);
+}
+
+ens::notifications::NotificationsManager::JournaledDeliveries ens::notifications::NotificationsManager::ToJournaledDeliveries(
+    const std::vector<DeliveryAck> &delivered) {
+  JournaledDeliveries journaled;
+  for (const DeliveryAck &ack : delivered) {
+    journaled.emplace(std::make_pair(ack.recipient_id.value_or(boost::uuids::nil_uuid()), ack.group_id), ack);
+  }
+  return journaled;
+}
+
+std::unique_ptr<std::vector<std::string>> ens::notifications::NotificationsManager::DispatchBatch(const boost::uuids::uuid &batch_id,
+                                                                                                  const DispatchTag &tag,
+                                                                                                  const std::vector<DeliveryAck> &delivered,
+                                                                                                  bool resumed) {
+  const boost::uuids::uuid &user_id = tag.tenant_id;
+  const std::shared_ptr<BatchProgress> progress = _progress_tracker.Track(batch_id, user_id);
+  userver::utils::ScopeGuard finish_progress([this, &batch_id] { _progress_tracker.Finish(batch_id); });
+  const JournaledDeliveries journaled = ToJournaledDeliveries(delivered);
+  std::vector<std::string> ids_vector;
+  // Attachment files are read once per batch and shared by the uploads of all the bots
+  AttachmentContents attachment_contents;
+  const std::vector<boost::uuids::uuid> failed_channel_groups = PostToTelegramChannels(user_id,
+                                                                                       batch_id,
+                                                                                       ids_vector,
+                                                                                       attachment_contents,
+                                                                                       journaled,
+                                                                                       tag,
+                                                                                       *progress);
+  DispatchRecipients(batch_id,
+                     tag,
+                     failed_channel_groups,
+                     kWholeBatch,
+                     nullptr,
+                     journaled,
+                     resumed,
+                     ids_vector,
+                     attachment_contents,
+                     *progress);
+  _dispatch_journal.FinishBatch(batch_id);
+  return std::make_unique<std::vector<std::string>>(ids_vector);
+}
+
+std::unique_ptr<std::vector<std::string>> ens::notifications::NotificationsManager::DispatchPartitioned(const boost::uuids::uuid &batch_id,
+                                                                                                        const DispatchTag &tag) {
+  const std::shared_ptr<BatchProgress> progress = _progress_tracker.Track(batch_id, tag.tenant_id);
+  std::vector<std::string> ids_vector;
+  AttachmentContents attachment_contents;
+  // Channel posts address whole groups, they are made once before the recipients are split
+  const std::vector<boost::uuids::uuid> direct_groups = PostToTelegramChannels(tag.tenant_id,
+                                                                               batch_id,
+                                                                               ids_vector,
+                                                                               attachment_contents,
+                                                                               {},
+                                                                               tag,
+                                                                               *progress);
+  _partition_leases.Create(batch_id, _dispatch_partitions, direct_groups);
+  // This instance dispatches the partitions along with the workers of the other instances, then takes over
+  // the ones whose leases expire until all of them are done
+  for (;;) {
+    std::optional<PartitionClaim> claim = _partition_leases.Claim(batch_id);
+    if (claim.has_value()) {
+      DispatchPartition(claim.value());
+      continue;
+    }
+    std::optional<std::vector<std::string>> partition_ids = _partition_leases.CollectNotifications(batch_id);
+    if (partition_ids.has_value()) {
+      ids_vector.insert(ids_vector.end(), partition_ids->cbegin(), partition_ids->cend());
+      break;
+    }
+    userver::engine::InterruptibleSleepFor(_partition_poll_interval);
+    if (userver::engine::current_task::ShouldCancel()) {
+      throw std::runtime_error{"Batch dispatch cancelled while waiting for the partitions"};
+    }
+  }
+  return std::make_unique<std::vector<std::string>>(ids_vector);
+}
+
+std::optional<ens::notifications::PartitionClaim> ens::notifications::NotificationsManager::ClaimPartition() {
+  return _partition_leases.Claim(std::nullopt);
+}
+
+void ens::notifications::NotificationsManager::DispatchPartition(const PartitionClaim &claim) {
+  const std::shared_ptr<BatchProgress> progress = _progress_tracker.Track(claim.batch_id, claim.tag.tenant_id);
+  std::vector<std::string> notification_ids;
+  AttachmentContents attachment_contents;
+  bool dispatched = false;
+  try {
+    // Deliveries acknowledged by a previous holder are only recorded, it has counted them as well
+    dispatched = DispatchRecipients(claim.batch_id,
+                                    claim.tag,
+                                    claim.direct_groups,
+                                    claim.partition,
+                                    &claim,
+                                    ToJournaledDeliveries(claim.delivered),
+                                    not claim.delivered.empty(),
+                                    notification_ids,
+                                    attachment_contents,
+                                    *progress);
+  }
+  catch (const std::exception &) {
+    _partition_leases.Release(claim);
+    throw;
+  }
+  if (not dispatched) {
+    LOG_WARNING() << "Partition lease lost during the dispatch, batch_id=" << boost::uuids::to_string(claim.batch_id)
+                  << ", partition=" << claim.partition.index;
+    return;
+  }
+  // Whichever instance completes the last partition finishes the batch
+  if (_partition_leases.Complete(claim, notification_ids)) {
+    _progress_tracker.Finish(claim.batch_id);
+  }
+}
+
+bool ens::notifications::NotificationsManager::DispatchRecipients(const boost::uuids::uuid &batch_id,
+                                                                  const DispatchTag &tag,
+                                                                  const std::vector<boost::uuids::uuid> &direct_groups,
+                                                                  const BatchPartition &partition,
+                                                                  const PartitionClaim *claim,
+                                                                  const JournaledDeliveries &journaled,
+                                                                  bool resumed,
+                                                                  std::vector<std::string> &notification_ids,
+                                                                  AttachmentContents &attachment_contents,
+                                                                  BatchProgress &progress) {
+  const boost::uuids::uuid &user_id = tag.tenant_id;
   const userver::storages::postgres::Query info_query{
-      "SELECT recipient_group.recipient_group_id, recipient.recipient_id, recipient.email, recipient.phone_number, recipient.telegram_id, telegram_contact.active, notification_template.message_text "
+      "SELECT recipient_group.recipient_group_id, recipient.recipient_id, recipient.email, recipient.phone_number, recipient.preferred_channel, telegram_contact.user_id AS telegram_id, telegram_contact.bot_index, notification_template.notification_template_id, notification_template.name, notification_template.message_text, notification_template.attachment_file "
       "FROM ens_schema.recipient_group "
       "INNER JOIN ens_schema.notification_template ON recipient_group.template_id = notification_template.notification_template_id "  // Inner join elliminates groups without template
       "INNER JOIN ens_schema.recipient_recipient_group ON recipient_group.recipient_group_id = recipient_recipient_group.recipient_group_id "
       "INNER JOIN ens_schema.recipient ON recipient_recipient_group.recipient_id = recipient.recipient_id "
-      "LEFT JOIN ens_schema.telegram_contact ON recipient.telegram_id = telegram_contact.user_id "
-      "WHERE recipient_group.master_id = $1 AND recipient_group.active"
+      "LEFT JOIN ens_schema.telegram_contact ON recipient.telegram_id = telegram_contact.user_id AND telegram_contact.active "
+      "WHERE recipient_group.master_id = $1 AND recipient_group.active AND notification_template.message_text IS NOT NULL "
+      // Subscribers of the channel a group was posted to have already got the notification
+      "AND NOT (recipient_group.telegram_channel_id IS NOT NULL AND recipient_group.recipient_group_id <> ALL($2) "
+      "AND COALESCE(NOT telegram_contact.channel_opt_out, false)) "
+      "AND (hashtext(recipient.recipient_id::text) & 2147483647) % $4 = $3"
   };
   userver::storages::postgres::ResultSet
-      batch_exists_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
-                                              batch_exists_query,
-                                              user_id,
-                                              batch_id);
-  if (not batch_exists_res.AsSingleRow<bool>()) {
+      info_res = _hedged_reads.Execute(ens::utils::ReadClass::kFanOut,
+                                       info_query,
+                                       user_id,
+                                       direct_groups,
+                                       partition.index,
+                                       partition.count);
+  BatchTemplates templates;
+  std::vector<RoutedDelivery> deliveries;
+  std::vector<size_t> pending;
+  size_t unreachable = 0;
+  for (auto row : info_res) {
+    RoutedDelivery delivery{userver::utils::generators::GenerateBoostUuidV7(),
+                            row["recipient_id"].As<boost::uuids::uuid>(),
+                            row["recipient_group_id"].As<boost::uuids::uuid>(),
+                            row["notification_template_id"].As<boost::uuids::uuid>(),
+                            row["telegram_id"].As<std::optional<int64_t>>(),
+                            row["bot_index"].As<std::optional<int32_t>>().value_or(0),
+                            row["email"].As<std::optional<std::string>>(),
+                            row["phone_number"].As<std::optional<std::string>>(),
+                            {}};
+    const auto journaled_it = journaled.find(std::make_pair(delivery.recipient_id, delivery.group_id));
+    if (journaled_it != journaled.end()) {
+      // Delivered before the restart, only its row is written
+      delivery.notification_id = journaled_it->second.notification_id;
+      delivery.channels = {journaled_it->second.type};
+      deliveries.push_back(std::move(delivery));
+      continue;
+    }
+    delivery.channels = ChooseChannels(delivery,
+                                       row["preferred_channel"].As<std::optional<schemas::Notification::Type>>());
+    if (delivery.channels.empty()) {
+      ++unreachable;
+      continue;
+    }
+    auto template_it = templates.find(delivery.template_id);
+    if (template_it == templates.end()) {
+      templates.emplace(delivery.template_id, BatchTemplate{row["name"].As<std::string>(),
+                                                            row["message_text"].As<std::string>(),
+                                                            row["attachment_file"].As<std::optional<std::string>>(),
+                                                            nullptr});
+    }
+    pending.push_back(deliveries.size());
+    deliveries.push_back(std::move(delivery));
+  }
+  // A resumed batch has been counted by the interrupted dispatch, its counters are flushed within a second
+  if (not resumed) {
+    progress.targeted += static_cast<int64_t>(deliveries.size() + unreachable);
+    progress.failed += static_cast<int64_t>(unreachable);
+  }
+  if (unreachable != 0) {
+    LOG_WARNING() << unreachable << " recipients have no channel available, batch_id="
+                  << boost::uuids::to_string(batch_id);
+  }
+  // Deliveries are journaled as their channels accept them, so that a restart doesn't send them again
+  const AcknowledgeDeliveries acknowledge = [this, &batch_id, claim, &deliveries](const std::vector<size_t> &indices) {
+    if (indices.empty()) {
+      return;
+    }
+    std::vector<DeliveryAck> acks;
+    acks.reserve(indices.size());
+    for (size_t index : indices) {
+      const RoutedDelivery &delivery = deliveries[index];
+      acks.push_back({delivery.notification_id,
+                      delivery.recipient_id,
+                      delivery.group_id,
+                      delivery.channels[delivery.channel_index]});
+    }
+    if (claim == nullptr) {
+      _dispatch_journal.Acknowledge(batch_id, acks);
+    } else {
+      _partition_leases.Acknowledge(*claim, acks);
+    }
+  };
+  // The lease is checked before every send, the new holder of a lost partition sends the rest
+  // and records the deliveries acknowledged so far
+  const DispatchStopped stopped = [claim] { return claim != nullptr and claim->lost->load(); };
+  // Every round the deliveries rejected by their channel fall back to the next one
+  while (not pending.empty()) {
+    if (stopped()) {
+      return false;
+    }
+    std::vector<size_t> failed = DispatchRound(batch_id, pending, deliveries, templates, attachment_contents, tag,
+                                               acknowledge, stopped, progress);
+    if (stopped()) {
+      return false;
+    }
+    for (size_t index : failed) {
+      ++deliveries[index].channel_index;
+    }
+    pending.clear();
+    for (size_t index : failed) {
+      if (deliveries[index].channel_index < deliveries[index].channels.size()) {
+        pending.push_back(index);
+      } else {
+        ++progress.failed;
+      }
+    }
+  }
+  // Each delivery is recorded under the channel it ended up with
+  struct ChannelRows {
+    std::vector<boost::uuids::uuid> notification_ids;
+    std::vector<boost::uuids::uuid> recipient_ids;
+    std::vector<boost::uuids::uuid> group_ids;
+  };
+  std::unordered_map<schemas::Notification::Type, ChannelRows> channel_rows;
+  size_t undelivered = 0;
+  for (const RoutedDelivery &delivery : deliveries) {
+    if (delivery.channel_index >= delivery.channels.size()) {
+      ++undelivered;
+    }
+    ChannelRows &rows =
+        channel_rows[delivery.channels[std::min(delivery.channel_index, delivery.channels.size() - 1)]];
+    rows.notification_ids.push_back(delivery.notification_id);
+    rows.recipient_ids.push_back(delivery.recipient_id);
+    rows.group_ids.push_back(delivery.group_id);
+    notification_ids.push_back(boost::uuids::to_string(delivery.notification_id));
+  }
+  if (undelivered != 0) {
+    LOG_ERROR() << undelivered << " notifications were not delivered over any channel, batch_id="
+                << boost::uuids::to_string(batch_id);
+  }
+  for (const auto &[type, rows] : channel_rows) {
+    CreateNotifications(type, batch_id, rows.notification_ids, rows.recipient_ids, rows.group_ids);
+  }
+  return true;
+}
+
+std::shared_ptr<const ens::notifications::BatchProgress> ens::notifications::NotificationsManager::WatchBatch(const boost::uuids::uuid &user_id,
+                                                                                                           const boost::uuids::uuid &batch_id) {
+  std::shared_ptr<const BatchProgress> progress = _progress_tracker.Get(user_id, batch_id);
+  if (not progress) {
+    throw NotificationBatchNotFoundException{boost::uuids::to_string(batch_id)};
+  }
+  return progress;
+}
+
+ens::notifications::BatchProgressSnapshot ens::notifications::NotificationsManager::GetBatchSummary(const boost::uuids::uuid &user_id,
+                                                                                                  const boost::uuids::uuid &batch_id) {
+  return WatchBatch(user_id, batch_id)->Snapshot();
+}
+
+ens::notifications::telegram::ResponseTally ens::notifications::NotificationsManager::GetBatchResponses(const boost::uuids::uuid &user_id,
+                                                                                                     const boost::uuids::uuid &batch_id) {
+  // Tallies are kept per batch, the responses themselves are never aggregated
+  const userver::storages::postgres::Query tally_query{
+      "SELECT batch_response_tally.status, batch_response_tally.responses "
+      "FROM ens_schema.notifications_batch "
+      "LEFT JOIN ens_schema.batch_response_tally ON notifications_batch.batch_id = batch_response_tally.batch_id "
+      "WHERE notifications_batch.master_id = $1 AND notifications_batch.batch_id = $2"
+  };
+  userver::storages::postgres::ResultSet tally_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
+                                                                          tally_query,
+                                                                          user_id,
+                                                                          batch_id);
+  if (tally_res.IsEmpty()) {
     throw NotificationBatchNotFoundException{boost::uuids::to_string(batch_id)};
   }
-  userver::storages::postgres::Transaction set_batch_sent_tr = _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
-  set_batch_sent_tr.Execute(set_batch_sent_query,
-                            user_id,
-                            batch_id);
-  set_batch_sent_tr.Commit();
+  // Responses this instance hasn't written yet are added on top of the stored tallies
+  telegram::ResponseTally tally = _telegram_bot.GetPendingResponses(batch_id);
+  for (auto row : tally_res) {
+    const auto status = row["status"].As<std::optional<telegram::ResponseStatus>>();
+    if (status.has_value()) {
+      tally[static_cast<size_t>(status.value())] += row["responses"].As<int64_t>();
+    }
+  }
+  return tally;
+}
+
+std::vector<schemas::Notification::Type> ens::notifications::NotificationsManager::ChooseChannels(
+    const RoutedDelivery &delivery,
+    const std::optional<schemas::Notification::Type> &preferred_channel) const {
+  std::vector<schemas::Notification::Type> channels;
+  auto add_channel = [this, &delivery, &channels](const schemas::Notification::Type &type) {
+    bool available = false;
+    switch (type) {
+      case schemas::Notification::Type::kTelegram: {
+        available = delivery.telegram_id.has_value() and delivery.bot_index >= 0
+            and static_cast<size_t>(delivery.bot_index) < _telegram_bot.GetBotsCount();
+        break;
+      }
+      case schemas::Notification::Type::kMail: {
+        available = delivery.email.has_value() and _email_sender.IsEnabled();
+        break;
+      }
+      case schemas::Notification::Type::kSms: {
+        available = delivery.phone_number.has_value() and _sms_gateway.IsEnabled();
+        break;
+      }
+      case schemas::Notification::Type::kTelegramChannel: {
+        break;
+      }
+    }
+    if (available and std::find(channels.cbegin(), channels.cend(), type) == channels.cend()) {
+      channels.push_back(type);
+    }
+  };
+  if (preferred_channel.has_value()) {
+    add_channel(preferred_channel.value());
+  }
+  for (const schemas::Notification::Type &type : _channel_priority) {
+    add_channel(type);
+  }
+  return channels;
+}
+
+std::vector<size_t> ens::notifications::NotificationsManager::DispatchRound(const boost::uuids::uuid &batch_id,
+                                                                            const std::vector<size_t> &pending,
+                                                                            std::vector<RoutedDelivery> &deliveries,
+                                                                            BatchTemplates &templates,
+                                                                            AttachmentContents &attachment_contents,
+                                                                            const DispatchTag &tag,
+                                                                            const AcknowledgeDeliveries &acknowledge,
+                                                                            const DispatchStopped &stopped,
+                                                                            BatchProgress &progress) {
+  std::vector<size_t> failed;
+  // Every recipient is messaged by the bot it has subscribed through, bots of the pool send in parallel
+  std::vector<std::vector<TelegramDelivery>> bot_deliveries(_telegram_bot.GetBotsCount());
+  std::vector<std::vector<size_t>> bot_delivery_indices(_telegram_bot.GetBotsCount());
+  TemplatesContacts email_templates;
+  TemplatesContacts sms_templates;
+  auto add_contact = [&templates](TemplatesContacts &channel_templates, const RoutedDelivery &delivery,
+                                  const std::string &contact, size_t index) {
+    TemplateContacts &message = channel_templates[delivery.template_id];
+    if (message.contacts.empty()) {
+      const BatchTemplate &batch_template = templates.at(delivery.template_id);
+      message.name = batch_template.name;
+      message.text = batch_template.text;
+    }
+    std::vector<size_t> &contact_deliveries = message.contact_deliveries[contact];
+    if (contact_deliveries.empty()) {
+      message.contacts.push_back(contact);
+    }
+    contact_deliveries.push_back(index);
+  };
+  for (size_t index : pending) {
+    RoutedDelivery &delivery = deliveries[index];
+    // Channels with an open breaker are skipped without waiting for them to recover
+    while (delivery.channel_index < delivery.channels.size()
+        and not GetBreaker(delivery.channels[delivery.channel_index]).IsAvailable()) {
+      ++delivery.channel_index;
+    }
+    if (delivery.channel_index == delivery.channels.size()) {
+      ++progress.failed;
+      continue;
+    }
+    switch (delivery.channels[delivery.channel_index]) {
+      case schemas::Notification::Type::kTelegram: {
+        BatchTemplate &batch_template = templates.at(delivery.template_id);
+        if (not batch_template.telegram_message) {
+          batch_template.telegram_message = MakeTelegramMessage(batch_template.text,
+                                                                batch_template.attachment_file,
+                                                                attachment_contents);
+        }
+        bot_deliveries[delivery.bot_index].push_back({delivery.telegram_id.value(),
+                                                      batch_template.telegram_message,
+                                                      {delivery.notification_id, batch_id}});
+        bot_delivery_indices[delivery.bot_index].push_back(index);
+        break;
+      }
+      case schemas::Notification::Type::kMail: {
+        add_contact(email_templates, delivery, delivery.email.value(), index);
+        break;
+      }
+      case schemas::Notification::Type::kSms: {
+        add_contact(sms_templates, delivery, delivery.phone_number.value(), index);
+        break;
+      }
+      case schemas::Notification::Type::kTelegramChannel: {
+        break;
+      }
+    }
+  }
+  std::vector<userver::engine::TaskWithResult<std::vector<size_t>>> channel_tasks;
+  for (size_t bot_index = 0; bot_index < bot_deliveries.size(); ++bot_index) {
+    if (bot_deliveries[bot_index].empty()) {
+      continue;
+    }
+    channel_tasks.push_back(userver::utils::Async("telegram-batch-send",
+                                                  [this, bot_index, tag, &bot_deliveries, &bot_delivery_indices, &acknowledge,
+                                                      &stopped, &progress] {
+                                                    const std::vector<size_t> &indices = bot_delivery_indices[bot_index];
+                                                    const AcknowledgeDeliveries acknowledge_positions =
+                                                        [&indices, &acknowledge](const std::vector<size_t> &positions) {
+                                                          std::vector<size_t> acknowledged;
+                                                          acknowledged.reserve(positions.size());
+                                                          for (size_t position : positions) {
+                                                            acknowledged.push_back(indices[position]);
+                                                          }
+                                                          acknowledge(acknowledged);
+                                                        };
+                                                    std::vector<size_t> bot_failed;
+                                                    for (size_t position : SendTelegramDeliveries(static_cast<int32_t>(bot_index),
+                                                                                                  bot_deliveries[bot_index],
+                                                                                                  tag,
+                                                                                                  acknowledge_positions,
+                                                                                                  stopped,
+                                                                                                  progress)) {
+                                                      bot_failed.push_back(indices[position]);
+                                                    }
+                                                    return bot_failed;
+                                                  }));
+  }
+  if (not email_templates.empty()) {
+    channel_tasks.push_back(userver::utils::Async("email-batch-send", [this, tag, &email_templates, &acknowledge, &stopped,
+                                                      &progress] {
+      return DispatchByTemplate(schemas::Notification::Type::kMail,
+                                email_templates,
+                                [this, tag, &stopped](const TemplateContacts &message, const AcceptedContacts &accepted) {
+                                  return _email_sender.SendBulk(message.name,
+                                                                message.text,
+                                                                message.contacts,
+                                                                _email_breaker,
+                                                                tag,
+                                                                accepted,
+                                                                stopped);
+                                },
+                                acknowledge,
+                                progress);
+    }));
+  }
+  if (not sms_templates.empty()) {
+    channel_tasks.push_back(userver::utils::Async("sms-batch-send", [this, tag, &sms_templates, &acknowledge, &stopped,
+                                                    &progress] {
+      return DispatchByTemplate(schemas::Notification::Type::kSms,
+                                sms_templates,
+                                [this, tag, &stopped](const TemplateContacts &message, const AcceptedContacts &accepted) {
+                                  return _sms_gateway.SendBulk(message.text,
+                                                               message.contacts,
+                                                               _sms_breaker,
+                                                               tag,
+                                                               accepted,
+                                                               stopped);
+                                },
+                                acknowledge,
+                                progress);
+    }));
+  }
+  for (auto &task : channel_tasks) {
+    const std::vector<size_t> channel_failed = task.Get();
+    failed.insert(failed.end(), channel_failed.begin(), channel_failed.end());
+  }
+  return failed;
+}
+
+std::vector<size_t> ens::notifications::NotificationsManager::DispatchByTemplate(
+    const schemas::Notification::Type &type,
+    const TemplatesContacts &templates,
+    const std::function<std::vector<std::string>(const TemplateContacts &, const AcceptedContacts &)> &send,
+    const AcknowledgeDeliveries &acknowledge,
+    BatchProgress &progress) {
+  std::vector<userver::engine::TaskWithResult<std::vector<size_t>>> template_tasks;
+  for (const auto &template_contacts : templates) {
+    template_tasks.push_back(userver::utils::Async("template-send", [&type, &send, &acknowledge, &template_contacts,
+                                                       &progress] {
+      const TemplateContacts &message = template_contacts.second;
+      // Every part of the message sent is acknowledged on its own
+      const AcceptedContacts accepted = [&message, &acknowledge](const std::vector<std::string> &contacts) {
+        std::vector<size_t> acknowledged;
+        for (const std::string &contact : contacts) {
+          const auto deliveries_it = message.contact_deliveries.find(contact);
+          if (deliveries_it != message.contact_deliveries.cend()) {
+            acknowledged.insert(acknowledged.end(), deliveries_it->second.begin(), deliveries_it->second.end());
+          }
+        }
+        acknowledge(acknowledged);
+      };
+      std::vector<size_t> failed;
+      for (const std::string &contact : send(message, accepted)) {
+        const auto deliveries_it = message.contact_deliveries.find(contact);
+        if (deliveries_it != message.contact_deliveries.cend()) {
+          failed.insert(failed.end(), deliveries_it->second.begin(), deliveries_it->second.end());
+        }
+      }
+      size_t template_deliveries = 0;
+      for (const auto &contact_deliveries : message.contact_deliveries) {
+        template_deliveries += contact_deliveries.second.size();
+      }
+      progress.sent += static_cast<int64_t>(template_deliveries - failed.size());
+      if (not failed.empty()) {
+        LOG_WARNING() << schemas::ToString(type) << " notification was not delivered to " << failed.size()
+                      << " recipients, template_id=" << boost::uuids::to_string(template_contacts.first);
+      }
+      return failed;
+    }));
+  }
+  std::vector<size_t> failed;
+  for (auto &task : template_tasks) {
+    const std::vector<size_t> template_failed = task.Get();
+    failed.insert(failed.end(), template_failed.begin(), template_failed.end());
+  }
+  return failed;
+}
+
+std::shared_ptr<const ens::notifications::NotificationsManager::TelegramMessage> ens::notifications::NotificationsManager::MakeTelegramMessage(
+    std::string text,
+    const std::optional<std::string> &attachment_file,
+    AttachmentContents &attachment_contents) const {
+  TelegramMessage message{std::move(text), std::nullopt};
+  if (not attachment_file.has_value()) {
+    return std::make_shared<const TelegramMessage>(std::move(message));
+  }
+  auto &contents = attachment_contents[attachment_file.value()];
+  if (not contents) {
+    const std::optional<std::string> path = ens::utils::resolve_attachment_path(_attachments_dir, attachment_file.value());
+    try {
+      if (not path.has_value()) {
+        throw std::runtime_error{"attachments directory is not configured"};
+      }
+      contents = std::make_shared<std::string>(userver::fs::ReadFileContents(_fs_task_processor, path.value()));
+    }
+    catch (const std::exception &e) {
+      // The message is still worth delivering without the attachment
+      LOG_ERROR() << "Error reading attachment, file_name=" << attachment_file.value() << ": " << e.what();
+      attachment_contents.erase(attachment_file.value());
+      return std::make_shared<const TelegramMessage>(std::move(message));
+    }
+  }
+  message.attachment = telegram::Attachment{attachment_file.value(),
+                                            telegram::GetAttachmentKind(attachment_file.value()),
+                                            contents};
+  return std::make_shared<const TelegramMessage>(std::move(message));
+}
+
+std::vector<boost::uuids::uuid> ens::notifications::NotificationsManager::PostToTelegramChannels(const boost::uuids::uuid &user_id,
+                                                                                              const boost::uuids::uuid &batch_id,
+                                                                                              std::vector<std::string> &notification_ids,
+                                                                                              AttachmentContents &attachment_contents,
+                                                                                              const JournaledDeliveries &journaled,
+                                                                                              const DispatchTag &tag,
+                                                                                              BatchProgress &progress) {
+  const userver::storages::postgres::Query channels_query{
+      "SELECT recipient_group.recipient_group_id, recipient_group.telegram_channel_id, notification_template.message_text, notification_template.attachment_file "
+      "FROM ens_schema.recipient_group "
+      "INNER JOIN ens_schema.notification_template ON recipient_group.template_id = notification_template.notification_template_id "
+      "WHERE recipient_group.master_id = $1 AND recipient_group.active "
+      "AND recipient_group.telegram_channel_id IS NOT NULL AND notification_template.message_text IS NOT NULL"
+  };
   userver::storages::postgres::ResultSet
-      info_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
-                                      info_query,
-                                      user_id);
-  std::optional<bool> telegram_active;
-  int64_t telegram_id;
-  std::optional<std::string> template_text;
-  boost::uuids::uuid recipient_id;
-  boost::uuids::uuid group_id;
-  std::vector<std::string> ids_vector;
-  for (auto row : info_res) {
-    telegram_active = row["active"].As<std::optional<bool>>();
-    if (not telegram_active.has_value() or not telegram_active.value()) {
+      channels_res = _hedged_reads.Execute(ens::utils::ReadClass::kFanOut,
+                                           channels_query,
+                                           user_id);
+  std::vector<boost::uuids::uuid> failed_groups;
+  for (auto row : channels_res) {
+    const auto group_id = row["recipient_group_id"].As<boost::uuids::uuid>();
+    const auto channel_id = row["telegram_channel_id"].As<int64_t>();
+    const auto journaled_it = journaled.find(std::make_pair(boost::uuids::nil_uuid(), group_id));
+    if (journaled_it != journaled.end()) {
+      // Posted before the restart
+      notification_ids.push_back(CreateNotification(schemas::Notification::Type::kTelegramChannel,
+                                                    journaled_it->second.notification_id,
+                                                    batch_id,
+                                                    std::nullopt,
+                                                    group_id));
       continue;
     }
-    template_text = row["message_text"].As<std::optional<std::string>>();
-    if (not template_text.has_value()) {
+    const std::shared_ptr<const TelegramMessage> message =
+        MakeTelegramMessage(row["message_text"].As<std::string>(),
+                            row["attachment_file"].As<std::optional<std::string>>(),
+                            attachment_contents);
+    const std::optional<CircuitBreaker::Call> breaker_call = _telegram_breaker.AllowCall();
+    if (not breaker_call.has_value()) {
+      failed_groups.push_back(group_id);
       continue;
     }
-    telegram_id = row["telegram_id"].As<int64_t>();
-    recipient_id = row["recipient_id"].As<boost::uuids::uuid>();
-    group_id = row["recipient_group_id"].As<boost::uuids::uuid>();
-    ids_vector.push_back(CreateNotification(schemas::Notification::Type::kTelegram, batch_id, recipient_id, group_id));
-    this->_telegram_bot.SendMessage(telegram_id, template_text.value());
+    // A single post reaches every subscriber of the channel, so it is recorded as one notification of the group
+    const auto started_at = std::chrono::steady_clock::now();
+    try {
+      const int32_t bot_index = telegram::TelegramNotificationsBot::kChannelBotIndex;
+      const userver::telegram::bot::AckReply ack =
+          message->attachment.has_value()
+          ? _telegram_bot.UploadAttachment(bot_index, channel_id, message->attachment.value(), message->text, tag, std::nullopt)
+          : _telegram_bot.SendMessage(bot_index, channel_id, message->text, tag, std::nullopt);
+      if (telegram::ClassifyDelivery(ack) == telegram::DeliveryStatus::Transient) {
+        _telegram_breaker.RecordFailure(breaker_call.value());
+      } else {
+        _telegram_breaker.RecordSuccess(breaker_call.value(), std::chrono::steady_clock::now() - started_at);
+      }
+      if (ack.ok) {
+        ++progress.targeted;
+        ++progress.sent;
+        const boost::uuids::uuid notification_id = userver::utils::generators::GenerateBoostUuidV7();
+        _dispatch_journal.Acknowledge(batch_id, {{notification_id,
+                                                  std::nullopt,
+                                                  group_id,
+                                                  schemas::Notification::Type::kTelegramChannel}});
+        notification_ids.push_back(CreateNotification(schemas::Notification::Type::kTelegramChannel,
+                                                      notification_id,
+                                                      batch_id,
+                                                      std::nullopt,
+                                                      group_id));
+        continue;
+      }
+      LOG_ERROR() << "Telegram channel post was not delivered, channel_id=" << channel_id
+                  << ", error_code=" << ack.error_code.value_or(0)
+                  << ", description=" << ack.description.value_or("");
+    }
+    catch (const userver::engine::TaskCancelledException &) {
+      throw;
+    }
+    catch (const std::exception &e) {
+      _telegram_breaker.RecordFailure(breaker_call.value());
+      LOG_ERROR() << "Error posting to telegram channel, channel_id=" << channel_id << ": " << e.what();
+    }
+    failed_groups.push_back(group_id);
   }
-  return std::make_unique<std::vector<std::string>>(ids_vector);
+  return failed_groups;
+}
+
+std::vector<size_t> ens::notifications::NotificationsManager::SendTelegramDeliveries(int32_t bot_index,
+                                                                                     const std::vector<TelegramDelivery> &deliveries,
+                                                                                     const DispatchTag &tag,
+                                                                                     const AcknowledgeDeliveries &acknowledge,
+                                                                                     const DispatchStopped &stopped,
+                                                                                     BatchProgress &progress) {
+  struct SendReply {
+    userver::telegram::bot::AckReply ack;
+    std::chrono::steady_clock::time_point received_at;
+  };
+  struct InFlightSend {
+    size_t position;
+    CircuitBreaker::Call breaker_call;
+    std::chrono::steady_clock::time_point started_at;
+    // Time the request left the rate limiter, the controller sees only the latency of telegram itself
+    std::chrono::steady_clock::time_point sent_at;
+    // Every reply is awaited by a task of its own, so that it is timed when it comes rather than when
+    // the send loop gets to it. Otherwise the controller would see its own pacing as the latency of telegram
+    userver::engine::TaskWithResult<SendReply> reply;
+  };
+  auto await_reply = [](telegram::SendFuture future) {
+    return userver::utils::Async("telegram-send-reply", [future = std::move(future)]() mutable {
+      userver::telegram::bot::AckReply ack = telegram::GetSendAck(future);
+      return SendReply{std::move(ack), std::chrono::steady_clock::now()};
+    });
+  };
+  // Messages are sent asynchronously, the controller of the bot sets how many replies are awaited at the same time
+  ConcurrencyController &concurrency = *_telegram_concurrency.at(bot_index);
+  std::deque<InFlightSend> in_flight;
+  // file_id is bot specific, every attachment is uploaded once by each bot and then resent by file_id
+  std::unordered_map<std::string, std::string> uploaded_file_ids;
+  std::vector<size_t> failed;
+  // Chats which will never accept messages are deactivated so that later batches skip them
+  std::vector<int64_t> unreachable_ids;
+  std::vector<int64_t> migrated_old_ids;
+  std::vector<int64_t> migrated_new_ids;
+  auto flush_unreachable = [this, &unreachable_ids, &migrated_old_ids, &migrated_new_ids]() {
+    try {
+      _telegram_bot.DeactivateContacts(unreachable_ids);
+      _telegram_bot.MigrateContacts(migrated_old_ids, migrated_new_ids);
+    }
+    catch (const std::exception &e) {
+      LOG_ERROR() << "Error deactivating unreachable telegram contacts: " << e.what();
+    }
+    unreachable_ids.clear();
+    migrated_old_ids.clear();
+    migrated_new_ids.clear();
+  };
+  // A notification whose chat has been upgraded to a supergroup is sent again to the new chat, once
+  std::unordered_map<size_t, int64_t> migrated_chat_ids;
+  std::vector<size_t> resends;
+  auto chat_id_of = [&deliveries, &migrated_chat_ids](size_t position) {
+    const auto migrated_it = migrated_chat_ids.find(position);
+    return migrated_it == migrated_chat_ids.cend() ? deliveries[position].telegram_id : migrated_it->second;
+  };
+  // Only the transient errors are blamed on telegram, the other ones are specific to the recipient
+  auto handle_ack = [&](size_t position,
+                        const CircuitBreaker::Call &breaker_call,
+                        std::chrono::steady_clock::duration latency,
+                        const userver::telegram::bot::AckReply &ack) {
+    const int64_t sent_telegram_id = chat_id_of(position);
+    const telegram::DeliveryStatus status = telegram::ClassifyDelivery(ack);
+    if (status == telegram::DeliveryStatus::Transient) {
+      _telegram_breaker.RecordFailure(breaker_call);
+    } else {
+      _telegram_breaker.RecordSuccess(breaker_call, latency);
+    }
+    const bool resent = status == telegram::DeliveryStatus::Migrated
+        and migrated_chat_ids.emplace(position, ack.migrate_to_chat_id.value()).second;
+    if (status != telegram::DeliveryStatus::Delivered and not resent) {
+      failed.push_back(position);
+    }
+    switch (status) {
+      case telegram::DeliveryStatus::Delivered: {
+        ++progress.sent;
+        acknowledge({position});
+        break;
+      }
+      case telegram::DeliveryStatus::Blocked:
+      case telegram::DeliveryStatus::ChatNotFound: {
+        unreachable_ids.push_back(sent_telegram_id);
+        break;
+      }
+      case telegram::DeliveryStatus::Migrated: {
+        migrated_old_ids.push_back(sent_telegram_id);
+        migrated_new_ids.push_back(ack.migrate_to_chat_id.value());
+        if (resent) {
+          resends.push_back(position);
+        }
+        break;
+      }
+      case telegram::DeliveryStatus::Transient: {
+        LOG_WARNING() << "Telegram notification was not delivered, telegram_id=" << sent_telegram_id
+                      << ", bot_index=" << bot_index
+                      << ", error_code=" << ack.error_code.value_or(0)
+                      << ", description=" << ack.description.value_or("");
+        break;
+      }
+    }
+    if (unreachable_ids.size() + migrated_old_ids.size() >= kUnreachableContactsFlushSize) {
+      flush_unreachable();
+    }
+  };
+  auto await_oldest = [&]() {
+    InFlightSend &sent = in_flight.front();
+    try {
+      const SendReply reply = sent.reply.Get();
+      const int error_code = reply.ack.error_code.value_or(0);
+      if (error_code == 429 or error_code >= 500) {
+        concurrency.RecordOverload();
+      } else {
+        concurrency.RecordSuccess(reply.received_at - sent.sent_at);
+      }
+      handle_ack(sent.position, sent.breaker_call, reply.received_at - sent.started_at, reply.ack);
+    }
+    catch (const std::exception &e) {
+      concurrency.RecordOverload();
+      _telegram_breaker.RecordFailure(sent.breaker_call);
+      failed.push_back(sent.position);
+      LOG_ERROR() << "Error sending telegram notification, telegram_id=" << chat_id_of(sent.position)
+                  << ": " << e.what();
+    }
+    in_flight.pop_front();
+  };
+  // Returns false once the dispatch has stopped
+  auto send = [&](size_t position) {
+    const TelegramDelivery &delivery = deliveries[position];
+    const TelegramMessage &message = *delivery.message;
+    const int64_t chat_id = chat_id_of(position);
+    if (stopped()) {
+      return false;
+    }
+    const std::optional<CircuitBreaker::Call> breaker_call = _telegram_breaker.AllowCall();
+    if (not breaker_call.has_value()) {
+      failed.push_back(position);
+      return true;
+    }
+    const auto started_at = std::chrono::steady_clock::now();
+    if (message.attachment.has_value()) {
+      const telegram::Attachment &attachment = message.attachment.value();
+      const auto file_id_it = uploaded_file_ids.find(attachment.file_name);
+      if (file_id_it == uploaded_file_ids.cend()) {
+        // The upload is awaited so that the following recipients get the file by its file_id
+        try {
+          const userver::telegram::bot::AckReply ack = _telegram_bot.UploadAttachment(bot_index,
+                                                                                      chat_id,
+                                                                                      attachment,
+                                                                                      message.text,
+                                                                                      tag,
+                                                                                      delivery.response_target);
+          if (ack.file_id.has_value()) {
+            uploaded_file_ids.emplace(attachment.file_name, ack.file_id.value());
+          }
+          handle_ack(position, breaker_call.value(), std::chrono::steady_clock::now() - started_at, ack);
+        }
+        catch (const userver::engine::TaskCancelledException &) {
+          throw;
+        }
+        catch (const std::exception &e) {
+          _telegram_breaker.RecordFailure(breaker_call.value());
+          failed.push_back(position);
+          LOG_ERROR() << "Error uploading telegram attachment, telegram_id=" << chat_id << ": " << e.what();
+        }
+        return true;
+      }
+      // A cut limit is reached by awaiting several replies
+      while (not in_flight.empty() and in_flight.size() >= concurrency.GetLimit()) {
+        await_oldest();
+      }
+      if (stopped()) {
+        return false;
+      }
+      telegram::SendFuture future = _telegram_bot.SendAttachmentAsync(bot_index,
+                                                                      chat_id,
+                                                                      attachment.kind,
+                                                                      file_id_it->second,
+                                                                      message.text,
+                                                                      tag,
+                                                                      delivery.response_target);
+      in_flight.push_back({position,
+                         breaker_call.value(),
+                         started_at,
+                         std::chrono::steady_clock::now(),
+                         await_reply(std::move(future))});
+      return true;
+    }
+    while (not in_flight.empty() and in_flight.size() >= concurrency.GetLimit()) {
+      await_oldest();
+    }
+    // Awaiting the replies may take long enough for the lease to be lost
+    if (stopped()) {
+      return false;
+    }
+    telegram::SendFuture future = this->_telegram_bot.SendMessageAsync(bot_index,
+                                                                       chat_id,
+                                                                       message.text,
+                                                                       tag,
+                                                                       delivery.response_target);
+    in_flight.push_back({position,
+                         breaker_call.value(),
+                         started_at,
+                         std::chrono::steady_clock::now(),
+                         await_reply(std::move(future))});
+    return true;
+  };
+  bool sending = true;
+  for (size_t position = 0; sending and position < deliveries.size(); ++position) {
+    sending = send(position);
+  }
+  // The notifications of the migrated chats are sent again in the same round, as their replies come
+  for (;;) {
+    while (not in_flight.empty()) {
+      await_oldest();
+    }
+    if (not sending or resends.empty()) {
+      break;
+    }
+    const std::vector<size_t> migrated = std::move(resends);
+    resends.clear();
+    for (size_t i = 0; sending and i < migrated.size(); ++i) {
+      sending = send(migrated[i]);
+    }
+  }
+  flush_unreachable();
+  return failed;
 }
 
 void ens::notifications::NotificationsManager::CancelNotification(const boost::uuids::uuid &user_id,
@@ -2,13 +2,34 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
 #include <userver/components/component.hpp>
 #include <userver/components/component_list.hpp>
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
 #include <userver/storages/postgres/cluster.hpp>
 #include <userver/storages/postgres/component.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/utils/statistics/writer.hpp>
 
 #include "utils/utils.hpp"
+#include "utils/hedged_reads.hpp"
 #include "schemas/schemas.hpp"
+#include "notifications/batch_progress.hpp"
+#include "notifications/circuit_breaker.hpp"
+#include "notifications/concurrency_controller.hpp"
+#include "notifications/dispatch_journal.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+#include "notifications/notifications_writer.hpp"
+#include "notifications/partition_leases.hpp"
+#include "notifications/email/email_sender.hpp"
+#include "notifications/sms/sms_gateway.hpp"
+#include "notifications/telegram/attachments.hpp"
 #include "notifications/telegram/telegram_bot.hpp"
 
 namespace ens::notifications {
@@ -16,6 +37,13 @@ namespace ens::notifications {
 class NotificationsManager : public userver::components::ComponentBase {
  public:
   static constexpr std::string_view kName = "notification-manager";
+  static constexpr size_t kDefaultMaxInFlightSends = 256;
+  static constexpr size_t kUnreachableContactsFlushSize = 1000;
+  static constexpr std::string_view kDefaultFsTaskProcessor = "fs-task-processor";
+  static constexpr int32_t kDefaultDispatchPartitions = 1;
+  static constexpr std::chrono::milliseconds kDefaultPartitionLeaseDuration{10000};
+  static constexpr std::chrono::milliseconds kDefaultPartitionPollInterval{100};
+  static constexpr BatchPartition kWholeBatch{0, 1};
   NotificationsManager(const userver::components::ComponentConfig &config,
                        const userver::components::ComponentContext &component_context) :
       ComponentBase(config, component_context),
@@ -23,24 +51,208 @@ class NotificationsManager : public userver::components::ComponentBase {
           component_context
               .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
               .GetCluster()),
-      _telegram_bot(component_context.FindComponent<ens::notifications::telegram::TelegramNotificationsBot>()) {}
+      _telegram_bot(component_context.FindComponent<ens::notifications::telegram::TelegramNotificationsBot>()),
+      _email_sender(component_context.FindComponent<ens::notifications::email::EmailSender>()),
+      _sms_gateway(component_context.FindComponent<ens::notifications::sms::SmsGateway>()),
+      _progress_tracker(component_context.FindComponent<BatchProgressTracker>()),
+      _notifications_writer(component_context.FindComponent<NotificationsWriter>()),
+      _dispatch_journal(component_context.FindComponent<DispatchJournal>()),
+      _hedged_reads(component_context.FindComponent<ens::utils::HedgedReads>()),
+      _max_in_flight_sends(config["max-in-flight-sends"].As<size_t>(kDefaultMaxInFlightSends)),
+      _fs_task_processor(component_context.GetTaskProcessor(config["fs-task-processor"].As<std::string>(kDefaultFsTaskProcessor))),
+      _attachments_dir(config["attachments-dir"].As<std::string>("")),
+      _channel_priority(ParseChannelPriority(config["channel-priority"])),
+      _telegram_breaker("telegram", ParseCircuitBreakerSettings(config["circuit-breaker"])),
+      _email_breaker("email", ParseCircuitBreakerSettings(config["circuit-breaker"])),
+      _sms_breaker("sms", ParseCircuitBreakerSettings(config["circuit-breaker"])),
+      _dispatch_partitions(config["dispatch-partitions"].As<int32_t>(kDefaultDispatchPartitions)),
+      _partition_poll_interval(config["partition-poll-interval"].As<std::chrono::milliseconds>(
+          kDefaultPartitionPollInterval)),
+      _partition_leases(_pg_cluster,
+                        config["partition-lease-duration"].As<std::chrono::milliseconds>(
+                            kDefaultPartitionLeaseDuration)) {
+    // Every bot has limits of its own, so its sends are controlled separately
+    const ConcurrencyControllerSettings concurrency_settings =
+        ParseConcurrencyControllerSettings(config["concurrency-control"], _max_in_flight_sends);
+    for (size_t i = 0; i < _telegram_bot.GetBotsCount(); ++i) {
+      _telegram_concurrency.push_back(std::make_unique<ConcurrencyController>(concurrency_settings));
+    }
+    _statistics_holder = component_context.FindComponent<userver::components::StatisticsStorage>().GetStorage()
+        .RegisterWriter("ens.send-concurrency", [this](userver::utils::statistics::Writer &writer) {
+          WriteStatistics(writer);
+        });
+  }
+  ~NotificationsManager() override { _statistics_holder.Unregister(); }
 
   static userver::yaml_config::Schema GetStaticConfigSchema();
-  std::string CreateBatch(const boost::uuids::uuid &user_id);
+  std::string CreateBatch(const boost::uuids::uuid &user_id, BatchPriority priority);
   std::unique_ptr<schemas::Notification> GetById(const boost::uuids::uuid &user_id,
                                                  const boost::uuids::uuid &notification_id) const;
   std::unique_ptr<schemas::NotificationList> GetAll(const boost::uuids::uuid &user_id) const;
   std::unique_ptr<schemas::NotificationList> GetPending(const boost::uuids::uuid &user_id) const;
   std::unique_ptr<std::vector<std::string>> SendBatch(const boost::uuids::uuid &user_id,
                                                       const boost::uuids::uuid &batch_id);
+  // Sends the batch if it is still scheduled at scheduled_at, returns false if it has been rescheduled or sent
+  bool SendScheduledBatch(const boost::uuids::uuid &batch_id, int64_t scheduled_at);
+  // Sends the rest of a batch whose dispatch was interrupted by a restart
+  void ResumeBatch(const UnfinishedBatch &batch);
+  // Claims a partition of a batch sent through any instance whose lease isn't held
+  std::optional<PartitionClaim> ClaimPartition();
+  void DispatchPartition(const PartitionClaim &claim);
+  // Counters of the batch, kept up to date by the dispatch on this instance and reloaded from the others
+  std::shared_ptr<const BatchProgress> WatchBatch(const boost::uuids::uuid &user_id, const boost::uuids::uuid &batch_id);
+  BatchProgressSnapshot GetBatchSummary(const boost::uuids::uuid &user_id, const boost::uuids::uuid &batch_id);
+  // Live counts of the statuses reported by the recipients of the batch
+  telegram::ResponseTally GetBatchResponses(const boost::uuids::uuid &user_id, const boost::uuids::uuid &batch_id);
   void CancelNotification(const boost::uuids::uuid &user_id, const boost::uuids::uuid &notification_id);
  private:
   userver::storages::postgres::ClusterPtr _pg_cluster;
   ens::notifications::telegram::TelegramNotificationsBot &_telegram_bot;
+  ens::notifications::email::EmailSender &_email_sender;
+  ens::notifications::sms::SmsGateway &_sms_gateway;
+  BatchProgressTracker &_progress_tracker;
+  NotificationsWriter &_notifications_writer;
+  DispatchJournal &_dispatch_journal;
+  ens::utils::HedgedReads &_hedged_reads;
+  const size_t _max_in_flight_sends;
+  userver::engine::TaskProcessor &_fs_task_processor;
+  const std::string _attachments_dir;
+  // Channels tried in turn after the preferred channel of the recipient
+  const std::vector<schemas::Notification::Type> _channel_priority;
+  CircuitBreaker _telegram_breaker;
+  CircuitBreaker _email_breaker;
+  CircuitBreaker _sms_breaker;
+  // Number of the parts the recipients of a batch are split into, dispatched by all the instances of the service
+  const int32_t _dispatch_partitions;
+  const std::chrono::milliseconds _partition_poll_interval;
+  PartitionLeases _partition_leases;
+  std::vector<std::unique_ptr<ConcurrencyController>> _telegram_concurrency;
+  userver::utils::statistics::Entry _statistics_holder;
+  void WriteStatistics(userver::utils::statistics::Writer &writer) const;
+  static std::vector<schemas::Notification::Type> ParseChannelPriority(const userver::yaml_config::YamlConfig &config);
+  CircuitBreaker &GetBreaker(const schemas::Notification::Type &type);
+  struct TelegramMessage {
+    std::string text;
+    std::optional<telegram::Attachment> attachment;
+  };
+  struct TelegramDelivery {
+    int64_t telegram_id;
+    std::shared_ptr<const TelegramMessage> message;
+    telegram::ResponseTarget response_target;
+  };
+  using AttachmentContents = std::unordered_map<std::string, std::shared_ptr<std::string>>;
+  std::shared_ptr<const TelegramMessage> MakeTelegramMessage(std::string text,
+                                                             const std::optional<std::string> &attachment_file,
+                                                             AttachmentContents &attachment_contents) const;
+  // Receives the deliveries accepted by their channel as their replies come
+  using AcknowledgeDeliveries = std::function<void(const std::vector<size_t> &)>;
+  // Checked before every send, returns true once the rest of the deliveries must not be sent
+  using DispatchStopped = std::function<bool()>;
+  // Returns the positions of the deliveries which were not accepted, the ones left unsent once the dispatch
+  // has stopped are not among them
+  std::vector<size_t> SendTelegramDeliveries(int32_t bot_index,
+                                             const std::vector<TelegramDelivery> &deliveries,
+                                             const DispatchTag &tag,
+                                             const AcknowledgeDeliveries &acknowledge,
+                                             const DispatchStopped &stopped,
+                                             BatchProgress &progress);
+  // Notifications delivered before a restart, keyed by their recipient (nil for a channel post) and group
+  using JournaledDeliveries = std::unordered_map<std::pair<boost::uuids::uuid, boost::uuids::uuid>,
+                                                 DeliveryAck,
+                                                 boost::hash<std::pair<boost::uuids::uuid, boost::uuids::uuid>>>;
+  static JournaledDeliveries ToJournaledDeliveries(const std::vector<DeliveryAck> &delivered);
+  // Returns the groups whose channel post failed, their recipients are messaged directly instead
+  std::vector<boost::uuids::uuid> PostToTelegramChannels(const boost::uuids::uuid &user_id,
+                                                         const boost::uuids::uuid &batch_id,
+                                                         std::vector<std::string> &notification_ids,
+                                                         AttachmentContents &attachment_contents,
+                                                         const JournaledDeliveries &journaled,
+                                                         const DispatchTag &tag,
+                                                         BatchProgress &progress);
+  // Template of the notified groups, shared by all their recipients
+  struct BatchTemplate {
+    std::string name;
+    std::string text;
+    std::optional<std::string> attachment_file;
+    std::shared_ptr<const TelegramMessage> telegram_message;
+  };
+  using BatchTemplates = std::unordered_map<boost::uuids::uuid, BatchTemplate, boost::hash<boost::uuids::uuid>>;
+  // Notification of a recipient on behalf of a group, moves along its channels until one of them accepts it.
+  // Its id is known before the send, so that the recipient can respond to it right away
+  struct RoutedDelivery {
+    boost::uuids::uuid notification_id;
+    boost::uuids::uuid recipient_id;
+    boost::uuids::uuid group_id;
+    boost::uuids::uuid template_id;
+    std::optional<int64_t> telegram_id;
+    int32_t bot_index;
+    std::optional<std::string> email;
+    std::optional<std::string> phone_number;
+    std::vector<schemas::Notification::Type> channels;
+    size_t channel_index = 0;
+  };
+  std::vector<schemas::Notification::Type> ChooseChannels(const RoutedDelivery &delivery,
+                                                          const std::optional<schemas::Notification::Type> &preferred_channel) const;
+  // Sends every pending delivery over its current channel, returns the ones which have to fall back
+  std::vector<size_t> DispatchRound(const boost::uuids::uuid &batch_id,
+                                    const std::vector<size_t> &pending,
+                                    std::vector<RoutedDelivery> &deliveries,
+                                    BatchTemplates &templates,
+                                    AttachmentContents &attachment_contents,
+                                    const DispatchTag &tag,
+                                    const AcknowledgeDeliveries &acknowledge,
+                                    const DispatchStopped &stopped,
+                                    BatchProgress &progress);
+  // Recipients of the groups sharing a template get a single message addressed to all of them
+  struct TemplateContacts {
+    std::string name;
+    std::string text;
+    std::vector<std::string> contacts;
+    std::unordered_map<std::string, std::vector<size_t>> contact_deliveries;
+  };
+  using TemplatesContacts = std::unordered_map<boost::uuids::uuid, TemplateContacts, boost::hash<boost::uuids::uuid>>;
+  // Receives the contacts a part of the message has been accepted for
+  using AcceptedContacts = std::function<void(const std::vector<std::string> &)>;
+  // Templates are sent concurrently, send returns the contacts the message was not delivered to.
+  // Returns the deliveries of these contacts
+  static std::vector<size_t> DispatchByTemplate(const schemas::Notification::Type &type,
+                                                const TemplatesContacts &templates,
+                                                const std::function<std::vector<std::string>(const TemplateContacts &,
+                                                                                             const AcceptedContacts &)> &send,
+                                                const AcknowledgeDeliveries &acknowledge,
+                                                BatchProgress &progress);
+  // Journals the batch claimed by this instance and dispatches it
+  std::unique_ptr<std::vector<std::string>> DispatchClaimed(const boost::uuids::uuid &batch_id, const DispatchTag &tag);
+  // Dispatches the batch claimed by this instance, the delivered notifications are only recorded
+  std::unique_ptr<std::vector<std::string>> DispatchBatch(const boost::uuids::uuid &batch_id,
+                                                          const DispatchTag &tag,
+                                                          const std::vector<DeliveryAck> &delivered,
+                                                          bool resumed);
+  // Splits the batch into partitions leased by the instances of the service, waits until all of them are dispatched
+  std::unique_ptr<std::vector<std::string>> DispatchPartitioned(const boost::uuids::uuid &batch_id,
+                                                                const DispatchTag &tag);
+  // Sends the notifications of the recipients in the partition and writes their rows. The claim is null
+  // for a batch dispatched as a whole. Returns false if the partition lease was lost and the dispatch stopped
+  bool DispatchRecipients(const boost::uuids::uuid &batch_id,
+                          const DispatchTag &tag,
+                          const std::vector<boost::uuids::uuid> &direct_groups,
+                          const BatchPartition &partition,
+                          const PartitionClaim *claim,
+                          const JournaledDeliveries &journaled,
+                          bool resumed,
+                          std::vector<std::string> &notification_ids,
+                          AttachmentContents &attachment_contents,
+                          BatchProgress &progress);
   std::string CreateNotification(const schemas::Notification::Type &type,
+                                 const boost::uuids::uuid &notification_id,
                                  const boost::uuids::uuid &batch_id,
-                                 const boost::uuids::uuid &recipient_id,
+                                 const std::optional<boost::uuids::uuid> &recipient_id,
                                  const boost::uuids::uuid &group_id);
+  void CreateNotifications(const schemas::Notification::Type &type,
+                           const boost::uuids::uuid &batch_id,
+                           const std::vector<boost::uuids::uuid> &notification_ids,
+                           const std::vector<boost::uuids::uuid> &recipient_ids,
+                           const std::vector<boost::uuids::uuid> &group_ids);
 };
 
 void AppendNotificationsManager(userver::components::ComponentList &component_list);
@@ -56,6 +268,16 @@ class NotificationNotFoundException : public std::exception {
   noexcept override { return this->_msg.c_str(); };
 };
 
+class IncorrectPriorityException : public std::exception {
+ private:
+  static constexpr std::string_view FORMAT{"Incorrect batch priority={}"};
+  const std::string _msg;
+ public:
+  IncorrectPriorityException(const std::string &priority) : _msg(fmt::format(this->FORMAT, priority)) {};
+  [[nodiscard]] const char *what() const
+  noexcept override { return this->_msg.c_str(); };
+};
+
 class NotificationBatchNotFoundException : public std::exception {
  private:
   static constexpr std::string_view FORMAT{"Notifications batch does not exist/has already been sent batch_id={}"};
@@ -0,0 +1,259 @@
+#include "notifications_writer.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <mutex>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <fmt/format.h>
+#include <userver/fs/blocking/read.hpp>
+#include <userver/fs/blocking/write.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+namespace {
+constexpr std::string_view kSegmentPrefix = "notifications-";
+constexpr std::string_view kSegmentSuffix = ".journal";
+
+// A journal entry is a line of tab separated fields, a dash stands for a missing recipient
+std::string SerializeRecord(const ens::notifications::NotificationRecord &record) {
+  return fmt::format("{}\t{}\t{}\t{}\t{}\t{}\n",
+                     schemas::kschemas_Notification_Type_Mapping.TryFindByFirst(record.type).value(),
+                     record.creation_timestamp,
+                     boost::uuids::to_string(record.notification_id),
+                     boost::uuids::to_string(record.batch_id),
+                     record.recipient_id.has_value() ? boost::uuids::to_string(record.recipient_id.value()) : "-",
+                     boost::uuids::to_string(record.group_id));
+}
+
+std::optional<ens::notifications::NotificationRecord> ParseRecord(std::string_view line) {
+  std::vector<std::string_view> fields;
+  for (size_t field_start = 0;;) {
+    const size_t field_end = line.find('\t', field_start);
+    fields.push_back(line.substr(field_start, field_end - field_start));
+    if (field_end == std::string_view::npos) {
+      break;
+    }
+    field_start = field_end + 1;
+  }
+  if (fields.size() != 6) {
+    return std::nullopt;
+  }
+  try {
+    ens::notifications::NotificationRecord record{
+        schemas::FromString(fields[0], userver::formats::parse::To<schemas::Notification::Type>{}),
+        boost::lexical_cast<int64_t>(fields[1]),
+        boost::lexical_cast<boost::uuids::uuid>(fields[2]),
+        boost::lexical_cast<boost::uuids::uuid>(fields[3]),
+        std::nullopt,
+        boost::lexical_cast<boost::uuids::uuid>(fields[5])};
+    if (fields[4] != "-") {
+      record.recipient_id = boost::lexical_cast<boost::uuids::uuid>(fields[4]);
+    }
+    return record;
+  }
+  catch (const std::exception &) {
+    return std::nullopt;
+  }
+}
+}
+
+userver::yaml_config::Schema ens::notifications::NotificationsWriter::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component writing the notification rows of the sent batches
+    additionalProperties: false
+    properties:
+        write-behind:
+            type: boolean
+            description: Buffer the rows and insert them asynchronously, so that the sends don't wait for the commits
+            defaultDescription: false
+        journal-dir:
+            type: string
+            description: Directory of the journal keeping the buffered rows over a crash, required in the write-behind mode
+        flush-interval:
+            type: string
+            description: Period of inserting the buffered rows in the write-behind mode
+            defaultDescription: 100ms
+        max-batch-size:
+            type: integer
+            description: Maximum number of rows inserted by a single statement
+            defaultDescription: 10000
+            minimum: 1
+        fs-task-processor:
+            type: string
+            description: Task processor for the journal access
+            defaultDescription: fs-task-processor
+  )");
+}
+
+void ens::notifications::NotificationsWriter::Write(const std::vector<NotificationRecord> &records) {
+  if (records.empty()) {
+    return;
+  }
+  if (not _write_behind) {
+    Insert(records);
+    return;
+  }
+  std::string entries;
+  for (const NotificationRecord &record : records) {
+    entries += SerializeRecord(record);
+  }
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  userver::utils::Async(_fs_task_processor, "notifications-journal-append", [this, &entries] {
+    _journal->Write(entries);
+    _journal->FSync();
+  }).Get();
+  _pending.insert(_pending.end(), records.cbegin(), records.cend());
+}
+
+std::string ens::notifications::NotificationsWriter::GetSegmentPath(uint64_t segment) const {
+  // Sequence numbers are padded, so that the segments are listed in the order of writing
+  return fmt::format("{}/{}{:020}{}", _journal_dir, kSegmentPrefix, segment, kSegmentSuffix);
+}
+
+void ens::notifications::NotificationsWriter::StartSegment() {
+  const uint64_t segment = _segment + 1;
+  const std::string path = GetSegmentPath(segment);
+  userver::utils::Async(_fs_task_processor, "notifications-journal-start", [this, &path] {
+    userver::fs::blocking::FileDescriptor journal = userver::fs::blocking::FileDescriptor::Open(
+        path,
+        {userver::fs::blocking::OpenFlag::kWrite, userver::fs::blocking::OpenFlag::kCreateIfNotExists,
+         userver::fs::blocking::OpenFlag::kAppend});
+    if (_journal.has_value()) {
+      std::move(_journal.value()).Close();
+    }
+    _journal.emplace(std::move(journal));
+  }).Get();
+  _segment = segment;
+}
+
+void ens::notifications::NotificationsWriter::Recover() {
+  size_t skipped = 0;
+  userver::utils::Async(_fs_task_processor, "notifications-journal-recover", [this, &skipped] {
+    userver::fs::blocking::CreateDirectories(_journal_dir);
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    for (const auto &entry : std::filesystem::directory_iterator(_journal_dir)) {
+      const std::string name = entry.path().filename().string();
+      if (name.size() <= kSegmentPrefix.size() + kSegmentSuffix.size()
+          or name.compare(0, kSegmentPrefix.size(), kSegmentPrefix) != 0
+          or name.compare(name.size() - kSegmentSuffix.size(), kSegmentSuffix.size(), kSegmentSuffix) != 0) {
+        continue;
+      }
+      const std::string sequence =
+          name.substr(kSegmentPrefix.size(), name.size() - kSegmentPrefix.size() - kSegmentSuffix.size());
+      segments.emplace_back(boost::lexical_cast<uint64_t>(sequence), entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    for (const auto &[segment, path] : segments) {
+      const std::string contents = userver::fs::blocking::ReadFileContents(path);
+      // The last line may be torn by the crash, only the complete lines are replayed
+      for (size_t line_start = 0, line_end; (line_end = contents.find('\n', line_start)) != std::string::npos;
+           line_start = line_end + 1) {
+        std::optional<NotificationRecord> record =
+            ParseRecord(std::string_view{contents}.substr(line_start, line_end - line_start));
+        if (record.has_value()) {
+          _pending.push_back(std::move(record.value()));
+        } else {
+          ++skipped;
+        }
+      }
+      _closed_segments.push_back(segment);
+      _segment = std::max(_segment, segment);
+    }
+  }).Get();
+  if (not _pending.empty() or skipped != 0) {
+    LOG_WARNING() << "Recovered " << _pending.size() << " unwritten notifications from "
+                  << _closed_segments.size() << " journal segments, skipped=" << skipped;
+  }
+  StartSegment();
+}
+
+void ens::notifications::NotificationsWriter::Flush() {
+  std::vector<NotificationRecord> records;
+  std::vector<uint64_t> segments;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    if (_pending.empty()) {
+      return;
+    }
+    // The rows written from now on go to the next segment, so that the flushed ones can be removed whole
+    const uint64_t flushed_segment = _segment;
+    StartSegment();
+    segments.swap(_closed_segments);
+    segments.push_back(flushed_segment);
+    records.swap(_pending);
+  }
+  try {
+    Insert(records);
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error writing " << records.size() << " notifications: " << e.what();
+    // Rows are retried by the next flush, their segments are kept until then
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    _pending.insert(_pending.end(), std::make_move_iterator(records.begin()), std::make_move_iterator(records.end()));
+    _closed_segments.insert(_closed_segments.end(), segments.cbegin(), segments.cend());
+    return;
+  }
+  userver::utils::Async(_fs_task_processor, "notifications-journal-remove", [this, &segments] {
+    for (uint64_t segment : segments) {
+      userver::fs::blocking::RemoveSingleFile(GetSegmentPath(segment));
+    }
+  }).Get();
+}
+
+void ens::notifications::NotificationsWriter::Insert(const std::vector<NotificationRecord> &records) {
+  // Replayed rows may have been committed before the crash, the rows of the deleted batches,
+  // recipients and groups are dropped instead of failing the whole batch
+  const userver::storages::postgres::Query insert_query{
+      "INSERT INTO ens_schema.notification "
+      "(type, creation_timestamp, notification_id, batch_id, recipient_id, group_id) "
+      "SELECT records.type, records.creation_timestamp, records.notification_id, "
+      "notifications_batch.batch_id, recipient.recipient_id, records.group_id "
+      "FROM UNNEST($1::ens_schema.message_type[], $2::BIGINT[], $3::uuid[], $4::uuid[], $5::uuid[], $6::uuid[]) "
+      "AS records(type, creation_timestamp, notification_id, batch_id, recipient_id, group_id) "
+      "INNER JOIN ens_schema.recipient_group ON records.group_id = recipient_group.recipient_group_id "
+      "LEFT JOIN ens_schema.notifications_batch ON records.batch_id = notifications_batch.batch_id "
+      "LEFT JOIN ens_schema.recipient ON records.recipient_id = recipient.recipient_id "
+      "WHERE records.recipient_id = $7 OR recipient.recipient_id IS NOT NULL "
+      "ON CONFLICT (notification_id) DO NOTHING"
+  };
+  userver::storages::postgres::Transaction insert_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  for (size_t chunk_start = 0; chunk_start < records.size(); chunk_start += _max_batch_size) {
+    const size_t chunk_end = std::min(records.size(), chunk_start + _max_batch_size);
+    std::vector<schemas::Notification::Type> types;
+    std::vector<int64_t> creation_timestamps;
+    std::vector<boost::uuids::uuid> notification_ids;
+    std::vector<boost::uuids::uuid> batch_ids;
+    std::vector<boost::uuids::uuid> recipient_ids;
+    std::vector<boost::uuids::uuid> group_ids;
+    for (size_t i = chunk_start; i < chunk_end; ++i) {
+      const NotificationRecord &record = records[i];
+      types.push_back(record.type);
+      creation_timestamps.push_back(record.creation_timestamp);
+      notification_ids.push_back(record.notification_id);
+      batch_ids.push_back(record.batch_id);
+      // Arrays don't take nulls, the nil uuid marks the channel posts
+      recipient_ids.push_back(record.recipient_id.value_or(boost::uuids::nil_uuid()));
+      group_ids.push_back(record.group_id);
+    }
+    insert_transaction.Execute(insert_query,
+                               types,
+                               creation_timestamps,
+                               notification_ids,
+                               batch_ids,
+                               recipient_ids,
+                               group_ids,
+                               boost::uuids::nil_uuid());
+  }
+  insert_transaction.Commit();
+}
+
+void ens::notifications::AppendNotificationsWriter(userver::components::ComponentList &component_list) {
+  component_list.Append<NotificationsWriter>();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/fs/blocking/file_descriptor.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "utils/utils.hpp"
+#include "schemas/schemas.hpp"
+
+namespace ens::notifications {
+struct NotificationRecord {
+  schemas::Notification::Type type;
+  int64_t creation_timestamp;
+  boost::uuids::uuid notification_id;
+  boost::uuids::uuid batch_id;
+  // nullopt for a channel post delivered to the whole group
+  std::optional<boost::uuids::uuid> recipient_id;
+  boost::uuids::uuid group_id;
+};
+
+// Component writing the notification rows of the sent batches. In the write-behind mode the rows are appended
+// to a local journal and buffered, then inserted by a periodic flush in large batches. The journal segments
+// are removed once their rows are committed, the ones left by a crash are replayed on start
+class NotificationsWriter : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "notifications-writer";
+  static constexpr std::chrono::milliseconds kDefaultFlushInterval{100};
+  static constexpr size_t kDefaultMaxBatchSize = 10000;
+  static constexpr std::string_view kDefaultFsTaskProcessor = "fs-task-processor";
+  NotificationsWriter(const userver::components::ComponentConfig &config,
+                      const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _pg_cluster(
+          component_context
+              .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
+              .GetCluster()),
+      _fs_task_processor(component_context.GetTaskProcessor(config["fs-task-processor"].As<std::string>(kDefaultFsTaskProcessor))),
+      _write_behind(config["write-behind"].As<bool>(false)),
+      _journal_dir(config["journal-dir"].As<std::string>("")),
+      _max_batch_size(config["max-batch-size"].As<size_t>(kDefaultMaxBatchSize)) {
+    if (not _write_behind) {
+      return;
+    }
+    if (_journal_dir.empty()) {
+      throw std::runtime_error{"journal-dir is required in the write-behind mode"};
+    }
+    Recover();
+    _flush_task.Start("notifications-writer-flush",
+                      {config["flush-interval"].As<std::chrono::milliseconds>(kDefaultFlushInterval)},
+                      [this] { Flush(); });
+  }
+  ~NotificationsWriter() override {
+    _flush_task.Stop();
+    if (_write_behind) {
+      Flush();
+    }
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Returns once the rows are committed or, in the write-behind mode, synced to the journal
+  void Write(const std::vector<NotificationRecord> &records);
+ private:
+  std::string GetSegmentPath(uint64_t segment) const;
+  // Closes the current journal segment and starts the next one, called under the lock
+  void StartSegment();
+  // Loads the rows of the segments left unflushed by the previous run
+  void Recover();
+  void Flush();
+  void Insert(const std::vector<NotificationRecord> &records);
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  userver::engine::TaskProcessor &_fs_task_processor;
+  const bool _write_behind;
+  const std::string _journal_dir;
+  const size_t _max_batch_size;
+  userver::engine::Mutex _mutex;
+  std::vector<NotificationRecord> _pending;
+  std::optional<userver::fs::blocking::FileDescriptor> _journal;
+  uint64_t _segment = 0;
+  // Closed segments whose rows are pending
+  std::vector<uint64_t> _closed_segments;
+  userver::utils::PeriodicTask _flush_task;
+};
+
+void AppendNotificationsWriter(userver::components::ComponentList &component_list);
+}
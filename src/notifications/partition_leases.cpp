@@ -0,0 +1,291 @@
+#include "partition_leases.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/boost_uuid7.hpp>
+
+ens::notifications::PartitionLeases::PartitionLeases(userver::storages::postgres::ClusterPtr pg_cluster,
+                                                     std::chrono::milliseconds lease_duration)
+    : _pg_cluster(std::move(pg_cluster)),
+      _holder_id(userver::utils::generators::GenerateBoostUuidV7()),
+      _lease_duration(lease_duration) {
+  // Leases are renewed several times per duration, so that a single failed renewal doesn't lose them
+  _renew_task.Start("partition-leases-renew", {_lease_duration / 3}, [this] { Renew(); });
+}
+
+ens::notifications::PartitionLeases::~PartitionLeases() {
+  _renew_task.Stop();
+}
+
+void ens::notifications::PartitionLeases::Create(const boost::uuids::uuid &batch_id,
+                                                 int32_t partitions,
+                                                 const std::vector<boost::uuids::uuid> &direct_groups) {
+  const userver::storages::postgres::Query create_query{
+      "INSERT INTO ens_schema.batch_partition "
+      "(batch_id, partition, partitions, direct_groups) "
+      "SELECT $1, partition, $2, $3 "
+      "FROM generate_series(0, $2 - 1) AS partition"
+  };
+  userver::storages::postgres::Transaction create_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  create_transaction.Execute(create_query, batch_id, partitions, direct_groups);
+  create_transaction.Commit();
+}
+
+std::optional<ens::notifications::PartitionClaim> ens::notifications::PartitionLeases::Claim(
+    const std::optional<boost::uuids::uuid> &batch_id) {
+  // Expiration is measured by the database clock, so that the clocks of the instances don't have to agree
+  const userver::storages::postgres::Query claim_query{
+      "UPDATE ens_schema.batch_partition "
+      "SET holder_id = $1, expires_at = (EXTRACT(EPOCH FROM clock_timestamp()) * 1000)::BIGINT + $2 "
+      "FROM ens_schema.notifications_batch, ens_schema.user AS tenant "
+      "WHERE (batch_partition.batch_id, batch_partition.partition) = ("
+      "SELECT batch_id, partition FROM ens_schema.batch_partition "
+      "WHERE NOT done AND expires_at < (EXTRACT(EPOCH FROM clock_timestamp()) * 1000)::BIGINT "
+      "AND ($3::uuid IS NULL OR batch_id = $3) "
+      "ORDER BY expires_at LIMIT 1 FOR UPDATE SKIP LOCKED) "
+      "AND notifications_batch.batch_id = batch_partition.batch_id AND tenant.user_id = notifications_batch.master_id "
+      "RETURNING batch_partition.batch_id, batch_partition.partition, batch_partition.partitions, "
+      "batch_partition.direct_groups, notifications_batch.master_id, notifications_batch.priority, tenant.tier"
+  };
+  const userver::storages::postgres::Query delivered_query{
+      "SELECT notification_id, recipient_id, group_id, type "
+      "FROM ens_schema.partition_delivery "
+      "WHERE batch_id = $1 AND partition = $2"
+  };
+  userver::storages::postgres::Transaction claim_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet claim_res = claim_transaction.Execute(claim_query,
+                                                                               _holder_id,
+                                                                               static_cast<int64_t>(_lease_duration.count()),
+                                                                               batch_id);
+  if (claim_res.IsEmpty()) {
+    claim_transaction.Commit();
+    return std::nullopt;
+  }
+  auto row = claim_res[0];
+  PartitionClaim claim{row["batch_id"].As<boost::uuids::uuid>(),
+                       {row["partition"].As<int32_t>(), row["partitions"].As<int32_t>()},
+                       {row["priority"].As<BatchPriority>(),
+                        row["master_id"].As<boost::uuids::uuid>(),
+                        row["tier"].As<TenantTier>()},
+                       row["direct_groups"].As<std::vector<boost::uuids::uuid>>()};
+  userver::storages::postgres::ResultSet delivered_res = claim_transaction.Execute(delivered_query,
+                                                                                   claim.batch_id,
+                                                                                   claim.partition.index);
+  claim_transaction.Commit();
+  for (auto delivered_row : delivered_res) {
+    claim.delivered.push_back({delivered_row["notification_id"].As<boost::uuids::uuid>(),
+                               delivered_row["recipient_id"].As<boost::uuids::uuid>(),
+                               delivered_row["group_id"].As<boost::uuids::uuid>(),
+                               delivered_row["type"].As<schemas::Notification::Type>()});
+  }
+  auto lost = std::make_shared<std::atomic<bool>>(false);
+  claim.lost = lost;
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _held.insert_or_assign({claim.batch_id, claim.partition.index},
+                         HeldLease{std::move(lost), std::chrono::steady_clock::now()});
+  return claim;
+}
+
+void ens::notifications::PartitionLeases::Acknowledge(const PartitionClaim &claim,
+                                                      const std::vector<DeliveryAck> &acks) {
+  // Deliveries are recorded even after the lease is lost, they have been sent either way
+  const userver::storages::postgres::Query acknowledge_query{
+      "INSERT INTO ens_schema.partition_delivery "
+      "(batch_id, partition, notification_id, recipient_id, group_id, type) "
+      "SELECT $1, $2, acks.notification_id, acks.recipient_id, acks.group_id, acks.type "
+      "FROM UNNEST($3::uuid[], $4::uuid[], $5::uuid[], $6::ens_schema.message_type[]) "
+      "AS acks(notification_id, recipient_id, group_id, type) "
+      "ON CONFLICT DO NOTHING"
+  };
+  if (acks.empty()) {
+    return;
+  }
+  std::vector<boost::uuids::uuid> notification_ids;
+  std::vector<boost::uuids::uuid> recipient_ids;
+  std::vector<boost::uuids::uuid> group_ids;
+  std::vector<schemas::Notification::Type> types;
+  for (const DeliveryAck &ack : acks) {
+    notification_ids.push_back(ack.notification_id);
+    recipient_ids.push_back(ack.recipient_id.value_or(boost::uuids::nil_uuid()));
+    group_ids.push_back(ack.group_id);
+    types.push_back(ack.type);
+  }
+  try {
+    _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                         acknowledge_query,
+                         claim.batch_id,
+                         claim.partition.index,
+                         notification_ids,
+                         recipient_ids,
+                         group_ids,
+                         types);
+  }
+  catch (const std::exception &e) {
+    // Only a takeover of the partition sends these deliveries again
+    LOG_WARNING() << "Error acknowledging partition deliveries, batch_id=" << boost::uuids::to_string(claim.batch_id)
+                  << ": " << e.what();
+  }
+}
+
+bool ens::notifications::PartitionLeases::Complete(const PartitionClaim &claim,
+                                                   const std::vector<std::string> &notification_ids) {
+  // The batch row is locked, so that exactly one of the partitions finishing at the same time sees itself last
+  const userver::storages::postgres::Query lock_query{
+      "SELECT batch_id FROM ens_schema.notifications_batch "
+      "WHERE batch_id = $1 "
+      "FOR UPDATE"
+  };
+  const userver::storages::postgres::Query complete_query{
+      "UPDATE ens_schema.batch_partition "
+      "SET done = true, notification_ids = $4 "
+      "WHERE batch_id = $1 AND partition = $2 AND holder_id = $3 AND NOT done"
+  };
+  const userver::storages::postgres::Query clear_delivered_query{
+      "DELETE FROM ens_schema.partition_delivery "
+      "WHERE batch_id = $1 AND partition = $2"
+  };
+  const userver::storages::postgres::Query remaining_query{
+      "SELECT COUNT(*) FROM ens_schema.batch_partition "
+      "WHERE batch_id = $1 AND NOT done"
+  };
+  std::vector<boost::uuids::uuid> ids;
+  ids.reserve(notification_ids.size());
+  for (const std::string &notification_id : notification_ids) {
+    ids.push_back(boost::lexical_cast<boost::uuids::uuid>(notification_id));
+  }
+  Forget(claim);
+  userver::storages::postgres::Transaction complete_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  complete_transaction.Execute(lock_query, claim.batch_id);
+  userver::storages::postgres::ResultSet complete_res = complete_transaction.Execute(complete_query,
+                                                                                     claim.batch_id,
+                                                                                     claim.partition.index,
+                                                                                     _holder_id,
+                                                                                     ids);
+  if (not complete_res.RowsAffected()) {
+    // The lease has expired and the partition went to another instance
+    LOG_WARNING() << "Partition lease lost during the dispatch, batch_id=" << boost::uuids::to_string(claim.batch_id)
+                  << ", partition=" << claim.partition.index;
+    complete_transaction.Commit();
+    return false;
+  }
+  complete_transaction.Execute(clear_delivered_query, claim.batch_id, claim.partition.index);
+  const auto remaining = complete_transaction.Execute(remaining_query, claim.batch_id).AsSingleRow<int64_t>();
+  complete_transaction.Commit();
+  return remaining == 0;
+}
+
+void ens::notifications::PartitionLeases::Release(const PartitionClaim &claim) {
+  const userver::storages::postgres::Query release_query{
+      "UPDATE ens_schema.batch_partition "
+      "SET expires_at = 0 "
+      "WHERE batch_id = $1 AND partition = $2 AND holder_id = $3 AND NOT done"
+  };
+  Forget(claim);
+  try {
+    _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                         release_query,
+                         claim.batch_id,
+                         claim.partition.index,
+                         _holder_id);
+  }
+  catch (const std::exception &e) {
+    LOG_WARNING() << "Error releasing partition lease, batch_id=" << boost::uuids::to_string(claim.batch_id)
+                  << ": " << e.what();
+  }
+}
+
+std::optional<std::vector<std::string>> ens::notifications::PartitionLeases::CollectNotifications(
+    const boost::uuids::uuid &batch_id) {
+  const userver::storages::postgres::Query collect_query{
+      "SELECT done, notification_ids "
+      "FROM ens_schema.batch_partition "
+      "WHERE batch_id = $1"
+  };
+  userver::storages::postgres::ResultSet collect_res =
+      _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster, collect_query, batch_id);
+  std::vector<std::string> notification_ids;
+  for (auto row : collect_res) {
+    if (not row["done"].As<bool>()) {
+      return std::nullopt;
+    }
+    for (const auto &notification_id : row["notification_ids"].As<std::vector<boost::uuids::uuid>>()) {
+      notification_ids.push_back(boost::uuids::to_string(notification_id));
+    }
+  }
+  return notification_ids;
+}
+
+void ens::notifications::PartitionLeases::Forget(const PartitionClaim &claim) {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  _held.erase({claim.batch_id, claim.partition.index});
+}
+
+void ens::notifications::PartitionLeases::Renew() {
+  const userver::storages::postgres::Query renew_query{
+      "UPDATE ens_schema.batch_partition "
+      "SET expires_at = (EXTRACT(EPOCH FROM clock_timestamp()) * 1000)::BIGINT + $2 "
+      "FROM UNNEST($3::uuid[], $4::INTEGER[]) AS held(batch_id, partition) "
+      "WHERE batch_partition.batch_id = held.batch_id AND batch_partition.partition = held.partition "
+      "AND batch_partition.holder_id = $1 "
+      "RETURNING batch_partition.batch_id, batch_partition.partition"
+  };
+  std::vector<boost::uuids::uuid> batch_ids;
+  std::vector<int32_t> partitions;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    for (const auto &[held, lease] : _held) {
+      batch_ids.push_back(held.first);
+      partitions.push_back(held.second);
+    }
+  }
+  if (batch_ids.empty()) {
+    return;
+  }
+  const auto renewed_at = std::chrono::steady_clock::now();
+  std::unordered_set<HeldPartition, boost::hash<HeldPartition>> renewed;
+  bool renew_failed = false;
+  try {
+    userver::storages::postgres::ResultSet renew_res =
+        _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                             renew_query,
+                             _holder_id,
+                             static_cast<int64_t>(_lease_duration.count()),
+                             batch_ids,
+                             partitions);
+    for (auto row : renew_res) {
+      renewed.emplace(row["batch_id"].As<boost::uuids::uuid>(), row["partition"].As<int32_t>());
+    }
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error renewing partition leases: " << e.what();
+    renew_failed = true;
+  }
+  // The dispatch of a lost partition stops between its rounds, the new holder sends the rest
+  size_t lost = 0;
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  for (size_t i = 0; i < batch_ids.size(); ++i) {
+    const auto held_it = _held.find({batch_ids[i], partitions[i]});
+    if (held_it == _held.end()) {
+      continue;
+    }
+    HeldLease &lease = held_it->second;
+    if (renewed.count(held_it->first)) {
+      lease.renewed_at = renewed_at;
+      continue;
+    }
+    // Either another instance holds the partition now, or the lease hasn't been renewed for so long it has expired
+    if ((not renew_failed or renewed_at - lease.renewed_at >= _lease_duration) and not lease.lost->exchange(true)) {
+      ++lost;
+    }
+  }
+  if (lost != 0) {
+    LOG_WARNING() << "Lost " << lost << " partition leases, their dispatch is stopped";
+  }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "notifications/dispatch_journal.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+
+namespace ens::notifications {
+// Part of the recipients of a batch, chosen by the hash of the recipient id
+struct BatchPartition {
+  int32_t index;
+  int32_t count;
+};
+
+// Partition of a batch claimed by this instance of the service
+struct PartitionClaim {
+  boost::uuids::uuid batch_id;
+  BatchPartition partition;
+  DispatchTag tag;
+  // Groups whose channel post failed, their subscribers are messaged directly
+  std::vector<boost::uuids::uuid> direct_groups;
+  // Deliveries acknowledged by the previous holders of the partition, they aren't sent again
+  std::vector<DeliveryAck> delivered;
+  // Set once the lease can't be renewed, the partition may be dispatched by another instance from then on
+  std::shared_ptr<const std::atomic<bool>> lost;
+};
+
+// Leases of the batch partitions in Postgres. Every instance dispatching a partition renews its lease
+// in the background, a partition whose lease has expired is claimed by another instance and dispatched again
+class PartitionLeases {
+ public:
+  PartitionLeases(userver::storages::postgres::ClusterPtr pg_cluster, std::chrono::milliseconds lease_duration);
+  ~PartitionLeases();
+  void Create(const boost::uuids::uuid &batch_id,
+              int32_t partitions,
+              const std::vector<boost::uuids::uuid> &direct_groups);
+  // Claims a partition nobody dispatches, of the given batch or of any batch
+  std::optional<PartitionClaim> Claim(const std::optional<boost::uuids::uuid> &batch_id);
+  // Records the deliveries accepted by their channels, so that an instance taking the partition over skips them
+  void Acknowledge(const PartitionClaim &claim, const std::vector<DeliveryAck> &acks);
+  // Marks the partition dispatched, returns true if it was the last one of the batch
+  bool Complete(const PartitionClaim &claim, const std::vector<std::string> &notification_ids);
+  // Hands the partition over to the other instances without waiting for its lease to expire
+  void Release(const PartitionClaim &claim);
+  // Notifications of all the partitions, nullopt while some of them are being dispatched
+  std::optional<std::vector<std::string>> CollectNotifications(const boost::uuids::uuid &batch_id);
+ private:
+  using HeldPartition = std::pair<boost::uuids::uuid, int32_t>;
+  struct HeldLease {
+    std::shared_ptr<std::atomic<bool>> lost;
+    std::chrono::steady_clock::time_point renewed_at;
+  };
+  void Forget(const PartitionClaim &claim);
+  void Renew();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  const boost::uuids::uuid _holder_id;
+  const std::chrono::milliseconds _lease_duration;
+  userver::engine::Mutex _mutex;
+  std::unordered_map<HeldPartition, HeldLease, boost::hash<HeldPartition>> _held;
+  userver::utils::PeriodicTask _renew_task;
+};
+}
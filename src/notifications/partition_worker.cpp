@@ -0,0 +1,49 @@
+#include "partition_worker.hpp"
+
+#include <boost/uuid/uuid_io.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+userver::yaml_config::Schema ens::notifications::PartitionWorker::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component dispatching the partitions of the batches sent through any instance of the service
+    additionalProperties: false
+    properties:
+        poll-interval:
+            type: string
+            description: Period of claiming the partitions nobody dispatches
+            defaultDescription: 1s
+        max-partitions:
+            type: integer
+            description: Maximum number of partitions dispatched by the worker at the same time
+            defaultDescription: 4
+            minimum: 1
+  )");
+}
+
+void ens::notifications::PartitionWorker::Poll() {
+  while (_running < _max_partitions) {
+    std::optional<PartitionClaim> claim = _notifications_manager.ClaimPartition();
+    if (not claim.has_value()) {
+      return;
+    }
+    ++_running;
+    _dispatch_tasks.AsyncDetach("dispatch-partition", [this, claim = std::move(claim.value())] { Dispatch(claim); });
+  }
+}
+
+void ens::notifications::PartitionWorker::Dispatch(const PartitionClaim &claim) {
+  try {
+    _notifications_manager.DispatchPartition(claim);
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error dispatching batch partition, batch_id=" << boost::uuids::to_string(claim.batch_id)
+                << ", partition=" << claim.partition.index << ": " << e.what();
+  }
+  --_running;
+}
+
+void ens::notifications::AppendPartitionWorker(userver::components::ComponentList &component_list) {
+  component_list.Append<PartitionWorker>();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/concurrent/background_task_storage.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+#include "notifications/notifications.hpp"
+
+namespace ens::notifications {
+// Component dispatching the partitions of the batches sent through any instance of the service. Partitions are
+// claimed by their leases, the ones left by a failed instance are taken over once their leases expire
+class PartitionWorker : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "dispatch-partition-worker";
+  static constexpr std::chrono::milliseconds kDefaultPollInterval{1000};
+  static constexpr size_t kDefaultMaxPartitions = 4;
+  PartitionWorker(const userver::components::ComponentConfig &config,
+                  const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _notifications_manager(component_context.FindComponent<NotificationsManager>()),
+      _max_partitions(config["max-partitions"].As<size_t>(kDefaultMaxPartitions)) {
+    _poll_task.Start("dispatch-partition-poll",
+                     {config["poll-interval"].As<std::chrono::milliseconds>(kDefaultPollInterval)},
+                     [this] { Poll(); });
+  }
+  ~PartitionWorker() override {
+    _poll_task.Stop();
+    _dispatch_tasks.CancelAndWait();
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+ private:
+  // Claims partitions until the worker is busy or none is left
+  void Poll();
+  void Dispatch(const PartitionClaim &claim);
+  NotificationsManager &_notifications_manager;
+  const size_t _max_partitions;
+  std::atomic<size_t> _running{0};
+  userver::concurrent::BackgroundTaskStorage _dispatch_tasks;
+  userver::utils::PeriodicTask _poll_task;
+};
+
+void AppendPartitionWorker(userver::components::ComponentList &component_list);
+}
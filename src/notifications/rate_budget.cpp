@@ -0,0 +1,155 @@
+#include "rate_budget.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/boost_uuid7.hpp>
+#include <userver/utils/datetime.hpp>
+
+namespace {
+// A sender which hasn't taken a message for this long gives the rest of its slice back
+constexpr std::chrono::milliseconds kIdleReturnDelay{100};
+// Instances which haven't leased the budget for this long aren't counted among its holders
+constexpr int64_t kHolderExpirySeconds = 60;
+}
+
+ens::notifications::ClusterRateBudget::ClusterRateBudget(userver::storages::postgres::ClusterPtr pg_cluster,
+                                                         std::string name,
+                                                         size_t messages_per_second,
+                                                         size_t max_slice)
+    : _pg_cluster(std::move(pg_cluster)),
+      _name(std::move(name)),
+      _holder_id(userver::utils::generators::GenerateBoostUuidV7()),
+      _messages_per_second(static_cast<int64_t>(messages_per_second)),
+      _max_slice(static_cast<int64_t>(std::min(max_slice, messages_per_second))) {
+  _return_task.Start("rate-budget-return-" + _name, {kIdleReturnDelay}, [this] { ReturnIdle(); });
+}
+
+ens::notifications::ClusterRateBudget::~ClusterRateBudget() {
+  _return_task.Stop();
+}
+
+int64_t ens::notifications::ClusterRateBudget::CurrentWindow() {
+  // Windows are aligned to the wall clock seconds, so that the instances share them
+  return std::chrono::duration_cast<std::chrono::seconds>(
+      userver::utils::datetime::Now().time_since_epoch()).count();
+}
+
+bool ens::notifications::ClusterRateBudget::Take() {
+  std::lock_guard<userver::engine::Mutex> lock(_mutex);
+  while (not userver::engine::current_task::ShouldCancel()) {
+    const int64_t window = CurrentWindow();
+    if (window != _window) {
+      // Tokens of the past second can't be used anymore, an idle sender has given them back before it ended
+      _window = window;
+      _tokens = 0;
+      _fallback = false;
+    }
+    const std::chrono::system_clock::time_point next_window{std::chrono::seconds{window + 1}};
+    if (_tokens == 0 and not _fallback) {
+      // Messages the sender can still send in this second at its pace
+      const int64_t remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+          next_window - userver::utils::datetime::Now()).count();
+      const int64_t slice = std::clamp((remaining_ms * _messages_per_second + 999) / 1000, int64_t{1}, _max_slice);
+      try {
+        _tokens = Lease(window, slice);
+      }
+      catch (const std::exception &e) {
+        // Until the database is back every instance sends its share of the limit, so that together they keep within it
+        LOG_LIMITED_ERROR() << "Error leasing rate budget " << _name << ": " << e.what();
+        _tokens = std::max(_messages_per_second / _holders, int64_t{1});
+        _fallback = true;
+      }
+    }
+    if (_tokens > 0) {
+      --_tokens;
+      _taken_at = std::chrono::steady_clock::now();
+      return true;
+    }
+    // The budget of the second is used up by the other instances
+    userver::engine::InterruptibleSleepFor(next_window - userver::utils::datetime::Now());
+  }
+  return false;
+}
+
+int64_t ens::notifications::ClusterRateBudget::Lease(int64_t window, int64_t slice) {
+  const userver::storages::postgres::Query create_query{
+      "INSERT INTO ens_schema.rate_budget "
+      "(name, window_start, leased) "
+      "VALUES ($1, $2, 0) "
+      "ON CONFLICT (name) DO NOTHING"
+  };
+  // A row of a past second is taken over by the current one, a row of a later second means the clock
+  // of this instance is behind and nothing is granted until it catches up
+  const userver::storages::postgres::Query lease_query{
+      "WITH current_window AS ("
+      "SELECT CASE WHEN window_start = $2 THEN leased ELSE 0 END AS leased "
+      "FROM ens_schema.rate_budget "
+      "WHERE name = $1 AND window_start <= $2 "
+      "FOR UPDATE), "
+      "slice AS (SELECT leased, LEAST($3, GREATEST($4 - leased, 0)) AS granted FROM current_window) "
+      "UPDATE ens_schema.rate_budget "
+      "SET window_start = $2, leased = slice.leased + slice.granted "
+      "FROM slice "
+      "WHERE rate_budget.name = $1 "
+      "RETURNING slice.granted"
+  };
+  // The holders are counted once a second, their number sets the share of the limit used without the database
+  const userver::storages::postgres::Query holders_query{
+      "WITH seen AS ("
+      "INSERT INTO ens_schema.rate_budget_holder "
+      "(name, holder_id, leased_at) "
+      "VALUES ($1, $2, $3) "
+      "ON CONFLICT (name, holder_id) DO UPDATE SET leased_at = EXCLUDED.leased_at), "
+      "expired AS (DELETE FROM ens_schema.rate_budget_holder WHERE name = $1 AND leased_at < $4) "
+      "SELECT COUNT(*) + 1 FROM ens_schema.rate_budget_holder "
+      "WHERE name = $1 AND holder_id <> $2 AND leased_at >= $4"
+  };
+  userver::storages::postgres::Transaction lease_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  lease_transaction.Execute(create_query, _name, window);
+  userver::storages::postgres::ResultSet lease_res = lease_transaction.Execute(lease_query,
+                                                                               _name,
+                                                                               window,
+                                                                               slice,
+                                                                               _messages_per_second);
+  std::optional<int64_t> holders;
+  if (window != _holders_window) {
+    holders = lease_transaction.Execute(holders_query, _name, _holder_id, window, window - kHolderExpirySeconds)
+        .AsSingleRow<int64_t>();
+  }
+  lease_transaction.Commit();
+  if (holders.has_value()) {
+    _holders_window = window;
+    _holders = holders.value();
+  }
+  if (lease_res.IsEmpty()) {
+    return 0;
+  }
+  return lease_res.AsSingleRow<int64_t>();
+}
+
+void ens::notifications::ClusterRateBudget::ReturnIdle() {
+  const userver::storages::postgres::Query return_query{
+      "UPDATE ens_schema.rate_budget "
+      "SET leased = GREATEST(leased - $3, 0) "
+      "WHERE name = $1 AND window_start = $2"
+  };
+  // A sender waiting for the next second holds the lock, it has no tokens to return
+  std::unique_lock<userver::engine::Mutex> lock(_mutex, std::try_to_lock);
+  if (not lock.owns_lock() or _tokens == 0 or _fallback or _window != CurrentWindow()
+      or std::chrono::steady_clock::now() - _taken_at < kIdleReturnDelay) {
+    return;
+  }
+  try {
+    _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster, return_query, _name, _window, _tokens);
+    _tokens = 0;
+  }
+  catch (const std::exception &e) {
+    LOG_LIMITED_WARNING() << "Error returning rate budget " << _name << ": " << e.what();
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include <boost/uuid/uuid.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+namespace ens::notifications {
+// Rate limit shared by all the instances of the service. The budget of every second is kept in Postgres,
+// the instances lease slices of it as their senders need them and give back the part an idle sender won't use
+class ClusterRateBudget {
+ public:
+  ClusterRateBudget(userver::storages::postgres::ClusterPtr pg_cluster,
+                    std::string name,
+                    size_t messages_per_second,
+                    size_t max_slice);
+  ~ClusterRateBudget();
+  // Blocks until a message of the budget of the current second is taken. A slice lasts the sender
+  // for the rest of the second at its own pace, so a lease serves several messages.
+  // Returns false if the wait has been cancelled
+  bool Take();
+ private:
+  static int64_t CurrentWindow();
+  // Returns the number of the messages granted
+  int64_t Lease(int64_t window, int64_t slice);
+  // Hands the rest of the slice back to the other instances once the sender has stopped taking it
+  void ReturnIdle();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  const std::string _name;
+  const boost::uuids::uuid _holder_id;
+  const int64_t _messages_per_second;
+  const int64_t _max_slice;
+  userver::engine::Mutex _mutex;
+  // Second the tokens are leased for, Unix time in seconds
+  int64_t _window = 0;
+  int64_t _tokens = 0;
+  // Whether the tokens are a share of the limit taken without the database, they aren't returned
+  bool _fallback = false;
+  std::chrono::steady_clock::time_point _taken_at{};
+  // Second the holders of the budget have last been counted in
+  int64_t _holders_window = 0;
+  // Instances which have recently leased the budget, each of them falls back to its share of the limit
+  int64_t _holders = 1;
+  userver::utils::PeriodicTask _return_task;
+};
+}
@@ -0,0 +1,67 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/utils/scope_guard.hpp>
+
+ens::notifications::SendRateLimiter::SendRateLimiter(size_t messages_per_second,
+                                                     DispatchScheduler &scheduler,
+                                                     std::unique_ptr<ClusterRateBudget> budget)
+    : _interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds{1})
+                    / messages_per_second),
+      _scheduler(scheduler),
+      _budget(std::move(budget)),
+      _waiters(scheduler) {}
+
+bool ens::notifications::SendRateLimiter::Acquire(const DispatchTag &tag) {
+  const auto started_at = std::chrono::steady_clock::now();
+  LaneWaiters::Waiter waiter{tag};
+  std::unique_lock<userver::engine::Mutex> lock(_mutex);
+  _waiters.Push(waiter);
+  bool picking = false;
+  // A cancelled or failed sender leaves the queue, and if it was picking another waiter takes over
+  userver::utils::ScopeGuard leave_queue([this, &lock, &waiter, &picking] {
+    if (not lock.owns_lock()) {
+      lock.lock();
+    }
+    if (picking) {
+      _picking = false;
+      _cv.NotifyAll();
+    }
+    if (not waiter.granted) {
+      _waiters.Remove(waiter);
+    }
+  });
+  while (not waiter.granted) {
+    if (_picking) {
+      if (not _cv.Wait(lock, [this, &waiter] { return waiter.granted or not _picking; })) {
+        return false;
+      }
+      continue;
+    }
+    // The waiter sleeps until the slot and grants it then, its own message is among the candidates,
+    // so a message queued in the meantime still competes for the slot
+    _picking = picking = true;
+    const auto slot = std::max(std::chrono::steady_clock::now(), _next_slot);
+    lock.unlock();
+    userver::engine::SleepUntil(slot);
+    // The budget is taken while the slot is still being handed out, so the waiters keep their order
+    if (userver::engine::current_task::ShouldCancel() or (_budget and not _budget->Take())) {
+      return false;
+    }
+    const auto granted_at = _budget ? std::chrono::steady_clock::now() : slot;
+    lock.lock();
+    LaneWaiters::Waiter *next = _waiters.PopNext();
+    next->granted = true;
+    _next_slot = granted_at + _interval;
+    _picking = picking = false;
+    _cv.NotifyAll();
+  }
+  leave_queue.Release();
+  lock.unlock();
+  _scheduler.AccountWait(tag.lane, std::chrono::steady_clock::now() - started_at);
+  return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/mutex.hpp>
+
+#include "notifications/dispatch_scheduler.hpp"
+#include "notifications/rate_budget.hpp"
+
+namespace ens::notifications {
+// Spreads messages of a single sender evenly to stay within its rate limit.
+// Every slot is handed out when it comes, among the messages waiting at that moment, so a message of a more urgent
+// lane takes it ahead of the messages of the other lanes which have been waiting longer, and the tenants of a lane
+// take turns. A sender granted a slot has the whole interval to queue its next message for the following one.
+// With a cluster budget every message also takes a part of the limit shared with the other instances
+class SendRateLimiter {
+ public:
+  SendRateLimiter(size_t messages_per_second,
+                  DispatchScheduler &scheduler,
+                  std::unique_ptr<ClusterRateBudget> budget = nullptr);
+  // Blocks until the next message of the lane may be sent, returns false if the wait has been cancelled
+  bool Acquire(const DispatchTag &tag);
+ private:
+  const std::chrono::steady_clock::duration _interval;
+  DispatchScheduler &_scheduler;
+  const std::unique_ptr<ClusterRateBudget> _budget;
+  userver::engine::Mutex _mutex;
+  userver::engine::ConditionVariable _cv;
+  std::chrono::steady_clock::time_point _next_slot{};
+  // Whether one of the waiters sleeps until the upcoming slot to hand it out
+  bool _picking = false;
+  LaneWaiters _waiters;
+};
+}
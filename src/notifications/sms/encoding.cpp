@@ -0,0 +1,119 @@
+#include "encoding.hpp"
+
+#include <vector>
+
+namespace {
+constexpr size_t kGsm7SingleSegmentUnits = 160;
+// Concatenated segments lose room to the user data header
+constexpr size_t kGsm7MultiSegmentUnits = 153;
+constexpr size_t kUcs2SingleSegmentUnits = 70;
+constexpr size_t kUcs2MultiSegmentUnits = 67;
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+constexpr std::u32string_view kGsm7Basic =
+    U"@£$¥èéùìòÇ\nØø\rÅåΔ_ΦΓΛΩΠΨΣΘΞÆæßÉ !\"#¤%&'()*+,-./0123456789:;<=>?"
+    U"¡ABCDEFGHIJKLMNOPQRSTUVWXYZÄÖÑÜ§¿abcdefghijklmnopqrstuvwxyzäöñüà";
+// Characters of the extension table are sent as an escape sequence of two septets
+constexpr std::u32string_view kGsm7Extension = U"\f^{}\\[~]|€";
+
+std::vector<char32_t> DecodeUtf8(std::string_view text) {
+  std::vector<char32_t> code_points;
+  code_points.reserve(text.size());
+  size_t pos = 0;
+  while (pos < text.size()) {
+    const auto lead = static_cast<unsigned char>(text[pos]);
+    size_t length = 0;
+    char32_t code_point = 0;
+    if (lead < 0x80) {
+      length = 1;
+      code_point = lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+      length = 2;
+      code_point = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+      length = 3;
+      code_point = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+      length = 4;
+      code_point = lead & 0x07;
+    }
+    bool valid = length != 0 and pos + length <= text.size();
+    for (size_t i = 1; valid and i < length; ++i) {
+      const auto continuation = static_cast<unsigned char>(text[pos + i]);
+      valid = (continuation & 0xC0) == 0x80;
+      code_point = (code_point << 6) | (continuation & 0x3F);
+    }
+    if (not valid) {
+      code_points.push_back(kReplacementCharacter);
+      ++pos;
+      continue;
+    }
+    code_points.push_back(code_point);
+    pos += length;
+  }
+  return code_points;
+}
+
+// Characters are never split between the segments, so a segment may be left incomplete
+size_t CountSegments(const std::vector<size_t> &char_units, size_t single_segment_units, size_t multi_segment_units) {
+  size_t total_units = 0;
+  for (size_t units : char_units) {
+    total_units += units;
+  }
+  if (total_units <= single_segment_units) {
+    return 1;
+  }
+  size_t segments = 1;
+  size_t segment_units = 0;
+  for (size_t units : char_units) {
+    if (segment_units + units > multi_segment_units) {
+      ++segments;
+      segment_units = 0;
+    }
+    segment_units += units;
+  }
+  return segments;
+}
+}
+
+std::string_view ens::notifications::sms::ToString(SmsEncoding encoding) {
+  switch (encoding) {
+    case SmsEncoding::Gsm7:
+      return "GSM7";
+    case SmsEncoding::Ucs2:
+      return "UCS2";
+  }
+  return "UCS2";
+}
+
+ens::notifications::sms::SmsTextInfo ens::notifications::sms::AnalyzeSmsText(std::string_view text) {
+  const std::vector<char32_t> code_points = DecodeUtf8(text);
+  std::vector<size_t> char_units;
+  char_units.reserve(code_points.size());
+  bool is_gsm7 = true;
+  for (char32_t code_point : code_points) {
+    if (kGsm7Basic.find(code_point) != std::u32string_view::npos) {
+      char_units.push_back(1);
+    } else if (kGsm7Extension.find(code_point) != std::u32string_view::npos) {
+      char_units.push_back(2);
+    } else {
+      is_gsm7 = false;
+      break;
+    }
+  }
+  if (is_gsm7) {
+    size_t units = 0;
+    for (size_t char_unit : char_units) {
+      units += char_unit;
+    }
+    return {SmsEncoding::Gsm7, units, CountSegments(char_units, kGsm7SingleSegmentUnits, kGsm7MultiSegmentUnits)};
+  }
+  char_units.clear();
+  size_t units = 0;
+  for (char32_t code_point : code_points) {
+    // Characters outside of the basic plane take a surrogate pair
+    char_units.push_back(code_point > 0xFFFF ? 2 : 1);
+    units += char_units.back();
+  }
+  return {SmsEncoding::Ucs2, units, CountSegments(char_units, kUcs2SingleSegmentUnits, kUcs2MultiSegmentUnits)};
+}
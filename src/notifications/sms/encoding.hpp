@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string_view>
+
+namespace ens::notifications::sms {
+enum class SmsEncoding {
+  Gsm7,  // 7-bit default alphabet, 160 characters in a single segment
+  Ucs2  // any other text, 70 UTF-16 code units in a single segment
+};
+
+std::string_view ToString(SmsEncoding encoding);
+
+struct SmsTextInfo {
+  SmsEncoding encoding;
+  // Septets for GSM-7, UTF-16 code units for UCS-2
+  size_t units;
+  size_t segments;
+};
+
+// Picks the encoding of the text and counts the segments it is split into
+SmsTextInfo AnalyzeSmsText(std::string_view text);
+}
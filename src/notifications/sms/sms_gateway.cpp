@@ -0,0 +1,221 @@
+#include "sms_gateway.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/formats/json.hpp>
+#include <userver/http/common_headers.hpp>
+#include <userver/http/content_type.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+#include "notifications/sms/encoding.hpp"
+
+namespace {
+// E.164 limit
+constexpr size_t kMaxPhoneNumberDigits = 15;
+
+// Strips the formatting characters, nullopt if the number contains anything else
+std::optional<std::string> NormalizePhoneNumber(std::string_view phone_number) {
+  std::string normalized;
+  normalized.reserve(phone_number.size());
+  size_t digits = 0;
+  for (char c : phone_number) {
+    if (c >= '0' and c <= '9') {
+      normalized.push_back(c);
+      ++digits;
+    } else if (c == '+' and normalized.empty()) {
+      normalized.push_back(c);
+    } else if (c != ' ' and c != '-' and c != '(' and c != ')') {
+      return std::nullopt;
+    }
+  }
+  if (digits == 0 or digits > kMaxPhoneNumberDigits) {
+    return std::nullopt;
+  }
+  return normalized;
+}
+
+std::string ToJsonString(const std::string &value) {
+  return userver::formats::json::ToString(userver::formats::json::ValueBuilder(value).ExtractValue());
+}
+}
+
+userver::yaml_config::Schema ens::notifications::sms::SmsGateway::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component for SMS delivery through the bulk submission API of an HTTP gateway
+    additionalProperties: false
+    properties:
+        url:
+            type: string
+            description: Bulk submission endpoint of the gateway
+            defaultDescription: SMS is disabled
+        sender-id:
+            type: string
+            description: Sender name or number shown to the recipients
+            defaultDescription: gateway default
+        max-recipients-per-request:
+            type: integer
+            description: Maximum number of phone numbers submitted in a single request
+            defaultDescription: 1000
+            minimum: 1
+        max-in-flight-requests:
+            type: integer
+            description: Maximum number of submissions awaiting the gateway reply at the same time
+            defaultDescription: 8
+            minimum: 1
+        timeout:
+            type: string
+            description: Timeout of a single submission attempt
+            defaultDescription: 5s
+        retries:
+            type: integer
+            description: Number of attempts of a submission failed with a network error or 5xx
+            defaultDescription: 2
+            minimum: 1
+  )");
+}
+
+bool ens::notifications::sms::SmsGateway::IsEnabled() const {
+  return not _url.empty();
+}
+
+std::vector<std::string> ens::notifications::sms::SmsGateway::SendBulk(const std::string &text,
+                                                                       const std::vector<std::string> &phone_numbers,
+                                                                       CircuitBreaker &breaker,
+                                                                       const DispatchTag &tag,
+                                                                       const std::function<void(const std::vector<std::string> &)> &accepted,
+                                                                       const std::function<bool()> &stopped) {
+  std::vector<std::string> failed;
+  std::vector<std::string> normalized_numbers;
+  // Failures are reported with the numbers as they were passed in
+  std::unordered_map<std::string, std::vector<std::string>> original_numbers;
+  normalized_numbers.reserve(phone_numbers.size());
+  for (const std::string &phone_number : phone_numbers) {
+    std::optional<std::string> normalized = NormalizePhoneNumber(phone_number);
+    if (not normalized.has_value()) {
+      failed.push_back(phone_number);
+      continue;
+    }
+    std::vector<std::string> &originals = original_numbers[normalized.value()];
+    if (originals.empty()) {
+      normalized_numbers.push_back(normalized.value());
+    }
+    originals.push_back(phone_number);
+  }
+  // The text is analyzed and serialized once, the chunks only differ in the recipients
+  const SmsTextInfo text_info = AnalyzeSmsText(text);
+  const std::string body_prefix = fmt::format(R"({{"sender":{},"encoding":"{}","segments":{},"text":{},"recipients":[)",
+                                              ToJsonString(_sender_id),
+                                              ToString(text_info.encoding),
+                                              text_info.segments,
+                                              ToJsonString(text));
+  std::vector<userver::engine::TaskWithResult<std::vector<std::string>>> chunk_tasks;
+  for (size_t begin = 0; begin < normalized_numbers.size(); begin += _max_recipients_per_request) {
+    const size_t end = std::min(normalized_numbers.size(), begin + _max_recipients_per_request);
+    std::vector<std::string> chunk(normalized_numbers.begin() + begin, normalized_numbers.begin() + end);
+    chunk_tasks.push_back(userver::utils::Async("sms-submit",
+                                                [this, &body_prefix, &breaker, tag, &accepted, &stopped, &original_numbers,
+                                                    chunk = std::move(chunk)] {
+                                                  std::vector<std::string> rejected = SubmitChunk(body_prefix, chunk, breaker, tag,
+                                                                                                  stopped);
+                                                  const std::unordered_set<std::string> rejected_set(rejected.cbegin(), rejected.cend());
+                                                  std::vector<std::string> chunk_accepted;
+                                                  for (const std::string &number : chunk) {
+                                                    if (rejected_set.count(number) == 0) {
+                                                      const std::vector<std::string> &originals = original_numbers.at(number);
+                                                      chunk_accepted.insert(chunk_accepted.end(), originals.begin(), originals.end());
+                                                    }
+                                                  }
+                                                  accepted(chunk_accepted);
+                                                  return rejected;
+                                                }));
+  }
+  for (auto &task : chunk_tasks) {
+    for (const std::string &rejected : task.Get()) {
+      const auto originals_it = original_numbers.find(rejected);
+      if (originals_it != original_numbers.cend()) {
+        failed.insert(failed.end(), originals_it->second.begin(), originals_it->second.end());
+      }
+    }
+  }
+  return failed;
+}
+
+std::vector<std::string> ens::notifications::sms::SmsGateway::SubmitChunk(const std::string &body_prefix,
+                                                                          const std::vector<std::string> &phone_numbers,
+                                                                          CircuitBreaker &breaker,
+                                                                          const DispatchTag &tag,
+                                                                          const std::function<bool()> &stopped) {
+  LaneSemaphoreLock request_lock(_requests_semaphore, tag);
+  if (not request_lock.OwnsLock() or stopped()) {
+    return phone_numbers;
+  }
+  const std::optional<CircuitBreaker::Call> breaker_call = breaker.AllowCall();
+  if (not breaker_call.has_value()) {
+    return phone_numbers;
+  }
+  std::string body;
+  body.reserve(body_prefix.size() + phone_numbers.size() * (kMaxPhoneNumberDigits + 4) + 2);
+  body.append(body_prefix);
+  for (size_t i = 0; i < phone_numbers.size(); ++i) {
+    if (i != 0) {
+      body.push_back(',');
+    }
+    // Normalized numbers need no escaping
+    body.push_back('"');
+    body.append(phone_numbers[i]);
+    body.push_back('"');
+  }
+  body.append("]}");
+  userver::clients::http::Headers headers;
+  headers[userver::http::headers::kContentType] = userver::http::content_type::kApplicationJson.ToString();
+  if (not _secdist_config._gateway_token.empty()) {
+    headers[userver::http::headers::kAuthorization] = "Bearer " + _secdist_config._gateway_token;
+  }
+  const auto started_at = std::chrono::steady_clock::now();
+  std::shared_ptr<userver::clients::http::Response> response;
+  try {
+    response = _http_client.CreateRequest()
+        .post(_url, std::move(body))
+        .headers(headers)
+        .timeout(_timeout)
+        .retry(_retries, true)
+        .perform();
+  }
+  catch (const std::exception &e) {
+    breaker.RecordFailure(breaker_call.value());
+    LOG_ERROR() << "Error submitting SMS to the gateway, recipients=" << phone_numbers.size() << ": " << e.what();
+    return phone_numbers;
+  }
+  const auto status = static_cast<int>(response->status_code());
+  // Client errors don't mean the gateway is degraded
+  if (status >= 500) {
+    breaker.RecordFailure(breaker_call.value());
+  } else {
+    breaker.RecordSuccess(breaker_call.value(), std::chrono::steady_clock::now() - started_at);
+  }
+  if (status < 200 or status >= 300) {
+    LOG_ERROR() << "SMS submission was refused by the gateway, status=" << status
+                << ", recipients=" << phone_numbers.size();
+    return phone_numbers;
+  }
+  try {
+    return userver::formats::json::FromString(response->body_view())["rejected"]
+        .As<std::vector<std::string>>(std::vector<std::string>{});
+  }
+  catch (const std::exception &e) {
+    // The submission itself has been accepted
+    LOG_WARNING() << "Error parsing the SMS gateway reply: " << e.what();
+    return {};
+  }
+}
+
+void ens::notifications::sms::AppendSmsGateway(userver::components::ComponentList &component_list) {
+  component_list.Append<SmsGateway>();
+}
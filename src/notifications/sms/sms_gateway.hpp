@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <userver/clients/http/client.hpp>
+#include <userver/clients/http/component.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_base.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/storages/secdist/component.hpp>
+
+#include "utils/utils.hpp"
+#include "notifications/circuit_breaker.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+
+namespace ens::notifications::sms {
+// Component for SMS delivery through the bulk submission API of an HTTP gateway
+class SmsGateway : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "sms-gateway";
+  static constexpr size_t kDefaultMaxRecipientsPerRequest = 1000;
+  static constexpr size_t kDefaultMaxInFlightRequests = 8;
+  static constexpr std::chrono::milliseconds kDefaultTimeout{5000};
+  static constexpr int kDefaultRetries = 2;
+  SmsGateway(const userver::components::ComponentConfig &config,
+             const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _http_client(component_context.FindComponent<userver::components::HttpClient>().GetHttpClient()),
+      _secdist_config(
+          component_context.FindComponent<userver::components::Secdist>().Get().Get<ens::utils::SmsGatewaySecdistConfig>()
+      ),
+      _url(config["url"].As<std::string>("")),
+      _sender_id(config["sender-id"].As<std::string>("")),
+      _max_recipients_per_request(config["max-recipients-per-request"].As<size_t>(kDefaultMaxRecipientsPerRequest)),
+      _timeout(config["timeout"].As<std::chrono::milliseconds>(kDefaultTimeout)),
+      _retries(config["retries"].As<int>(kDefaultRetries)),
+      _requests_semaphore(config["max-in-flight-requests"].As<size_t>(kDefaultMaxInFlightRequests),
+                          component_context.FindComponent<DispatchScheduler>()) {}
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // SMS is disabled unless the gateway is configured
+  bool IsEnabled() const;
+  // Submits the text to all the phone numbers, returns the numbers it was not accepted for.
+  // The submissions are reported to the breaker and aren't started while it is open.
+  // The numbers every submission is accepted for are passed to accepted as soon as it ends.
+  // No submission is started once stopped returns true, its numbers are returned
+  std::vector<std::string> SendBulk(const std::string &text,
+                                    const std::vector<std::string> &phone_numbers,
+                                    CircuitBreaker &breaker,
+                                    const DispatchTag &tag,
+                                    const std::function<void(const std::vector<std::string> &)> &accepted,
+                                    const std::function<bool()> &stopped);
+ private:
+  std::vector<std::string> SubmitChunk(const std::string &body_prefix,
+                                       const std::vector<std::string> &phone_numbers,
+                                       CircuitBreaker &breaker,
+                                       const DispatchTag &tag,
+                                       const std::function<bool()> &stopped);
+  userver::clients::http::Client &_http_client;
+  const ens::utils::SmsGatewaySecdistConfig _secdist_config;
+  const std::string _url;
+  const std::string _sender_id;
+  const size_t _max_recipients_per_request;
+  const std::chrono::milliseconds _timeout;
+  const int _retries;
+  LaneSemaphore _requests_semaphore;
+};
+
+void AppendSmsGateway(userver::components::ComponentList &component_list);
+}
@@ -0,0 +1,42 @@
+#include "attachments.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+std::string GetExtension(std::string_view file_name) {
+  const size_t dot_pos = file_name.rfind('.');
+  if (dot_pos == std::string_view::npos) {
+    return {};
+  }
+  std::string extension{file_name.substr(dot_pos + 1)};
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension;
+}
+}
+
+ens::notifications::telegram::AttachmentKind ens::notifications::telegram::GetAttachmentKind(std::string_view file_name) {
+  const std::string extension = GetExtension(file_name);
+  if (extension == "jpg" or extension == "jpeg" or extension == "png") {
+    return AttachmentKind::Photo;
+  }
+  return AttachmentKind::Document;
+}
+
+std::string ens::notifications::telegram::GetAttachmentContentType(std::string_view file_name) {
+  const std::string extension = GetExtension(file_name);
+  if (extension == "jpg" or extension == "jpeg") {
+    return "image/jpeg";
+  }
+  if (extension == "png") {
+    return "image/png";
+  }
+  if (extension == "pdf") {
+    return "application/pdf";
+  }
+  if (extension == "txt") {
+    return "text/plain";
+  }
+  return "application/octet-stream";
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace ens::notifications::telegram {
+enum class AttachmentKind {
+  Photo,  // shown inline, compressed by telegram
+  Document
+};
+
+AttachmentKind GetAttachmentKind(std::string_view file_name);
+
+std::string GetAttachmentContentType(std::string_view file_name);
+
+// Attachment of a template, its contents are read once per batch and shared by all the uploads
+struct Attachment {
+  std::string file_name;
+  AttachmentKind kind;
+  std::shared_ptr<std::string> data;
+};
+}
@@ -0,0 +1,180 @@
+#include "contacts_writer.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <userver/logging/log.hpp>
+
+ens::notifications::telegram::TelegramContactsWriter::TelegramContactsWriter(userver::storages::postgres::ClusterPtr pg_cluster,
+                                                                             std::chrono::milliseconds flush_interval,
+                                                                             size_t max_batch_size)
+    : _pg_cluster(std::move(pg_cluster)),
+      _max_batch_size(max_batch_size) {
+  _flush_task.Start("telegram-contacts-flush", {flush_interval}, [this] { Flush(); });
+}
+
+ens::notifications::telegram::TelegramContactsWriter::~TelegramContactsWriter() {
+  _flush_task.Stop();
+  Flush();
+}
+
+ens::notifications::telegram::ContactChange ens::notifications::telegram::TelegramContactsWriter::SetActive(int64_t user_id,
+                                                                                                          bool active,
+                                                                                                          int32_t bot_index) {
+  userver::engine::Promise<ContactChange> promise;
+  userver::engine::Future<ContactChange> future = promise.get_future();
+  bool batch_full;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    _pending.push_back({user_id, active, bot_index, std::move(promise)});
+    batch_full = _pending.size() >= _max_batch_size;
+  }
+  if (batch_full) {
+    _flush_task.ForceStepAsync();
+  }
+  return future.get();
+}
+
+void ens::notifications::telegram::TelegramContactsWriter::Flush() {
+  const userver::storages::postgres::Query upsert_query{
+      "INSERT INTO ens_schema.telegram_contact "
+      "(user_id, active, bot_index) "
+      "SELECT user_id, active, bot_index FROM ( "
+      "SELECT user_id, true AS active, bot_index FROM UNNEST($1::BIGINT[], $3::INTEGER[]) AS activated(user_id, bot_index) "
+      "UNION ALL "
+      "SELECT UNNEST($2::BIGINT[]), false, 0) AS changes "
+      "ON CONFLICT (user_id) DO UPDATE "
+      "SET active = EXCLUDED.active, "
+      "bot_index = CASE WHEN EXCLUDED.active THEN EXCLUDED.bot_index ELSE telegram_contact.bot_index END "
+      "WHERE telegram_contact.active <> EXCLUDED.active "
+      "OR (EXCLUDED.active AND telegram_contact.bot_index <> EXCLUDED.bot_index) "
+      "RETURNING user_id, (xmax = 0) AS created"
+  };
+  std::vector<PendingChange> batch;
+  {
+    std::lock_guard<userver::engine::Mutex> lock(_mutex);
+    batch.swap(_pending);
+  }
+  if (batch.empty()) {
+    return;
+  }
+  // A row can be upserted only once per statement, the latest requested state wins
+  std::unordered_map<int64_t, const PendingChange *> requested_state;
+  for (const PendingChange &change : batch) {
+    requested_state[change.user_id] = &change;
+  }
+  std::vector<int64_t> activated_ids;
+  std::vector<int32_t> activated_bots;
+  std::vector<int64_t> deactivated_ids;
+  for (const auto &[user_id, change] : requested_state) {
+    if (change->active) {
+      activated_ids.push_back(user_id);
+      activated_bots.push_back(change->bot_index);
+    } else {
+      deactivated_ids.push_back(user_id);
+    }
+  }
+  try {
+    userver::storages::postgres::Transaction upsert_transaction =
+        _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+    userver::storages::postgres::ResultSet upsert_res = upsert_transaction.Execute(upsert_query,
+                                                                                   activated_ids,
+                                                                                   deactivated_ids,
+                                                                                   activated_bots);
+    upsert_transaction.Commit();
+    std::unordered_map<int64_t, ContactChange> changes;
+    for (auto row : upsert_res) {
+      changes[row["user_id"].As<int64_t>()] = row["created"].As<bool>() ? ContactChange::Created
+                                                                         : ContactChange::Updated;
+    }
+    for (PendingChange &change : batch) {
+      const auto change_it = changes.find(change.user_id);
+      change.promise.set_value(change_it == changes.cend() ? ContactChange::None : change_it->second);
+    }
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error writing " << batch.size() << " telegram contact changes: " << e.what();
+    for (PendingChange &change : batch) {
+      change.promise.set_exception(std::current_exception());
+    }
+  }
+}
+
+bool ens::notifications::telegram::TelegramContactsWriter::SetChannelOptOut(int64_t user_id, bool opt_out) {
+  const userver::storages::postgres::Query opt_out_query{
+      "UPDATE ens_schema.telegram_contact "
+      "SET channel_opt_out = $2 "
+      "WHERE user_id = $1 AND active"
+  };
+  userver::storages::postgres::Transaction update_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet update_res = update_transaction.Execute(opt_out_query, user_id, opt_out);
+  update_transaction.Commit();
+  return update_res.RowsAffected() > 0;
+}
+
+void ens::notifications::telegram::TelegramContactsWriter::Deactivate(const std::vector<int64_t> &user_ids) {
+  const userver::storages::postgres::Query deactivate_query{
+      "UPDATE ens_schema.telegram_contact "
+      "SET active = false "
+      "WHERE user_id = ANY($1) AND active"
+  };
+  if (user_ids.empty()) {
+    return;
+  }
+  userver::storages::postgres::Transaction update_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  update_transaction.Execute(deactivate_query, user_ids);
+  update_transaction.Commit();
+}
+
+void ens::notifications::telegram::TelegramContactsWriter::Migrate(const std::vector<int64_t> &old_ids,
+                                                                   const std::vector<int64_t> &new_ids) {
+  const userver::storages::postgres::Query migrate_contacts_query{
+      "INSERT INTO ens_schema.telegram_contact "
+      "(user_id, active, bot_index) "
+      "SELECT DISTINCT ON (migrations.new_id) migrations.new_id, true, COALESCE(old_contact.bot_index, 0) "
+      "FROM UNNEST($1::BIGINT[], $2::BIGINT[]) AS migrations(old_id, new_id) "
+      "LEFT JOIN ens_schema.telegram_contact AS old_contact ON old_contact.user_id = migrations.old_id "
+      "ORDER BY migrations.new_id, old_contact.active DESC NULLS LAST "
+      "ON CONFLICT (user_id) DO UPDATE "
+      "SET active = true, bot_index = EXCLUDED.bot_index"
+  };
+  const userver::storages::postgres::Query migrate_recipients_query{
+      "UPDATE ens_schema.recipient "
+      "SET telegram_id = migrations.new_id "
+      "FROM UNNEST($1::BIGINT[], $2::BIGINT[]) AS migrations(old_id, new_id) "
+      "WHERE recipient.telegram_id = migrations.old_id"
+  };
+  const userver::storages::postgres::Query deactivate_old_query{
+      "UPDATE ens_schema.telegram_contact "
+      "SET active = false "
+      "WHERE user_id = ANY($1)"
+  };
+  if (old_ids.empty()) {
+    return;
+  }
+  // A migrated chat is often reached through several recipients or groups of a batch, an upsert can't touch
+  // the same row twice
+  std::vector<std::pair<int64_t, int64_t>> migrations;
+  migrations.reserve(old_ids.size());
+  for (size_t i = 0; i < old_ids.size(); ++i) {
+    migrations.emplace_back(old_ids[i], new_ids[i]);
+  }
+  std::sort(migrations.begin(), migrations.end());
+  migrations.erase(std::unique(migrations.begin(), migrations.end()), migrations.end());
+  std::vector<int64_t> unique_old_ids;
+  std::vector<int64_t> unique_new_ids;
+  unique_old_ids.reserve(migrations.size());
+  unique_new_ids.reserve(migrations.size());
+  for (const auto &[old_id, new_id] : migrations) {
+    unique_old_ids.push_back(old_id);
+    unique_new_ids.push_back(new_id);
+  }
+  userver::storages::postgres::Transaction migrate_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  migrate_transaction.Execute(migrate_contacts_query, unique_old_ids, unique_new_ids);
+  migrate_transaction.Execute(migrate_recipients_query, unique_old_ids, unique_new_ids);
+  migrate_transaction.Execute(deactivate_old_query, unique_old_ids);
+  migrate_transaction.Commit();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <userver/engine/future.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+namespace ens::notifications::telegram {
+enum class ContactChange {
+  None,  // contact already had the requested state
+  Created,
+  Updated
+};
+
+// Coalesces telegram_contact state changes made during a short window into a single upsert
+class TelegramContactsWriter {
+ public:
+  TelegramContactsWriter(userver::storages::postgres::ClusterPtr pg_cluster,
+                         std::chrono::milliseconds flush_interval,
+                         size_t max_batch_size);
+  ~TelegramContactsWriter();
+  // Blocks until the batch containing the change is committed.
+  // Activation also reassigns the contact to the bot it was made through
+  ContactChange SetActive(int64_t user_id, bool active, int32_t bot_index);
+  // Returns false if the user is not subscribed to notifications
+  bool SetChannelOptOut(int64_t user_id, bool opt_out);
+  void Deactivate(const std::vector<int64_t> &user_ids);
+  // Moves contacts and recipients of chats migrated to supergroups to the new chat ids
+  void Migrate(const std::vector<int64_t> &old_ids, const std::vector<int64_t> &new_ids);
+ private:
+  struct PendingChange {
+    int64_t user_id;
+    bool active;
+    int32_t bot_index;
+    userver::engine::Promise<ContactChange> promise;
+  };
+  void Flush();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  const size_t _max_batch_size;
+  userver::engine::Mutex _mutex;
+  std::vector<PendingChange> _pending;
+  userver::utils::PeriodicTask _flush_task;
+};
+}
@@ -0,0 +1,66 @@
+#include "handlers.hpp"
+
+#include <userver/crypto/algorithm.hpp>
+#include <userver/formats/json/exception.hpp>
+
+userver::formats::json::Value ens::notifications::telegram::TelegramWebhookHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                          const userver::formats::json::Value &request_json,
+                                                                                                          userver::server::request::RequestContext &) const {
+  const std::string &secret_token = request.GetHeader(WEBHOOK_SECRET_TOKEN_HEADER);
+  if (_secdist_config._webhook_secret.empty()
+      or not userver::crypto::algorithm::AreStringsEqualConstTime(secret_token, _secdist_config._webhook_secret)) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{"Incorrect webhook secret token"},
+        userver::server::handlers::ExternalBody{"Incorrect webhook secret token"}
+    };
+  }
+  if (_telegram_bot.GetUpdateMode() != userver::telegram::bot::TelegramBotLongPoller::UpdateMode::kWebhook) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{"Webhook update mode is disabled"},
+        userver::server::handlers::ExternalBody{"Webhook update mode is disabled"}
+    };
+  }
+  userver::telegram::bot::Update update;
+  try {
+    update = request_json.As<userver::telegram::bot::Update>();
+  }
+  catch (const userver::formats::json::Exception &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  // Webhook of every bot of the pool is registered with its own bot_index argument
+  size_t bot_index = 0;
+  if (request.HasArg("bot_index")) {
+    try {
+      bot_index = std::stoul(request.GetArg("bot_index"));
+    }
+    catch (const std::exception &) {
+      bot_index = _telegram_bot.GetBotsCount();
+    }
+  }
+  if (bot_index >= _telegram_bot.GetBotsCount()) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::handlers::InternalMessage{"Incorrect bot_index"},
+        userver::server::handlers::ExternalBody{"Incorrect bot_index"}
+    };
+  }
+  // Telegram redelivers the update later if all handler slots are busy
+  if (not _telegram_bot.TryHandlePushedUpdate(std::move(update), bot_index)) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kTooManyRequests,
+        userver::server::handlers::InternalMessage{"All update handlers are busy"},
+        userver::server::handlers::ExternalBody{"All update handlers are busy"}
+    };
+  }
+  return userver::formats::json::Value{};
+}
+
+void ens::notifications::telegram::AppendTelegramWebhookHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<TelegramWebhookHandler>();
+}
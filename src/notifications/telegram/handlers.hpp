@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <userver/server/handlers/http_handler_json_base.hpp>
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/storages/secdist/component.hpp>
+
+#include "notifications/telegram/telegram_bot.hpp"
+#include "utils/utils.hpp"
+
+namespace ens::notifications::telegram {
+const std::string WEBHOOK_SECRET_TOKEN_HEADER{"X-Telegram-Bot-Api-Secret-Token"};
+
+// Receives updates pushed by telegram when the bot works in webhook update mode
+class TelegramWebhookHandler : public userver::server::handlers::HttpHandlerJsonBase {
+ public:
+  static constexpr std::string_view kName = "handler-telegram-webhook";
+  TelegramWebhookHandler(const userver::components::ComponentConfig &config,
+                         const userver::components::ComponentContext &context)
+      : HttpHandlerJsonBase(config, context),
+        _telegram_bot(context.FindComponent<TelegramNotificationsBot>()),
+        _secdist_config(
+            context.FindComponent<userver::components::Secdist>().Get().Get<ens::utils::TelegramWebhookSecdistConfig>()
+        ) {}
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &request_json,
+                                                       userver::server::request::RequestContext &) const override;
+ private:
+  TelegramNotificationsBot &_telegram_bot;
+  ens::utils::TelegramWebhookSecdistConfig _secdist_config;
+};
+
+void AppendTelegramWebhookHandler(userver::components::ComponentList &component_list);
+}
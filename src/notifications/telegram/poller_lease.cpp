@@ -0,0 +1,123 @@
+#include "poller_lease.hpp"
+
+#include <userver/logging/log.hpp>
+#include <userver/utils/boost_uuid7.hpp>
+
+namespace {
+int64_t SteadyNowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+ens::notifications::telegram::TelegramPollerLease::TelegramPollerLease(userver::storages::postgres::ClusterPtr pg_cluster,
+                                                                       size_t bots_count,
+                                                                       std::chrono::milliseconds lease_duration)
+    : _pg_cluster(std::move(pg_cluster)),
+      _holder_id(userver::utils::generators::GenerateBoostUuidV7()),
+      _lease_duration(lease_duration),
+      _held_until(bots_count) {}
+
+ens::notifications::telegram::TelegramPollerLease::~TelegramPollerLease() {
+  _renew_task.Stop();
+}
+
+void ens::notifications::telegram::TelegramPollerLease::Start() {
+  // Leases are renewed several times per duration, so that a single failed renewal doesn't lose them
+  _renew_task.Start("telegram-poller-lease-renew",
+                    {_lease_duration / 3, {userver::utils::PeriodicTask::Flags::kNow}},
+                    [this] { Renew(); });
+}
+
+void ens::notifications::telegram::TelegramPollerLease::Renew() {
+  // Expiration is measured by the database clock, so that the clocks of the instances don't have to agree
+  const userver::storages::postgres::Query renew_query{
+      "INSERT INTO ens_schema.telegram_poller_lease AS lease "
+      "(bot_index, holder_id, expires_at) "
+      "SELECT bot_index, $2, (EXTRACT(EPOCH FROM clock_timestamp()) * 1000)::BIGINT + $3 "
+      "FROM generate_series(0, $1 - 1) AS bot_index "
+      "ON CONFLICT (bot_index) DO UPDATE "
+      "SET holder_id = EXCLUDED.holder_id, expires_at = EXCLUDED.expires_at "
+      "WHERE lease.holder_id = EXCLUDED.holder_id "
+      "OR lease.expires_at < (EXTRACT(EPOCH FROM clock_timestamp()) * 1000)::BIGINT "
+      "RETURNING bot_index"
+  };
+  // The lease can't expire in the database earlier than the duration after the renewal has started
+  const int64_t held_until = SteadyNowMs() + _lease_duration.count();
+  std::vector<bool> held(_held_until.size(), false);
+  try {
+    userver::storages::postgres::Transaction renew_transaction =
+        _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+    userver::storages::postgres::ResultSet renew_res = renew_transaction.Execute(renew_query,
+                                                                                 static_cast<int32_t>(_held_until.size()),
+                                                                                 _holder_id,
+                                                                                 static_cast<int64_t>(_lease_duration.count()));
+    renew_transaction.Commit();
+    for (auto row : renew_res) {
+      held[row["bot_index"].As<int32_t>()] = true;
+    }
+  }
+  catch (const std::exception &e) {
+    // Leases held so far stay valid until they expire
+    LOG_ERROR() << "Error renewing telegram poller leases: " << e.what();
+    return;
+  }
+  for (size_t i = 0; i < held.size(); ++i) {
+    const int64_t previous = _held_until[i].exchange(held[i] ? held_until : 0);
+    if (held[i] != (previous > SteadyNowMs())) {
+      LOG_INFO() << (held[i] ? "Acquired" : "Lost") << " telegram poller lease, bot_index=" << i;
+    }
+  }
+}
+
+void ens::notifications::telegram::TelegramPollerLease::Release() {
+  _renew_task.Stop();
+  const userver::storages::postgres::Query release_query{
+      "UPDATE ens_schema.telegram_poller_lease "
+      "SET expires_at = 0 "
+      "WHERE holder_id = $1"
+  };
+  for (std::atomic<int64_t> &held_until : _held_until) {
+    held_until = 0;
+  }
+  try {
+    _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster, release_query, _holder_id);
+  }
+  catch (const std::exception &e) {
+    LOG_WARNING() << "Error releasing telegram poller leases: " << e.what();
+  }
+}
+
+bool ens::notifications::telegram::TelegramPollerLease::IsHeld(size_t bot_index) const {
+  return _held_until.at(bot_index).load() > SteadyNowMs();
+}
+
+int64_t ens::notifications::telegram::TelegramPollerLease::LoadOffset(size_t bot_index) {
+  const userver::storages::postgres::Query offset_query{
+      "SELECT update_offset "
+      "FROM ens_schema.telegram_poller_lease "
+      "WHERE bot_index = $1"
+  };
+  // Read from the master, a lagging replica would make the new poller handle the updates again
+  userver::storages::postgres::ResultSet offset_res =
+      _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                           offset_query,
+                           static_cast<int32_t>(bot_index));
+  if (offset_res.IsEmpty()) {
+    return 0;
+  }
+  return offset_res.AsSingleRow<int64_t>();
+}
+
+void ens::notifications::telegram::TelegramPollerLease::CommitOffset(size_t bot_index, int64_t offset) {
+  const userver::storages::postgres::Query commit_query{
+      "UPDATE ens_schema.telegram_poller_lease "
+      "SET update_offset = $3 "
+      "WHERE bot_index = $1 AND holder_id = $2 AND update_offset < $3"
+  };
+  _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kMaster,
+                       commit_query,
+                       static_cast<int32_t>(bot_index),
+                       _holder_id,
+                       offset);
+}
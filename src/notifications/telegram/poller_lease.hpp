@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/periodic_task.hpp>
+
+namespace ens::notifications::telegram {
+// Elects the single instance of the service polling the updates of every bot. Instances renew their leases
+// in Postgres, a lease that isn't renewed in time passes to another instance. The offset of the handled updates
+// is stored with the lease, so that the next poller continues where the previous one has stopped
+class TelegramPollerLease {
+ public:
+  TelegramPollerLease(userver::storages::postgres::ClusterPtr pg_cluster,
+                      size_t bots_count,
+                      std::chrono::milliseconds lease_duration);
+  ~TelegramPollerLease();
+  void Start();
+  // Hands the leases over to the other instances without waiting for them to expire
+  void Release();
+  bool IsHeld(size_t bot_index) const;
+  int64_t LoadOffset(size_t bot_index);
+  // The offset is stored only while the lease is held, so that a stale poller doesn't move it back
+  void CommitOffset(size_t bot_index, int64_t offset);
+ private:
+  void Renew();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  const boost::uuids::uuid _holder_id;
+  const std::chrono::milliseconds _lease_duration;
+  // Steady clock time in milliseconds the lease of every bot is surely held until
+  std::vector<std::atomic<int64_t>> _held_until;
+  userver::utils::PeriodicTask _renew_task;
+};
+}
@@ -0,0 +1,242 @@
+#include "responses_writer.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#include <userver/crypto/base64.hpp>
+#include <userver/logging/log.hpp>
+
+namespace {
+constexpr char kCallbackDataSeparator = ':';
+
+std::string EncodeUuid(const boost::uuids::uuid &id) {
+  return userver::crypto::base64::Base64UrlEncode(
+      std::string_view{reinterpret_cast<const char *>(id.data), id.size()},
+      userver::crypto::base64::Pad::kWithout);
+}
+
+std::optional<boost::uuids::uuid> DecodeUuid(std::string_view encoded) {
+  std::string bytes;
+  try {
+    bytes = userver::crypto::base64::Base64UrlDecode(encoded);
+  }
+  catch (const std::exception &) {
+    return std::nullopt;
+  }
+  boost::uuids::uuid id{};
+  if (bytes.size() != id.size()) {
+    return std::nullopt;
+  }
+  std::copy(bytes.cbegin(), bytes.cend(), id.begin());
+  return id;
+}
+}
+
+std::string_view ens::notifications::telegram::ToString(ResponseStatus status) {
+  return kResponseStatusMapping.TryFindByFirst(status).value();
+}
+
+std::string ens::notifications::telegram::MakeResponseCallbackData(ResponseStatus status,
+                                                                   const boost::uuids::uuid &notification_id,
+                                                                   const boost::uuids::uuid &batch_id) {
+  std::string data{ToString(status)};
+  data += kCallbackDataSeparator;
+  data += EncodeUuid(notification_id);
+  data += kCallbackDataSeparator;
+  data += EncodeUuid(batch_id);
+  return data;
+}
+
+std::optional<ens::notifications::telegram::RecipientResponse> ens::notifications::telegram::ParseResponseCallbackData(
+    std::string_view data) {
+  const size_t status_end = data.find(kCallbackDataSeparator);
+  if (status_end == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const size_t notification_end = data.find(kCallbackDataSeparator, status_end + 1);
+  if (notification_end == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const std::optional<ResponseStatus> status = kResponseStatusMapping.TryFindBySecond(data.substr(0, status_end));
+  const std::optional<boost::uuids::uuid> notification_id =
+      DecodeUuid(data.substr(status_end + 1, notification_end - status_end - 1));
+  const std::optional<boost::uuids::uuid> batch_id = DecodeUuid(data.substr(notification_end + 1));
+  if (not status.has_value() or not notification_id.has_value() or not batch_id.has_value()) {
+    return std::nullopt;
+  }
+  return RecipientResponse{notification_id.value(), batch_id.value(), status.value(), 0, 0};
+}
+
+ens::notifications::telegram::RecipientResponsesWriter::RecipientResponsesWriter(userver::storages::postgres::ClusterPtr pg_cluster,
+                                                                                 BatchProgressTracker &progress_tracker,
+                                                                                 std::chrono::milliseconds flush_interval,
+                                                                                 std::chrono::milliseconds tallies_flush_interval,
+                                                                                 size_t shards_count)
+    : _pg_cluster(std::move(pg_cluster)),
+      _progress_tracker(progress_tracker),
+      _shards(shards_count) {
+  _responses_flush_task.Start("telegram-responses-flush", {flush_interval}, [this] { FlushResponses(); });
+  _tallies_flush_task.Start("telegram-response-tallies-flush", {tallies_flush_interval}, [this] { FlushTallies(); });
+}
+
+ens::notifications::telegram::RecipientResponsesWriter::~RecipientResponsesWriter() {
+  _responses_flush_task.Stop();
+  _tallies_flush_task.Stop();
+  FlushResponses();
+  FlushTallies();
+}
+
+ens::notifications::telegram::RecipientResponsesWriter::Shard &ens::notifications::telegram::RecipientResponsesWriter::GetShard(
+    const boost::uuids::uuid &id) {
+  return _shards[boost::hash<boost::uuids::uuid>{}(id) % _shards.size()];
+}
+
+void ens::notifications::telegram::RecipientResponsesWriter::Record(const RecipientResponse &response) {
+  Shard &shard = GetShard(response.notification_id);
+  std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+  shard.responses.insert_or_assign(response.notification_id, response);
+}
+
+ens::notifications::telegram::ResponseTally ens::notifications::telegram::RecipientResponsesWriter::GetPendingTally(
+    const boost::uuids::uuid &batch_id) {
+  Shard &shard = GetShard(batch_id);
+  std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+  const auto tally_it = shard.tallies.find(batch_id);
+  return tally_it == shard.tallies.cend() ? ResponseTally{} : tally_it->second;
+}
+
+void ens::notifications::telegram::RecipientResponsesWriter::AddToTally(const boost::uuids::uuid &batch_id,
+                                                                        ResponseStatus status,
+                                                                        int64_t delta) {
+  Shard &shard = GetShard(batch_id);
+  std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+  shard.tallies[batch_id][static_cast<size_t>(status)] += delta;
+}
+
+void ens::notifications::telegram::RecipientResponsesWriter::FlushResponses() {
+  // Previous statuses are read in the same snapshot as the upsert, so a changed response moves between the tallies.
+  // Responses repeating the stored status and the ones to unknown batches aren't returned
+  const userver::storages::postgres::Query upsert_query{
+      "WITH incoming AS ( "
+      "SELECT * FROM UNNEST($1::uuid[], $2::uuid[], $3::ens_schema.response_status[], $4::BIGINT[], $5::BIGINT[]) "
+      "AS incoming(notification_id, batch_id, status, telegram_id, response_timestamp)), "
+      "previous AS ( "
+      "SELECT notification_response.notification_id, notification_response.status "
+      "FROM ens_schema.notification_response "
+      "INNER JOIN incoming ON notification_response.notification_id = incoming.notification_id "
+      "FOR UPDATE OF notification_response), "
+      "upserted AS ( "
+      "INSERT INTO ens_schema.notification_response "
+      "(notification_id, batch_id, status, telegram_id, response_timestamp) "
+      "SELECT incoming.notification_id, incoming.batch_id, incoming.status, incoming.telegram_id, incoming.response_timestamp "
+      "FROM incoming "
+      "INNER JOIN ens_schema.notifications_batch ON incoming.batch_id = notifications_batch.batch_id "
+      "ON CONFLICT (notification_id) DO UPDATE "
+      "SET status = EXCLUDED.status, telegram_id = EXCLUDED.telegram_id, response_timestamp = EXCLUDED.response_timestamp "
+      "WHERE notification_response.status <> EXCLUDED.status "
+      "RETURNING notification_id, batch_id, status) "
+      "SELECT upserted.batch_id, upserted.status, previous.status AS previous_status "
+      "FROM upserted "
+      "LEFT JOIN previous ON upserted.notification_id = previous.notification_id"
+  };
+  std::vector<RecipientResponse> batch;
+  for (Shard &shard : _shards) {
+    std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+    for (const auto &[notification_id, response] : shard.responses) {
+      batch.push_back(response);
+    }
+    shard.responses.clear();
+  }
+  if (batch.empty()) {
+    return;
+  }
+  std::vector<boost::uuids::uuid> notification_ids;
+  std::vector<boost::uuids::uuid> batch_ids;
+  std::vector<ResponseStatus> statuses;
+  std::vector<int64_t> telegram_ids;
+  std::vector<int64_t> response_timestamps;
+  for (const RecipientResponse &response : batch) {
+    notification_ids.push_back(response.notification_id);
+    batch_ids.push_back(response.batch_id);
+    statuses.push_back(response.status);
+    telegram_ids.push_back(response.telegram_id);
+    response_timestamps.push_back(response.response_timestamp);
+  }
+  try {
+    userver::storages::postgres::Transaction upsert_transaction =
+        _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+    userver::storages::postgres::ResultSet upsert_res = upsert_transaction.Execute(upsert_query,
+                                                                                   notification_ids,
+                                                                                   batch_ids,
+                                                                                   statuses,
+                                                                                   telegram_ids,
+                                                                                   response_timestamps);
+    upsert_transaction.Commit();
+    std::unordered_map<boost::uuids::uuid, int64_t, boost::hash<boost::uuids::uuid>> first_responses;
+    for (auto row : upsert_res) {
+      const auto batch_id = row["batch_id"].As<boost::uuids::uuid>();
+      AddToTally(batch_id, row["status"].As<ResponseStatus>(), 1);
+      const auto previous_status = row["previous_status"].As<std::optional<ResponseStatus>>();
+      if (previous_status.has_value()) {
+        AddToTally(batch_id, previous_status.value(), -1);
+      } else {
+        ++first_responses[batch_id];
+      }
+    }
+    for (const auto &[batch_id, responded] : first_responses) {
+      _progress_tracker.AddResponded(batch_id, responded);
+    }
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error writing " << batch.size() << " recipient responses: " << e.what();
+    // Responses are retried by the next flush unless newer ones have arrived meanwhile
+    for (const RecipientResponse &response : batch) {
+      Shard &shard = GetShard(response.notification_id);
+      std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+      shard.responses.try_emplace(response.notification_id, response);
+    }
+  }
+}
+
+void ens::notifications::telegram::RecipientResponsesWriter::FlushTallies() {
+  const userver::storages::postgres::Query increment_query{
+      "INSERT INTO ens_schema.batch_response_tally "
+      "(batch_id, status, responses) "
+      "SELECT changes.batch_id, changes.status, changes.delta "
+      "FROM UNNEST($1::uuid[], $2::ens_schema.response_status[], $3::BIGINT[]) AS changes(batch_id, status, delta) "
+      "INNER JOIN ens_schema.notifications_batch ON changes.batch_id = notifications_batch.batch_id "
+      "ON CONFLICT (batch_id, status) DO UPDATE "
+      "SET responses = batch_response_tally.responses + EXCLUDED.responses"
+  };
+  std::vector<boost::uuids::uuid> batch_ids;
+  std::vector<ResponseStatus> statuses;
+  std::vector<int64_t> deltas;
+  for (Shard &shard : _shards) {
+    std::lock_guard<userver::engine::Mutex> lock(shard.mutex);
+    for (const auto &[batch_id, tally] : shard.tallies) {
+      for (size_t status = 0; status < kResponseStatusesCount; ++status) {
+        if (tally[status] != 0) {
+          batch_ids.push_back(batch_id);
+          statuses.push_back(static_cast<ResponseStatus>(status));
+          deltas.push_back(tally[status]);
+        }
+      }
+    }
+    shard.tallies.clear();
+  }
+  if (batch_ids.empty()) {
+    return;
+  }
+  try {
+    userver::storages::postgres::Transaction increment_transaction =
+        _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+    increment_transaction.Execute(increment_query, batch_ids, statuses, deltas);
+    increment_transaction.Commit();
+  }
+  catch (const std::exception &e) {
+    LOG_ERROR() << "Error writing " << batch_ids.size() << " response tally changes: " << e.what();
+    for (size_t i = 0; i < batch_ids.size(); ++i) {
+      AddToTally(batch_ids[i], statuses[i], deltas[i]);
+    }
+  }
+}
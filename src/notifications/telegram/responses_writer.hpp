@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/io/enum_types.hpp>
+#include <userver/utils/periodic_task.hpp>
+#include <userver/utils/trivial_map.hpp>
+
+#include "notifications/batch_progress.hpp"
+
+namespace ens::notifications::telegram {
+// Safety statuses a recipient reports with the buttons of a notification
+enum class ResponseStatus {
+  Safe,
+  NeedHelp
+};
+
+inline constexpr size_t kResponseStatusesCount = 2;
+
+inline constexpr userver::utils::TrivialBiMap kResponseStatusMapping = [](auto selector) {
+  return selector()
+      .template Type<ResponseStatus, std::string_view>()
+      .Case(ResponseStatus::Safe, "Safe")
+      .Case(ResponseStatus::NeedHelp, "NeedHelp");
+};
+
+std::string_view ToString(ResponseStatus status);
+
+struct RecipientResponse {
+  boost::uuids::uuid notification_id;
+  boost::uuids::uuid batch_id;
+  ResponseStatus status;
+  int64_t telegram_id;
+  int64_t response_timestamp;
+};
+
+// Callback data of a status button, the ids are base64 encoded to fit the 64 bytes telegram allows
+std::string MakeResponseCallbackData(ResponseStatus status,
+                                     const boost::uuids::uuid &notification_id,
+                                     const boost::uuids::uuid &batch_id);
+// Fills the status and the ids of the response, nullopt if the data wasn't made by MakeResponseCallbackData
+std::optional<RecipientResponse> ParseResponseCallbackData(std::string_view data);
+
+// Number of the responses of every status
+using ResponseTally = std::array<int64_t, kResponseStatusesCount>;
+
+// Collects the responses into batched upserts keyed by the notification. Changes of the per-batch tallies
+// are accumulated in memory and added to the stored tallies by a separate, less frequent write,
+// since every response of a batch updates the same rows. Both are sharded to keep the ingestion uncontended
+class RecipientResponsesWriter {
+ public:
+  RecipientResponsesWriter(userver::storages::postgres::ClusterPtr pg_cluster,
+                           BatchProgressTracker &progress_tracker,
+                           std::chrono::milliseconds flush_interval,
+                           std::chrono::milliseconds tallies_flush_interval,
+                           size_t shards_count);
+  ~RecipientResponsesWriter();
+  // Doesn't wait for the write, a later response to the same notification replaces the pending one
+  void Record(const RecipientResponse &response);
+  // Changes of the tallies of the batch not yet written to the database
+  ResponseTally GetPendingTally(const boost::uuids::uuid &batch_id);
+ private:
+  struct Shard {
+    userver::engine::Mutex mutex;
+    std::unordered_map<boost::uuids::uuid, RecipientResponse, boost::hash<boost::uuids::uuid>> responses;
+    std::unordered_map<boost::uuids::uuid, ResponseTally, boost::hash<boost::uuids::uuid>> tallies;
+  };
+  Shard &GetShard(const boost::uuids::uuid &id);
+  void AddToTally(const boost::uuids::uuid &batch_id, ResponseStatus status, int64_t delta);
+  void FlushResponses();
+  void FlushTallies();
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  BatchProgressTracker &_progress_tracker;
+  std::vector<Shard> _shards;
+  userver::utils::PeriodicTask _responses_flush_task;
+  userver::utils::PeriodicTask _tallies_flush_task;
+};
+}
+
+// Postgres to cpp type mappings
+namespace USERVER_NAMESPACE::storages::postgres::io {
+template<>
+struct CppToUserPg<ens::notifications::telegram::ResponseStatus> {
+  static constexpr userver::storages::postgres::DBTypeName postgres_name = "ens_schema.response_status";
+  static constexpr userver::utils::TrivialBiMap enumerators = ens::notifications::telegram::kResponseStatusMapping;
+};
+}
@@ -1,107 +1,334 @@
 #include "telegram_bot.hpp"
 
+#include <algorithm>
+
+#include <userver/engine/exception.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/datetime.hpp>
 #include <userver/yaml_config/merge_schemas.hpp>
 #include <userver/telegram/bot/requests/send_message.hpp>
+#include <userver/telegram/bot/types/inline_keyboard_markup.hpp>
+
+ens::notifications::telegram::DeliveryStatus ens::notifications::telegram::ClassifyDelivery(const userver::telegram::bot::AckReply &ack) {
+  if (ack.ok) {
+    return DeliveryStatus::Delivered;
+  }
+  if (ack.migrate_to_chat_id.has_value()) {
+    return DeliveryStatus::Migrated;
+  }
+  const int error_code = ack.error_code.value_or(0);
+  if (error_code == 403) {
+    return DeliveryStatus::Blocked;
+  }
+  if (error_code == 400 and ack.description.value_or("").find("chat not found") != std::string::npos) {
+    return DeliveryStatus::ChatNotFound;
+  }
+  return DeliveryStatus::Transient;
+}
+
+userver::telegram::bot::AckReply ens::notifications::telegram::GetSendAck(SendFuture &future) {
+  return std::visit([](auto &request_future) { return request_future.GetAck(); }, future);
+}
 
 userver::yaml_config::Schema ens::notifications::telegram::TelegramNotificationsBot::GetStaticConfigSchema() {
   return userver::yaml_config::MergeSchemas<userver::telegram::bot::TelegramBotLongPoller>(R"(
     type: object
     description: Component for telegram notifier bot
     additionalProperties: false
-    properties: {}
+    properties:
+        contacts-flush-interval:
+            type: string
+            description: Interval during which subscription changes are collected into a single database write
+            defaultDescription: 20ms
+        contacts-max-batch-size:
+            type: integer
+            description: Number of collected subscription changes that triggers the write before the interval ends
+            defaultDescription: 1000
+            minimum: 1
+        messages-per-second:
+            type: integer
+            description: Maximum rate of messages sent by each bot of the pool
+            defaultDescription: 30
+            minimum: 1
+        cluster-rate-budget:
+            type: boolean
+            description: Share the rate limit of every bot between all the instances of the service through the database
+            defaultDescription: false
+        rate-budget-max-slice:
+            type: integer
+            description: Maximum number of messages of the shared rate limit an instance leases at once
+            defaultDescription: 10
+            minimum: 1
+        responses-flush-interval:
+            type: string
+            description: Interval during which the responses of the recipients are collected into a single database write
+            defaultDescription: 100ms
+        response-tallies-flush-interval:
+            type: string
+            description: Interval during which the changes of the per-batch response tallies are collected into a single database write
+            defaultDescription: 1s
+        responses-shards:
+            type: integer
+            description: Number of the independently locked parts of the collected responses and tallies
+            defaultDescription: 16
+            minimum: 1
+        poller-lease-duration:
+            type: string
+            description: Time the instance polling the updates keeps the lease without renewing it, the polling passes to another instance once it expires
+            defaultDescription: 15s
   )");
 }
 
-void ens::notifications::telegram::TelegramNotificationsBot::SendMessage(const userver::telegram::bot::ChatId &chat_id,
-                                                                         const std::string &msg_text) {
+void ens::notifications::telegram::TelegramNotificationsBot::OnAllComponentsLoaded() {
+  // Pushed updates reach any instance, only the polling of the updates needs a leader.
+  // The lease is taken once the service is up, an instance failing to start doesn't hold it
+  if (GetUpdateMode() == UpdateMode::kLongPolling) {
+    _poller_lease.Start();
+  }
+  userver::telegram::bot::TelegramBotLongPoller::OnAllComponentsLoaded();
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::OnAllComponentsAreStopping() {
+  userver::telegram::bot::TelegramBotLongPoller::OnAllComponentsAreStopping();
+  if (GetUpdateMode() == UpdateMode::kLongPolling) {
+    _poller_lease.Release();
+  }
+}
+
+bool ens::notifications::telegram::TelegramNotificationsBot::IsPollingAllowed(size_t bot_index) {
+  return _poller_lease.IsHeld(bot_index);
+}
+
+int64_t ens::notifications::telegram::TelegramNotificationsBot::LoadOffset(size_t bot_index) {
+  return _poller_lease.LoadOffset(bot_index);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::CommitOffset(size_t bot_index, int64_t offset) {
+  _poller_lease.CommitOffset(bot_index, offset);
+}
+
+size_t ens::notifications::telegram::TelegramNotificationsBot::GetBotsCount() const {
+  return GetClients().size();
+}
+
+int32_t ens::notifications::telegram::TelegramNotificationsBot::GetBotIndex(const userver::telegram::bot::ClientPtr &client) const {
+  const std::vector<userver::telegram::bot::ClientPtr> &clients = GetClients();
+  const auto client_it = std::find(clients.cbegin(), clients.cend(), client);
+  return client_it == clients.cend() ? 0 : static_cast<int32_t>(client_it - clients.cbegin());
+}
+
+userver::telegram::bot::ReplyMarkup ens::notifications::telegram::TelegramNotificationsBot::MakeResponseKeyboard(const ResponseTarget &response_target) {
   using namespace userver::telegram::bot;
-  const SendMessageMethod::Parameters msg_params{chat_id, msg_text};
-  Request<SendMessageMethod> sent_msg = this->GetClient()->SendMessage(msg_params,
-                                                                       userver::telegram::bot::RequestOptions{});
-  sent_msg.Perform();
+  InlineKeyboardButton safe_button;
+  safe_button.text = "I'm safe";
+  safe_button.callback_data = MakeResponseCallbackData(ResponseStatus::Safe,
+                                                       response_target.notification_id,
+                                                       response_target.batch_id);
+  InlineKeyboardButton need_help_button;
+  need_help_button.text = "I need help";
+  need_help_button.callback_data = MakeResponseCallbackData(ResponseStatus::NeedHelp,
+                                                            response_target.notification_id,
+                                                            response_target.batch_id);
+  auto keyboard = std::make_unique<InlineKeyboardMarkup>();
+  keyboard->inline_keyboard.emplace_back();
+  keyboard->inline_keyboard.back().push_back(std::move(safe_button));
+  keyboard->inline_keyboard.back().push_back(std::move(need_help_button));
+  return ReplyMarkup{std::move(keyboard)};
 }
 
-void ens::notifications::telegram::TelegramNotificationsBot::HandleHelp(userver::telegram::bot::Update &update) {
-  SendMessage(update.message->chat->id, HELP_MESSAGE);
+void ens::notifications::telegram::TelegramNotificationsBot::AcquireSendSlot(int32_t bot_index, const DispatchTag &tag) {
+  if (not _send_limiters.at(bot_index)->Acquire(tag)) {
+    throw userver::engine::TaskCancelledException{userver::engine::current_task::CancellationReason()};
+  }
 }
 
-void ens::notifications::telegram::TelegramNotificationsBot::HandleSendNotifications(userver::telegram::bot::Update &update,
-                                                                                     const int64_t user_id) {
+// Only the acknowledgement fields are parsed, the sent Message itself is never used
+userver::telegram::bot::AckReply ens::notifications::telegram::TelegramNotificationsBot::SendMessage(int32_t bot_index,
+                                                                                                     const userver::telegram::bot::ChatId &chat_id,
+                                                                                                     const std::string &msg_text,
+                                                                                                     const DispatchTag &tag,
+                                                                                                     const std::optional<ResponseTarget> &response_target) {
+  using namespace userver::telegram::bot;
+  SendMessageMethod::Parameters msg_params{chat_id, msg_text};
+  if (response_target.has_value()) {
+    msg_params.reply_markup = MakeResponseKeyboard(response_target.value());
+  }
+  AcquireSendSlot(bot_index, tag);
+  Request<SendMessageMethod> sent_msg = GetClients().at(bot_index)->SendMessage(msg_params,
+                                                                                userver::telegram::bot::RequestOptions{});
+  return sent_msg.PerformAck();
+}
+
+userver::telegram::bot::RequestFuture<userver::telegram::bot::SendMessageMethod> ens::notifications::telegram::TelegramNotificationsBot::SendMessageAsync(
+    int32_t bot_index,
+    const userver::telegram::bot::ChatId &chat_id,
+    const std::string &msg_text,
+    const DispatchTag &tag,
+    const std::optional<ResponseTarget> &response_target) {
+  using namespace userver::telegram::bot;
+  SendMessageMethod::Parameters msg_params{chat_id, msg_text};
+  if (response_target.has_value()) {
+    msg_params.reply_markup = MakeResponseKeyboard(response_target.value());
+  }
+  AcquireSendSlot(bot_index, tag);
+  Request<SendMessageMethod> sent_msg = GetClients().at(bot_index)->SendMessage(msg_params,
+                                                                                userver::telegram::bot::RequestOptions{});
+  return sent_msg.PerformAsync();
+}
+
+userver::telegram::bot::AckReply ens::notifications::telegram::TelegramNotificationsBot::UploadAttachment(int32_t bot_index,
+                                                                                                          const userver::telegram::bot::ChatId &chat_id,
+                                                                                                          const Attachment &attachment,
+                                                                                                          const std::string &caption,
+                                                                                                          const DispatchTag &tag,
+                                                                                                          const std::optional<ResponseTarget> &response_target) {
+  using namespace userver::telegram::bot;
+  // The shared buffer is passed to the request as is, file contents aren't copied per upload
+  const InputFile input_file{attachment.data, attachment.file_name, GetAttachmentContentType(attachment.file_name)};
+  const RequestOptions upload_options{kAttachmentUploadTimeout, 1};
+  AcquireSendSlot(bot_index, tag);
+  const ClientPtr &client = GetClients().at(bot_index);
+  if (attachment.kind == AttachmentKind::Photo) {
+    SendPhotoMethod::Parameters photo_params{chat_id, input_file};
+    photo_params.caption = caption;
+    if (response_target.has_value()) {
+      photo_params.reply_markup = MakeResponseKeyboard(response_target.value());
+    }
+    return client->SendPhoto(photo_params, upload_options).PerformAck();
+  }
+  SendDocumentMethod::Parameters document_params{chat_id, input_file};
+  document_params.caption = caption;
+  if (response_target.has_value()) {
+    document_params.reply_markup = MakeResponseKeyboard(response_target.value());
+  }
+  return client->SendDocument(document_params, upload_options).PerformAck();
+}
+
+ens::notifications::telegram::SendFuture ens::notifications::telegram::TelegramNotificationsBot::SendAttachmentAsync(int32_t bot_index,
+                                                                                                                     const userver::telegram::bot::ChatId &chat_id,
+                                                                                                                     AttachmentKind kind,
+                                                                                                                     const std::string &file_id,
+                                                                                                                     const std::string &caption,
+                                                                                                                     const DispatchTag &tag,
+                                                                                                                     const std::optional<ResponseTarget> &response_target) {
   using namespace userver::telegram::bot;
-  const userver::storages::postgres::Query contact_exists_query{
-      "SELECT EXISTS ( "
-      "SELECT 1 "
-      "FROM ens_schema.telegram_contact "
-      "WHERE user_id = $1)"
-  };
-  const userver::storages::postgres::Query create_query{
-      "INSERT INTO ens_schema.telegram_contact "
-      "(user_id, active) "
-      "VALUES ($1, true)"
-  };
-  const userver::storages::postgres::Query update_query{
-      "UPDATE ens_schema.telegram_contact "
-      "SET active = true "
-      "WHERE user_id = $1 AND active = false"
-  };
-  userver::storages::postgres::ResultSet
-      contact_exists_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
-                                                contact_exists_query,
-                                                user_id);
-  userver::storages::postgres::Transaction upsert_transaction =
-      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  AcquireSendSlot(bot_index, tag);
+  const ClientPtr &client = GetClients().at(bot_index);
+  if (kind == AttachmentKind::Photo) {
+    SendPhotoMethod::Parameters photo_params{chat_id, file_id};
+    photo_params.caption = caption;
+    if (response_target.has_value()) {
+      photo_params.reply_markup = MakeResponseKeyboard(response_target.value());
+    }
+    return client->SendPhoto(photo_params, RequestOptions{}).PerformAsync();
+  }
+  SendDocumentMethod::Parameters document_params{chat_id, file_id};
+  document_params.caption = caption;
+  if (response_target.has_value()) {
+    document_params.reply_markup = MakeResponseKeyboard(response_target.value());
+  }
+  return client->SendDocument(document_params, RequestOptions{}).PerformAsync();
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::DeactivateContacts(const std::vector<int64_t> &user_ids) {
+  _contacts_writer.Deactivate(user_ids);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::MigrateContacts(const std::vector<int64_t> &old_ids,
+                                                                             const std::vector<int64_t> &new_ids) {
+  _contacts_writer.Migrate(old_ids, new_ids);
+}
+
+ens::notifications::telegram::ResponseTally ens::notifications::telegram::TelegramNotificationsBot::GetPendingResponses(
+    const boost::uuids::uuid &batch_id) {
+  return _responses_writer.GetPendingTally(batch_id);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::HandleHelp(userver::telegram::bot::Update &update,
+                                                                        const int32_t bot_index) {
+  SendMessage(bot_index, update.message->chat->id, HELP_MESSAGE, kCommandReplyTag, std::nullopt);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::HandleSendNotifications(userver::telegram::bot::Update &update,
+                                                                                     const int64_t user_id,
+                                                                                     const int32_t bot_index) {
   std::string msg;
-  if (not contact_exists_res.AsSingleRow<bool>()) {
-    upsert_transaction.Execute(create_query,
-                               user_id);
-    msg = "Success! Now you will receive notifications from other users";
-    upsert_transaction.Commit();
+  // Notifications are delivered by the bot the user has subscribed through
+  if (_contacts_writer.SetActive(user_id, true, bot_index) == ContactChange::None) {
+    msg = "You are already subscribed to notifications receiving";
   } else {
-    const userver::storages::postgres::ResultSet update_res = upsert_transaction.Execute(update_query,
-                                                                                         user_id);
-    if (not update_res.RowsAffected()) {
-      msg = "You are already subscribed to notifications receiving";
-      upsert_transaction.Rollback();
-    } else {
-      msg = "Success! Now you will receive notifications from other users";
-      upsert_transaction.Commit();
-    }
+    msg = "Success! Now you will receive notifications from other users";
   }
-  SendMessage(update.message->chat->id, msg);
+  SendMessage(bot_index, update.message->chat->id, msg, kCommandReplyTag, std::nullopt);
 }
 
 void ens::notifications::telegram::TelegramNotificationsBot::HandleStopNotifications(userver::telegram::bot::Update &update,
-                                                                                     const int64_t user_id) {
-  using namespace userver::telegram::bot;
-  const userver::storages::postgres::Query update_query{
-      "UPDATE ens_schema.telegram_contact "
-      "SET active = false "
-      "WHERE user_id = $1 AND active = true"
-  };
-  userver::storages::postgres::Transaction update_transaction =
-      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
-  userver::storages::postgres::ResultSet update_res = update_transaction.Execute(update_query,
-                                                                                 user_id);
+                                                                                     const int64_t user_id,
+                                                                                     const int32_t bot_index) {
+  std::string msg;
+  // A created contact means the user has never been subscribed
+  if (_contacts_writer.SetActive(user_id, false, bot_index) == ContactChange::Updated) {
+    msg = "Stopped notifications receiving";
+  } else {
+    msg = "You aren't subscribed to notifications receiving";
+  }
+  SendMessage(bot_index, update.message->chat->id, msg, kCommandReplyTag, std::nullopt);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::HandleChannelOptOut(userver::telegram::bot::Update &update,
+                                                                                 const int64_t user_id,
+                                                                                 const int32_t bot_index,
+                                                                                 const bool opt_out) {
   std::string msg;
-  if (not update_res.RowsAffected()) {
-    update_transaction.Rollback();
+  if (not _contacts_writer.SetChannelOptOut(user_id, opt_out)) {
     msg = "You aren't subscribed to notifications receiving";
+  } else if (opt_out) {
+    msg = "Notifications posted to telegram channels will be sent to you as direct messages";
   } else {
-    update_transaction.Commit();
-    msg = "Stopped notifications receiving";
+    msg = "Notifications posted to telegram channels won't be sent to you as direct messages";
+  }
+  SendMessage(bot_index, update.message->chat->id, msg, kCommandReplyTag, std::nullopt);
+}
+
+void ens::notifications::telegram::TelegramNotificationsBot::HandleCallbackQuery(const userver::telegram::bot::CallbackQuery &callback_query,
+                                                                                 const int32_t bot_index) {
+  using namespace userver::telegram::bot;
+  std::optional<RecipientResponse> response = ParseResponseCallbackData(callback_query.data.value_or(""));
+  AnswerCallbackQueryMethod::Parameters answer_params{callback_query.id};
+  if (not response.has_value() or not callback_query.from) {
+    answer_params.text = "This button is no longer supported";
+  } else {
+    response->telegram_id = callback_query.from->id;
+    response->response_timestamp = userver::utils::datetime::Timestamp();
+    // The response is written later together with the others, the recipient is answered right away
+    _responses_writer.Record(response.value());
+    answer_params.text = response->status == ResponseStatus::Safe ? "Marked you as safe"
+                                                                   : "Your request for help has been passed on";
+  }
+  // Answers aren't messages, they don't take the send rate of the bot
+  try {
+    GetClients().at(bot_index)->AnswerCallbackQuery(answer_params, RequestOptions{}).Perform();
+  }
+  catch (const std::exception &e) {
+    LOG_WARNING() << "Error answering telegram callback query, bot_index=" << bot_index << ": " << e.what();
   }
-  SendMessage(update.message->chat->id, msg);
 }
 
 void ens::notifications::telegram::TelegramNotificationsBot::HandleUpdate(userver::telegram::bot::Update update,
-                                                                          userver::telegram::bot::ClientPtr) {
+                                                                          userver::telegram::bot::ClientPtr client) {
   using namespace userver::telegram::bot;
-  if (not update.message->text.has_value()) {
+  if (update.callback_query) {
+    HandleCallbackQuery(*update.callback_query, GetBotIndex(client));
+    return;
+  }
+  if (not update.message or not update.message->text.has_value()) {
     return;
   }
+  const int32_t bot_index = GetBotIndex(client);
   const std::string message_text = update.message->text.value();
   if (BOT_COMMANDS_STRING.find(message_text) == BOT_COMMANDS_STRING.cend()) {
-    HandleHelp(update);
+    HandleHelp(update, bot_index);
     return;
   }
   const BotCommands command = BOT_COMMANDS_STRING.find(message_text)->second;
@@ -109,15 +336,23 @@ void ens::notifications::telegram::TelegramNotificationsBot::HandleUpdate(userve
   switch (command) {
     case BotCommands::Start:
     case BotCommands::Help: {
-      HandleHelp(update);
+      HandleHelp(update, bot_index);
       break;
     }
     case BotCommands::SendNotifications: {
-      HandleSendNotifications(update, user_id);
+      HandleSendNotifications(update, user_id, bot_index);
       break;
     }
     case BotCommands::StopNotifications: {
-      HandleStopNotifications(update, user_id);
+      HandleStopNotifications(update, user_id, bot_index);
+      break;
+    }
+    case BotCommands::DirectNotifications: {
+      HandleChannelOptOut(update, user_id, bot_index, true);
+      break;
+    }
+    case BotCommands::ChannelNotifications: {
+      HandleChannelOptOut(update, user_id, bot_index, false);
       break;
     }
   }
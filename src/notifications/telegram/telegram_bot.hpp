@@ -1,5 +1,10 @@
 #pragma once
 
+#include <variant>
+
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <fmt/format.h>
 #include <userver/components/component.hpp>
 #include <userver/components/component_list.hpp>
 #include <userver/storages/postgres/cluster.hpp>
@@ -7,8 +12,21 @@
 #include <userver/telegram/bot/components/long_poller.hpp>
 #include <userver/telegram/bot/types/update.hpp>
 #include <userver/telegram/bot/client/client.hpp>
+#include <userver/telegram/bot/requests/ack_reply.hpp>
+#include <userver/telegram/bot/requests/answer_callback_query.hpp>
+#include <userver/telegram/bot/requests/send_document.hpp>
+#include <userver/telegram/bot/requests/send_message.hpp>
+#include <userver/telegram/bot/requests/send_photo.hpp>
+#include <userver/telegram/bot/types/reply_markup.hpp>
 #include <utils/utils.hpp>
 
+#include "notifications/telegram/attachments.hpp"
+#include "notifications/telegram/contacts_writer.hpp"
+#include "notifications/telegram/poller_lease.hpp"
+#include "notifications/telegram/responses_writer.hpp"
+#include "notifications/dispatch_scheduler.hpp"
+#include "notifications/rate_limiter.hpp"
+
 // TODO: Add setCommands method
 
 namespace ens::notifications::telegram {
@@ -16,43 +34,166 @@ enum class BotCommands {
   Start,
   Help,
   SendNotifications,
-  StopNotifications
+  StopNotifications,
+  DirectNotifications,
+  ChannelNotifications
 };
 
 const std::unordered_map<std::string, BotCommands> BOT_COMMANDS_STRING{
     {"/start", BotCommands::Start},
     {"/help", BotCommands::Help},
     {"/send_notifications", BotCommands::SendNotifications},
-    {"/stop_notifications", BotCommands::StopNotifications}
+    {"/stop_notifications", BotCommands::StopNotifications},
+    {"/direct_notifications", BotCommands::DirectNotifications},
+    {"/channel_notifications", BotCommands::ChannelNotifications}
+};
+
+enum class DeliveryStatus {
+  Delivered,
+  Blocked,  // the user blocked the bot, deleted the account or kicked the bot from the chat
+  ChatNotFound,
+  Migrated,  // the group chat was migrated to a supergroup
+  Transient  // rate limits, server errors and other failures worth retrying later
+};
+
+DeliveryStatus ClassifyDelivery(const userver::telegram::bot::AckReply &ack);
+
+using SendFuture = std::variant<userver::telegram::bot::RequestFuture<userver::telegram::bot::SendMessageMethod>,
+                                userver::telegram::bot::RequestFuture<userver::telegram::bot::SendPhotoMethod>,
+                                userver::telegram::bot::RequestFuture<userver::telegram::bot::SendDocumentMethod>>;
+
+userver::telegram::bot::AckReply GetSendAck(SendFuture &future);
+
+// Notification the status buttons of a message report to
+struct ResponseTarget {
+  boost::uuids::uuid notification_id;
+  boost::uuids::uuid batch_id;
 };
 
 const std::string HELP_MESSAGE{"This is a notifier bot for emergency_notification_system "
                                "(https://github.com/Lookingforcommit/emergency_notification_system) "
                                "use commands /send_notifications or /stop_notifications to accept/reject notifications "
-                               "from other users"};
+                               "from other users. Notifications of some groups are posted to telegram channels, "
+                               "use commands /direct_notifications or /channel_notifications to receive them "
+                               "as direct messages/from the channels"};
 
 class TelegramNotificationsBot : public userver::telegram::bot::TelegramBotLongPoller {
  public:
   static constexpr std::string_view kName = "telegram-notifications-bot";
+  static constexpr std::chrono::milliseconds kDefaultContactsFlushInterval{20};
+  static constexpr size_t kDefaultContactsMaxBatchSize = 1000;
+  static constexpr size_t kDefaultMessagesPerSecond = 30;
+  static constexpr std::chrono::milliseconds kDefaultResponsesFlushInterval{100};
+  static constexpr std::chrono::milliseconds kDefaultResponseTalliesFlushInterval{1000};
+  static constexpr size_t kDefaultResponsesShards = 16;
+  static constexpr std::chrono::milliseconds kDefaultPollerLeaseDuration{15000};
+  static constexpr size_t kDefaultRateBudgetMaxSlice = 10;
+  // Group channels are posted to by the first bot of the pool, it has to be an administrator of the channels
+  static constexpr int32_t kChannelBotIndex = 0;
+  static constexpr std::chrono::seconds kAttachmentUploadTimeout{60};
+  // Replies to the commands aren't held back by routine batches, they share a queue of their own
+  inline static const DispatchTag kCommandReplyTag{BatchPriority::kHigh, boost::uuids::nil_uuid(), TenantTier::kStandard};
   TelegramNotificationsBot(const userver::components::ComponentConfig &config,
                            const userver::components::ComponentContext &component_context) :
       userver::telegram::bot::TelegramBotLongPoller(config, component_context),
       _pg_cluster(
           component_context
               .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
-              .GetCluster()) {}
+              .GetCluster()),
+      _contacts_writer(_pg_cluster,
+                       config["contacts-flush-interval"].As<std::chrono::milliseconds>(kDefaultContactsFlushInterval),
+                       config["contacts-max-batch-size"].As<size_t>(kDefaultContactsMaxBatchSize)),
+      _responses_writer(_pg_cluster,
+                        component_context.FindComponent<BatchProgressTracker>(),
+                        config["responses-flush-interval"].As<std::chrono::milliseconds>(kDefaultResponsesFlushInterval),
+                        config["response-tallies-flush-interval"].As<std::chrono::milliseconds>(
+                            kDefaultResponseTalliesFlushInterval),
+                        config["responses-shards"].As<size_t>(kDefaultResponsesShards)),
+      _poller_lease(_pg_cluster,
+                    GetClients().size(),
+                    config["poller-lease-duration"].As<std::chrono::milliseconds>(kDefaultPollerLeaseDuration)) {
+    const auto messages_per_second = config["messages-per-second"].As<size_t>(kDefaultMessagesPerSecond);
+    const auto cluster_rate_budget = config["cluster-rate-budget"].As<bool>(false);
+    const auto rate_budget_max_slice = config["rate-budget-max-slice"].As<size_t>(kDefaultRateBudgetMaxSlice);
+    for (size_t i = 0; i < GetClients().size(); ++i) {
+      std::unique_ptr<ClusterRateBudget> budget;
+      if (cluster_rate_budget) {
+        budget = std::make_unique<ClusterRateBudget>(_pg_cluster,
+                                                     fmt::format("telegram/{}", i),
+                                                     messages_per_second,
+                                                     rate_budget_max_slice);
+      }
+      _send_limiters.push_back(std::make_unique<SendRateLimiter>(messages_per_second,
+                                                                 component_context.FindComponent<DispatchScheduler>(),
+                                                                 std::move(budget)));
+    }
+  }
   static userver::yaml_config::Schema GetStaticConfigSchema();
-  void SendMessage(const userver::telegram::bot::ChatId &chat_id,
-                   const std::string &msg_text);
-  void HandleHelp(userver::telegram::bot::Update &update);
+  size_t GetBotsCount() const;
+  // Messages of every bot are paced according to its own rate limit, the tag decides the order of the waiting messages.
+  // Messages with a response target get the status buttons
+  userver::telegram::bot::AckReply SendMessage(int32_t bot_index,
+                                               const userver::telegram::bot::ChatId &chat_id,
+                                               const std::string &msg_text,
+                                               const DispatchTag &tag,
+                                               const std::optional<ResponseTarget> &response_target);
+  userver::telegram::bot::RequestFuture<userver::telegram::bot::SendMessageMethod> SendMessageAsync(int32_t bot_index,
+                                                                                                    const userver::telegram::bot::ChatId &chat_id,
+                                                                                                    const std::string &msg_text,
+                                                                                                    const DispatchTag &tag,
+                                                                                                    const std::optional<ResponseTarget> &response_target);
+  // Uploads the attachment, the file_id of the reply can be used to send it again without uploading
+  userver::telegram::bot::AckReply UploadAttachment(int32_t bot_index,
+                                                    const userver::telegram::bot::ChatId &chat_id,
+                                                    const Attachment &attachment,
+                                                    const std::string &caption,
+                                                    const DispatchTag &tag,
+                                                    const std::optional<ResponseTarget> &response_target);
+  // Sends an attachment previously uploaded by the same bot
+  SendFuture SendAttachmentAsync(int32_t bot_index,
+                                 const userver::telegram::bot::ChatId &chat_id,
+                                 AttachmentKind kind,
+                                 const std::string &file_id,
+                                 const std::string &caption,
+                                 const DispatchTag &tag,
+                                 const std::optional<ResponseTarget> &response_target);
+  // Responses of the batch received by this instance and not yet added to the stored tallies
+  ResponseTally GetPendingResponses(const boost::uuids::uuid &batch_id);
+  void DeactivateContacts(const std::vector<int64_t> &user_ids);
+  void MigrateContacts(const std::vector<int64_t> &old_ids, const std::vector<int64_t> &new_ids);
+  void HandleHelp(userver::telegram::bot::Update &update,
+                  const int32_t bot_index);
   void HandleSendNotifications(userver::telegram::bot::Update &update,
-                               const int64_t user_id);
+                               const int64_t user_id,
+                               const int32_t bot_index);
   void HandleStopNotifications(userver::telegram::bot::Update &update,
-                               const int64_t user_id);
+                               const int64_t user_id,
+                               const int32_t bot_index);
+  void HandleChannelOptOut(userver::telegram::bot::Update &update,
+                           const int64_t user_id,
+                           const int32_t bot_index,
+                           const bool opt_out);
+  // Records the status reported with the buttons of a notification
+  void HandleCallbackQuery(const userver::telegram::bot::CallbackQuery &callback_query,
+                           const int32_t bot_index);
   void HandleUpdate(userver::telegram::bot::Update update,
-                    userver::telegram::bot::ClientPtr);
+                    userver::telegram::bot::ClientPtr client);
+  void OnAllComponentsLoaded() override;
+  void OnAllComponentsAreStopping() override;
+ protected:
+  bool IsPollingAllowed(size_t bot_index) override;
+  int64_t LoadOffset(size_t bot_index) override;
+  void CommitOffset(size_t bot_index, int64_t offset) override;
  private:
+  int32_t GetBotIndex(const userver::telegram::bot::ClientPtr &client) const;
+  static userver::telegram::bot::ReplyMarkup MakeResponseKeyboard(const ResponseTarget &response_target);
+  // Waits for the rate limit of the bot, a cancelled wait throws instead of letting the message through
+  void AcquireSendSlot(int32_t bot_index, const DispatchTag &tag);
   userver::storages::postgres::ClusterPtr _pg_cluster;
+  TelegramContactsWriter _contacts_writer;
+  RecipientResponsesWriter _responses_writer;
+  TelegramPollerLease _poller_lease;
+  std::vector<std::unique_ptr<SendRateLimiter>> _send_limiters;
 };
 
 void AppendTelegramNotificationsBot(userver::components::ComponentList &component_list);
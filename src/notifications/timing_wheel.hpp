@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ens::notifications {
+// Hierarchical timing wheel: every level has 256 slots, each slot of a level spans a whole turn of the level below.
+// Insertion is O(1), every tick expires its slot of the lowest level and, once a turn of a level ends,
+// spreads the next slot of the level above into the levels below. Not synchronized
+template<typename T>
+class TimingWheel {
+ public:
+  // Time is measured in ticks of tick_ms milliseconds since the Unix epoch
+  TimingWheel(int64_t tick_ms, int64_t now_ms) : _tick_ms(tick_ms), _current_tick(now_ms / tick_ms) {}
+
+  // Values whose time has already come expire on the next Advance
+  void Insert(int64_t expires_at_ms, T value) {
+    ++_size;
+    // Values are expired by the first tick starting at or after their time, so they never fire early
+    Place({(expires_at_ms + _tick_ms - 1) / _tick_ms, std::move(value)});
+  }
+
+  // Expires all the values due by now_ms in the order of their ticks
+  template<typename OnExpired>
+  void Advance(int64_t now_ms, OnExpired &&on_expired) {
+    Expire(_due, on_expired);
+    const int64_t target_tick = now_ms / _tick_ms;
+    while (_current_tick < target_tick) {
+      ++_current_tick;
+      // Higher levels are spread first, so that their values get into the slots of the lower ones
+      for (size_t level = kLevels; level-- > 1;) {
+        if ((_current_tick & ((int64_t{1} << (kSlotBits * level)) - 1)) == 0) {
+          Cascade(_levels[level][SlotIndex(_current_tick, level)]);
+        }
+      }
+      if ((_current_tick & ((int64_t{1} << (kSlotBits * kLevels)) - 1)) == 0) {
+        Cascade(_overflow);
+      }
+      Expire(_levels[0][SlotIndex(_current_tick, 0)], on_expired);
+      Expire(_due, on_expired);
+    }
+  }
+
+  size_t Size() const { return _size; }
+
+ private:
+  static constexpr size_t kSlotBits = 8;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+  static constexpr size_t kLevels = 4;
+  struct Entry {
+    int64_t expires_tick;
+    T value;
+  };
+  using Slot = std::vector<Entry>;
+
+  static size_t SlotIndex(int64_t tick, size_t level) {
+    return static_cast<size_t>(tick >> (kSlotBits * level)) & (kSlots - 1);
+  }
+
+  void Place(Entry entry) {
+    const int64_t delta = entry.expires_tick - _current_tick;
+    if (delta <= 0) {
+      _due.push_back(std::move(entry));
+      return;
+    }
+    for (size_t level = 0; level < kLevels; ++level) {
+      if (delta < (int64_t{1} << (kSlotBits * (level + 1)))) {
+        _levels[level][SlotIndex(entry.expires_tick, level)].push_back(std::move(entry));
+        return;
+      }
+    }
+    // Beyond the last level, with 10ms ticks that is more than 497 days ahead
+    _overflow.push_back(std::move(entry));
+  }
+
+  void Cascade(Slot &slot) {
+    Slot entries = std::move(slot);
+    slot.clear();
+    for (Entry &entry : entries) {
+      Place(std::move(entry));
+    }
+  }
+
+  template<typename OnExpired>
+  void Expire(Slot &slot, OnExpired &on_expired) {
+    Slot entries = std::move(slot);
+    slot.clear();
+    _size -= entries.size();
+    for (Entry &entry : entries) {
+      on_expired(std::move(entry.value));
+    }
+  }
+
+  const int64_t _tick_ms;
+  int64_t _current_tick;
+  size_t _size = 0;
+  std::array<std::array<Slot, kSlots>, kLevels> _levels;
+  Slot _overflow;
+  // Values whose tick has come while they were being inserted or spread
+  Slot _due;
+};
+}
@@ -226,3 +226,53 @@ userver::formats::json::Value ens::recipients::RecipientDeleteHandler::HandleReq
 void ens::recipients::AppendRecipientDeleteHandler(userver::components::ComponentList &component_list) {
   component_list.Append<RecipientDeleteHandler>();
 }
+
+userver::formats::json::Value ens::recipients::RecipientSetPreferredChannelHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                           const userver::formats::json::Value &,
+                                                                                                           userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid recipient_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("recipient_id"));
+    // Missing channel restores the configured channel priority
+    std::optional<std::string> channel;
+    if (request.HasArg("channel")) {
+      channel = request.GetArg("channel");
+    }
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    this->_recipient_manager.SetPreferredChannel(user_id, recipient_id, channel);
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const RecipientNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const IncorrectChannelException &e) {
+    throw userver::server::http::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::http::HttpStatus::kUnprocessableEntity,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  return userver::formats::json::Value{};
+}
+
+void ens::recipients::AppendRecipientSetPreferredChannelHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<RecipientSetPreferredChannelHandler>();
+}
@@ -88,4 +88,15 @@ class RecipientDeleteHandler : public RecipientJsonHandlerBase {
 
 void AppendRecipientDeleteHandler(userver::components::ComponentList &component_list);
 
+class RecipientSetPreferredChannelHandler : public RecipientJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-recipients-setPreferredChannel";
+  using RecipientJsonHandlerBase::RecipientJsonHandlerBase;
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+};
+
+void AppendRecipientSetPreferredChannelHandler(userver::components::ComponentList &component_list);
+
 }
@@ -170,6 +170,36 @@ std::unique_ptr<schemas::RecipientWithId> ens::recipients::RecipientManager::Mod
   return std::make_unique<schemas::RecipientWithId>(recipient_data);
 }
 
+void ens::recipients::RecipientManager::SetPreferredChannel(const boost::uuids::uuid &user_id,
+                                                            const boost::uuids::uuid &recipient_id,
+                                                            const std::optional<std::string> &channel) {
+  const userver::storages::postgres::Query update_query{
+      "UPDATE ens_schema.recipient "
+      "SET preferred_channel = $3 "
+      "WHERE master_id = $1 AND recipient_id = $2"
+  };
+  std::optional<schemas::Notification::Type> preferred_channel;
+  if (channel.has_value()) {
+    preferred_channel = schemas::kschemas_Notification_Type_Mapping.TryFindBySecond(channel.value());
+    // Channel posts are addressed to groups, not to recipients
+    if (not preferred_channel.has_value() or preferred_channel == schemas::Notification::Type::kTelegramChannel) {
+      throw IncorrectChannelException{channel.value()};
+    }
+  }
+  userver::storages::postgres::Transaction update_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet
+      update_res = update_transaction.Execute(update_query,
+                                              user_id,
+                                              recipient_id,
+                                              preferred_channel);
+  if (not update_res.RowsAffected()) {
+    update_transaction.Rollback();
+    throw RecipientNotFoundException{boost::uuids::to_string(recipient_id)};
+  }
+  update_transaction.Commit();
+}
+
 void ens::recipients::RecipientManager::DeleteRecipient(const boost::uuids::uuid &user_id,
                                                         const boost::uuids::uuid &recipient_id) {
   const userver::storages::postgres::Query delete_query{
@@ -36,6 +36,10 @@ class RecipientManager : public userver::components::ComponentBase {
   std::unique_ptr<schemas::RecipientWithId> ModifyRecipient(const boost::uuids::uuid &user_id,
                                                             const boost::uuids::uuid &recipient_id,
                                                             const schemas::RecipientWithoutId &data);
+  // Channel tried first when the recipient is notified, nullopt restores the configured priority
+  void SetPreferredChannel(const boost::uuids::uuid &user_id,
+                           const boost::uuids::uuid &recipient_id,
+                           const std::optional<std::string> &channel);
   void DeleteRecipient(const boost::uuids::uuid &user_id, const boost::uuids::uuid &recipient_id);
  private:
   userver::storages::postgres::ClusterPtr _pg_cluster;
@@ -63,5 +67,15 @@ class DraftNotFoundException : public std::exception {
   noexcept override { return this->_msg.c_str(); };
 };
 
+class IncorrectChannelException : public std::exception {
+ private:
+  static constexpr std::string_view FORMAT{"Channel can't be preferred by a recipient channel={}"};
+  const std::string _msg;
+ public:
+  IncorrectChannelException(const std::string &channel) : _msg(fmt::format(this->FORMAT, channel)) {};
+  [[nodiscard]] const char *what() const
+  noexcept override { return this->_msg.c_str(); };
+};
+
 }  // namespace ens::recipients
 
@@ -202,8 +202,10 @@ USERVER_NAMESPACE::formats::json::Value Serialize(
   vb["batch_id"] =
       USERVER_NAMESPACE::chaotic::Primitive<std::string>{value.batch_id};
 
-  vb["recipient_id"] =
-      USERVER_NAMESPACE::chaotic::Primitive<std::string>{value.recipient_id};
+  if (value.recipient_id) {
+    vb["recipient_id"] =
+        USERVER_NAMESPACE::chaotic::Primitive<std::string>{*value.recipient_id};
+  }
 
   vb["group_id"] =
       USERVER_NAMESPACE::chaotic::Primitive<std::string>{value.group_id};
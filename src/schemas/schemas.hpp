@@ -110,17 +110,19 @@ struct Notification {
     kTelegram,
     kSms,
     kMail,
+    kTelegramChannel,
   };
 
   static constexpr Type kTypeValues[] = {
       Type::kTelegram,
       Type::kSms,
       Type::kMail,
+      Type::kTelegramChannel,
   };
 
   std::string notification_id{};
   std::string batch_id{};
-  std::string recipient_id{};
+  std::optional<std::string> recipient_id{};
   std::string group_id{};
   schemas::Notification::Type type{};
   std::string creation_timestamp{};
@@ -133,7 +135,8 @@ static constexpr USERVER_NAMESPACE::utils::TrivialBiMap
       .template Type<schemas::Notification::Type, std::string_view>()
       .Case(schemas::Notification::Type::kTelegram, "Telegram")
       .Case(schemas::Notification::Type::kSms, "SMS")
-      .Case(schemas::Notification::Type::kMail, "Mail");
+      .Case(schemas::Notification::Type::kMail, "Mail")
+      .Case(schemas::Notification::Type::kTelegramChannel, "TelegramChannel");
 };
 
 bool operator==(const schemas::Notification &lhs,
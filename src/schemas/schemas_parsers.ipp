@@ -159,7 +159,7 @@ schemas::Notification Parse(
           .template As<USERVER_NAMESPACE::chaotic::Primitive<std::string>>();
   res.recipient_id =
       value["recipient_id"]
-          .template As<USERVER_NAMESPACE::chaotic::Primitive<std::string>>();
+          .template As<std::optional<USERVER_NAMESPACE::chaotic::Primitive<std::string>>>();
   res.group_id =
       value["group_id"]
           .template As<USERVER_NAMESPACE::chaotic::Primitive<std::string>>();
@@ -227,3 +227,53 @@ userver::formats::json::Value ens::templates::TemplateDeleteHandler::HandleReque
 void ens::templates::AppendTemplateDeleteHandler(userver::components::ComponentList &component_list) {
   component_list.Append<TemplateDeleteHandler>();
 }
+
+userver::formats::json::Value ens::templates::TemplateSetAttachmentHandler::HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                                                                   const userver::formats::json::Value &,
+                                                                                                   userver::server::request::RequestContext &) const {
+  const std::string &access_token = request.GetHeader("Authorization");
+  try {
+    const boost::uuids::uuid template_id = boost::lexical_cast<boost::uuids::uuid>(request.GetArg("template_id"));
+    // Missing file_name removes the attachment
+    std::optional<std::string> file_name;
+    if (request.HasArg("file_name")) {
+      file_name = request.GetArg("file_name");
+    }
+    const boost::uuids::uuid user_id = _jwt_verif_manager.VerifyJWT(access_token);
+    this->_template_manager.SetAttachment(user_id, template_id, file_name);
+    return userver::formats::json::Value{};
+  }
+  catch (const ens::auth::GenericJWTException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kUnauthorized,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const boost::bad_lexical_cast &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const NotificationTemplateNotFoundException &e) {
+    throw userver::server::handlers::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kResourceNotFound,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+  catch (const IncorrectAttachmentException &e) {
+    throw userver::server::http::CustomHandlerException{
+        userver::server::handlers::HandlerErrorCode::kClientError,
+        userver::server::http::HttpStatus::kUnprocessableEntity,
+        userver::server::handlers::InternalMessage{e.what()},
+        userver::server::handlers::ExternalBody{e.what()}
+    };
+  }
+}
+
+void ens::templates::AppendTemplateSetAttachmentHandler(userver::components::ComponentList &component_list) {
+  component_list.Append<TemplateSetAttachmentHandler>();
+}
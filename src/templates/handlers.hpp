@@ -88,4 +88,15 @@ class TemplateDeleteHandler : public TemplateJsonHandlerBase {
 
 void AppendTemplateDeleteHandler(userver::components::ComponentList &component_list);
 
+class TemplateSetAttachmentHandler : public TemplateJsonHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-templates-setAttachment";
+  using TemplateJsonHandlerBase::TemplateJsonHandlerBase;
+  userver::formats::json::Value HandleRequestJsonThrow(const userver::server::http::HttpRequest &request,
+                                                       const userver::formats::json::Value &,
+                                                       userver::server::request::RequestContext &) const override;
+};
+
+void AppendTemplateSetAttachmentHandler(userver::components::ComponentList &component_list);
+
 }
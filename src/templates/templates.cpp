@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include <userver/fs/read.hpp>
 #include <userver/yaml_config/merge_schemas.hpp>
 #include <userver/utils/boost_uuid7.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -13,7 +14,15 @@ userver::yaml_config::Schema ens::templates::TemplateManager::GetStaticConfigSch
     type: object
     description: Component for templates management logic
     additionalProperties: false
-    properties: {}
+    properties:
+        attachments-dir:
+            type: string
+            description: Directory with the files which can be attached to the templates
+            defaultDescription: attachments are disabled
+        fs-task-processor:
+            type: string
+            description: Task processor for the attachments directory access
+            defaultDescription: fs-task-processor
   )");
 }
 
@@ -156,6 +165,34 @@ std::unique_ptr<schemas::NotificationTemplateWithId> ens::templates::TemplateMan
   return std::make_unique<schemas::NotificationTemplateWithId>(template_data);
 }
 
+void ens::templates::TemplateManager::SetAttachment(const boost::uuids::uuid &user_id,
+                                                    const boost::uuids::uuid &template_id,
+                                                    const std::optional<std::string> &file_name) {
+  const userver::storages::postgres::Query update_query{
+      "UPDATE ens_schema.notification_template "
+      "SET attachment_file = $3 "
+      "WHERE master_id = $1 AND notification_template_id = $2"
+  };
+  if (file_name.has_value()) {
+    const std::optional<std::string> path = ens::utils::resolve_attachment_path(_attachments_dir, file_name.value());
+    if (not path.has_value() or not userver::fs::FileExists(_fs_task_processor, path.value())) {
+      throw IncorrectAttachmentException{file_name.value()};
+    }
+  }
+  userver::storages::postgres::Transaction update_transaction =
+      _pg_cluster->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
+  userver::storages::postgres::ResultSet
+      update_res = update_transaction.Execute(update_query,
+                                              user_id,
+                                              template_id,
+                                              file_name);
+  if (not update_res.RowsAffected()) {
+    update_transaction.Rollback();
+    throw NotificationTemplateNotFoundException{boost::uuids::to_string(template_id)};
+  }
+  update_transaction.Commit();
+}
+
 void ens::templates::TemplateManager::DeleteTemplate(const boost::uuids::uuid &user_id,
                                                      const boost::uuids::uuid &template_id) {
   const userver::storages::postgres::Query delete_query{
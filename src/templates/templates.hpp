@@ -2,6 +2,7 @@
 
 #include <userver/components/component.hpp>
 #include <userver/components/component_list.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
 #include <userver/storages/postgres/cluster.hpp>
 #include <userver/storages/postgres/component.hpp>
 
@@ -13,13 +14,16 @@ namespace ens::templates {
 class TemplateManager : public userver::components::ComponentBase {
  public:
   static constexpr std::string_view kName = "template-manager";
+  static constexpr std::string_view kDefaultFsTaskProcessor = "fs-task-processor";
   TemplateManager(const userver::components::ComponentConfig &config,
                   const userver::components::ComponentContext &component_context) :
       ComponentBase(config, component_context),
       _pg_cluster(
           component_context
               .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
-              .GetCluster()) {}
+              .GetCluster()),
+      _fs_task_processor(component_context.GetTaskProcessor(config["fs-task-processor"].As<std::string>(kDefaultFsTaskProcessor))),
+      _attachments_dir(config["attachments-dir"].As<std::string>("")) {}
   static userver::yaml_config::Schema GetStaticConfigSchema();
   std::unique_ptr<schemas::NotificationTemplateDraft> Create(const boost::uuids::uuid &user_id,
                                                              const schemas::NotificationTemplateWithoutId &data);
@@ -31,9 +35,15 @@ class TemplateManager : public userver::components::ComponentBase {
   std::unique_ptr<schemas::NotificationTemplateWithId> ModifyTemplate(const boost::uuids::uuid &user_id,
                                                                       const boost::uuids::uuid &template_id,
                                                                       const schemas::NotificationTemplateWithoutId &data);
+  // Attaches a file of the attachments directory to the template messages, nullopt removes the attachment
+  void SetAttachment(const boost::uuids::uuid &user_id,
+                     const boost::uuids::uuid &template_id,
+                     const std::optional<std::string> &file_name);
   void DeleteTemplate(const boost::uuids::uuid &user_id, const boost::uuids::uuid &template_id);
  private:
   userver::storages::postgres::ClusterPtr _pg_cluster;
+  userver::engine::TaskProcessor &_fs_task_processor;
+  const std::string _attachments_dir;
 };
 
 void AppendTemplateManager(userver::components::ComponentList &component_list);
@@ -49,6 +59,16 @@ class NotificationTemplateNotFoundException : public std::exception {
   noexcept override { return this->_msg.c_str(); };
 };
 
+class IncorrectAttachmentException : public std::exception {
+ private:
+  static constexpr std::string_view FORMAT{"Attachment does not exist file_name={}"};
+  const std::string _msg;
+ public:
+  IncorrectAttachmentException(const std::string &file_name) : _msg(fmt::format(this->FORMAT, file_name)) {};
+  [[nodiscard]] const char *what() const
+  noexcept override { return this->_msg.c_str(); };
+};
+
 class DraftNotFoundException : public std::exception {
  private:
   static constexpr std::string_view FORMAT{"Draft does not exist draft_id={}"};
@@ -88,9 +88,9 @@ boost::uuids::uuid ens::auth::JWTManager::VerifyJWT(const std::string &token) {
         "WHERE user_id = $1)",
     };
     userver::storages::postgres::ResultSet
-        select_res = _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave,
-                                          stored_user_exists_query,
-                                          user_id);
+        select_res = _hedged_reads.Execute(ens::utils::ReadClass::kAuth,
+                                           stored_user_exists_query,
+                                           user_id);
     if (not select_res.AsSingleRow<bool>()) {
       throw UserNotFoundException{boost::uuids::to_string(user_id)};
     }
@@ -11,6 +11,7 @@
 #include <userver/logging/log.hpp>
 
 #include "utils/utils.hpp"
+#include "utils/hedged_reads.hpp"
 #include "schemas/schemas.hpp"
 
 namespace ens::auth {
@@ -43,13 +44,15 @@ class JWTManager : public userver::components::ComponentBase {
       _pg_cluster(
           component_context
       .FindComponent<userver::components::Postgres>(ens::utils::DB_COMPONENT_NAME)
-      .GetCluster()) {}
+      .GetCluster()),
+      _hedged_reads(component_context.FindComponent<ens::utils::HedgedReads>()) {}
   boost::uuids::uuid VerifyJWT(const std::string &token);
   std::unique_ptr<schemas::JWTPair> GenerateJWTPair(const std::string &user_id);
   static userver::yaml_config::Schema GetStaticConfigSchema();
  private:
   ens::utils::JWTSecdistConfig _secdist_config;
   userver::storages::postgres::ClusterPtr _pg_cluster;
+  ens::utils::HedgedReads &_hedged_reads;
 };
 
 void AppendJWTManager(userver::components::ComponentList &component_list);
@@ -0,0 +1,116 @@
+#include "hedged_reads.hpp"
+
+#include <algorithm>
+
+#include <userver/storages/postgres/statistics.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+userver::yaml_config::Schema ens::utils::HedgedReads::GetStaticConfigSchema() {
+  return userver::yaml_config::MergeSchemas<userver::components::ComponentBase>(R"(
+    type: object
+    description: Component hedging the tail latency sensitive replica reads
+    additionalProperties: false
+    properties:
+        auth:
+            type: object
+            description: Hedging policy of the token verification reads
+            additionalProperties: false
+            properties:
+                enabled:
+                    type: boolean
+                    description: Send a second copy of the slow reads
+                    defaultDescription: false
+                percentile:
+                    type: number
+                    description: Percentile of the recent latencies the first request runs alone for
+                    defaultDescription: 95
+                min-delay:
+                    type: string
+                    description: Lower bound of the time the first request runs alone
+                    defaultDescription: 2ms
+                max-delay:
+                    type: string
+                    description: Upper bound of the time the first request runs alone
+                    defaultDescription: 100ms
+        get-by-id:
+            type: object
+            description: Hedging policy of the reads of a single entity
+            additionalProperties: false
+            properties:
+                enabled:
+                    type: boolean
+                    description: Send a second copy of the slow reads
+                    defaultDescription: false
+                percentile:
+                    type: number
+                    description: Percentile of the recent latencies the first request runs alone for
+                    defaultDescription: 95
+                min-delay:
+                    type: string
+                    description: Lower bound of the time the first request runs alone
+                    defaultDescription: 2ms
+                max-delay:
+                    type: string
+                    description: Upper bound of the time the first request runs alone
+                    defaultDescription: 100ms
+        fan-out:
+            type: object
+            description: Hedging policy of the reads resolving the recipients of a batch
+            additionalProperties: false
+            properties:
+                enabled:
+                    type: boolean
+                    description: Send a second copy of the slow reads
+                    defaultDescription: false
+                percentile:
+                    type: number
+                    description: Percentile of the recent latencies the first request runs alone for
+                    defaultDescription: 95
+                min-delay:
+                    type: string
+                    description: Lower bound of the time the first request runs alone
+                    defaultDescription: 2ms
+                max-delay:
+                    type: string
+                    description: Upper bound of the time the first request runs alone
+                    defaultDescription: 100ms
+  )");
+}
+
+void ens::utils::HedgedReads::Account(ClassState &state, std::chrono::steady_clock::duration latency) {
+  state.latency_us.GetCurrentCounter().Account(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+}
+
+void ens::utils::HedgedReads::UpdateDelays() {
+  const auto cluster_statistics = _pg_cluster->GetStatistics();
+  _replicas = cluster_statistics->slaves.size() + (cluster_statistics->sync_slave.host_port.empty() ? 0 : 1);
+  for (ClassState &state : _classes) {
+    if (not state.policy.enabled) {
+      continue;
+    }
+    const int64_t min_delay_us = std::chrono::duration_cast<std::chrono::microseconds>(state.policy.min_delay).count();
+    const int64_t max_delay_us = std::chrono::duration_cast<std::chrono::microseconds>(state.policy.max_delay).count();
+    const uint32_t latency_us = state.latency_us.GetStatsForPeriod().GetPercentile(state.policy.percentile);
+    // Until the reads of the class are measured the copies are sent only after the longest delay
+    state.delay_us = latency_us == 0 ? max_delay_us : std::clamp(static_cast<int64_t>(latency_us),
+                                                                 min_delay_us,
+                                                                 max_delay_us);
+  }
+}
+
+void ens::utils::HedgedReads::WriteStatistics(userver::utils::statistics::Writer &writer) const {
+  for (size_t i = 0; i < _classes.size(); ++i) {
+    const ClassState &state = _classes[i];
+    const userver::utils::statistics::LabelView label{"class", kReadClassNames[i]};
+    writer["reads"].ValueWithLabels(state.reads.load(), {label});
+    writer["hedges"].ValueWithLabels(state.hedges.load(), {label});
+    writer["hedge-wins"].ValueWithLabels(state.hedge_wins.load(), {label});
+    writer["delay-us"].ValueWithLabels(state.delay_us.load(), {label});
+  }
+  writer["replicas"] = _replicas.load();
+}
+
+void ens::utils::AppendHedgedReads(userver::components::ComponentList &component_list) {
+  component_list.Append<HedgedReads>();
+}
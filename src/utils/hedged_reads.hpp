@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+#include <userver/components/component.hpp>
+#include <userver/components/component_list.hpp>
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/wait_any.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/periodic_task.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/utils/statistics/percentile.hpp>
+#include <userver/utils/statistics/recentperiod.hpp>
+#include <userver/utils/statistics/writer.hpp>
+
+#include "utils/utils.hpp"
+
+namespace ens::utils {
+// Reads whose tail latency the clients see directly, every class has a hedging policy of its own
+enum class ReadClass {
+  kAuth,
+  kGetById,
+  kFanOut
+};
+
+inline constexpr std::array<std::string_view, 3> kReadClassNames{"auth", "get-by-id", "fan-out"};
+
+// Component sending a second copy of a replica read once the first one has been running longer than
+// the recent percentile latency of its class. The first reply is taken and the other request is cancelled.
+// Reads aren't hedged while the cluster has a single replica, the copy would wait on the same host
+class HedgedReads : public userver::components::ComponentBase {
+ public:
+  static constexpr std::string_view kName = "hedged-reads";
+  static constexpr double kDefaultPercentile = 95;
+  static constexpr std::chrono::milliseconds kDefaultMinDelay{2};
+  static constexpr std::chrono::milliseconds kDefaultMaxDelay{100};
+  static constexpr std::chrono::seconds kDelayUpdatePeriod{1};
+  HedgedReads(const userver::components::ComponentConfig &config,
+              const userver::components::ComponentContext &component_context) :
+      ComponentBase(config, component_context),
+      _pg_cluster(
+          component_context
+              .FindComponent<userver::components::Postgres>(DB_COMPONENT_NAME)
+              .GetCluster()) {
+    for (size_t i = 0; i < kReadClassNames.size(); ++i) {
+      const userver::yaml_config::YamlConfig class_config = config[std::string{kReadClassNames[i]}];
+      _classes[i].policy = {class_config["enabled"].As<bool>(false),
+                            class_config["percentile"].As<double>(kDefaultPercentile),
+                            class_config["min-delay"].As<std::chrono::milliseconds>(kDefaultMinDelay),
+                            class_config["max-delay"].As<std::chrono::milliseconds>(kDefaultMaxDelay)};
+      _classes[i].delay_us = std::chrono::duration_cast<std::chrono::microseconds>(_classes[i].policy.max_delay).count();
+    }
+    // Replicas are counted right away, until then the reads aren't hedged
+    _delays_task.Start("hedged-reads-delays",
+                       {kDelayUpdatePeriod, {userver::utils::PeriodicTask::Flags::kNow}},
+                       [this] { UpdateDelays(); });
+    _statistics_holder = component_context.FindComponent<userver::components::StatisticsStorage>().GetStorage()
+        .RegisterWriter("ens.hedged-reads", [this](userver::utils::statistics::Writer &writer) {
+          WriteStatistics(writer);
+        });
+  }
+  ~HedgedReads() override {
+    _statistics_holder.Unregister();
+    _delays_task.Stop();
+  }
+  static userver::yaml_config::Schema GetStaticConfigSchema();
+  // Executes the read on a replica, hedged if the policy of its class is enabled
+  template<typename... Args>
+  userver::storages::postgres::ResultSet Execute(ReadClass read_class,
+                                                 const userver::storages::postgres::Query &query,
+                                                 const Args &... args);
+ private:
+  struct ClassPolicy {
+    bool enabled;
+    double percentile;
+    std::chrono::milliseconds min_delay;
+    std::chrono::milliseconds max_delay;
+  };
+  // Latencies are kept in microseconds, latencies up to 102ms are told apart
+  using LatencyPercentile = userver::utils::statistics::Percentile<2000, uint32_t, 1000, 100>;
+  struct ClassState {
+    ClassPolicy policy{};
+    // Latencies of the single requests, a hedged read accounts the one which has answered
+    userver::utils::statistics::RecentPeriod<LatencyPercentile, LatencyPercentile> latency_us;
+    // Time the first request runs alone, updated from the recent latencies
+    std::atomic<int64_t> delay_us{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> hedges{0};
+    // Hedged reads answered by the second copy first
+    std::atomic<uint64_t> hedge_wins{0};
+  };
+  static void Account(ClassState &state, std::chrono::steady_clock::duration latency);
+  void UpdateDelays();
+  void WriteStatistics(userver::utils::statistics::Writer &writer) const;
+  userver::storages::postgres::ClusterPtr _pg_cluster;
+  // Replicas known to the cluster, updated along with the delays
+  std::atomic<size_t> _replicas{0};
+  std::array<ClassState, kReadClassNames.size()> _classes;
+  userver::utils::PeriodicTask _delays_task;
+  userver::utils::statistics::Entry _statistics_holder;
+};
+
+template<typename... Args>
+userver::storages::postgres::ResultSet HedgedReads::Execute(ReadClass read_class,
+                                                            const userver::storages::postgres::Query &query,
+                                                            const Args &... args) {
+  ClassState &state = _classes.at(static_cast<size_t>(read_class));
+  if (not state.policy.enabled or _replicas.load() < 2) {
+    return _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave, query, args...);
+  }
+  ++state.reads;
+  const auto started_at = std::chrono::steady_clock::now();
+  auto primary = userver::utils::Async("hedged-read", [&] {
+    return _pg_cluster->Execute(userver::storages::postgres::ClusterHostType::kSlave, query, args...);
+  });
+  primary.WaitFor(std::chrono::microseconds{state.delay_us.load()});
+  if (primary.IsFinished()) {
+    Account(state, std::chrono::steady_clock::now() - started_at);
+    return primary.Get();
+  }
+  ++state.hedges;
+  // The copy picks the replica round-robin, so it mostly goes to another host. The cluster doesn't take
+  // a host to avoid, with n replicas one copy in n still shares the host of the first request
+  const auto hedge_started_at = std::chrono::steady_clock::now();
+  auto hedge = userver::utils::Async("hedged-read-copy", [&] {
+    return _pg_cluster->Execute(userver::storages::postgres::ClusterHostTypeFlags{
+                                    userver::storages::postgres::ClusterHostType::kSlave}
+                                    | userver::storages::postgres::ClusterHostType::kRoundRobin,
+                                query,
+                                args...);
+  });
+  const std::optional<size_t> first = userver::engine::WaitAny(primary, hedge);
+  if (not first.has_value()) {
+    // The caller is cancelled, the tasks are cancelled along with it
+    return primary.Get();
+  }
+  auto &winner = first.value() == 0 ? primary : hedge;
+  auto &other = first.value() == 0 ? hedge : primary;
+  std::optional<userver::storages::postgres::ResultSet> result;
+  try {
+    result.emplace(winner.Get());
+  }
+  catch (const std::exception &) {
+    // The other copy may still succeed
+    return other.Get();
+  }
+  other.RequestCancel();
+  if (first.value() == 1) {
+    ++state.hedge_wins;
+  }
+  // The hedge delay doesn't count towards the latency of the copy
+  Account(state, std::chrono::steady_clock::now() - (first.value() == 0 ? started_at : hedge_started_at));
+  return std::move(result.value());
+}
+
+void AppendHedgedReads(userver::components::ComponentList &component_list);
+}
@@ -13,3 +13,13 @@ std::optional<std::string> ens::utils::optional_uuid_to_str(const std::optional<
   }
   return boost::uuids::to_string(converted.value());
 }
+
+std::optional<std::string> ens::utils::resolve_attachment_path(const std::string &attachments_dir,
+                                                               const std::string &file_name) {
+  // Names escaping the directory and hidden files are rejected
+  if (attachments_dir.empty() or file_name.empty() or file_name.front() == '.'
+      or file_name.find_first_of("/\\") != std::string::npos) {
+    return std::nullopt;
+  }
+  return attachments_dir + "/" + file_name;
+}
@@ -20,7 +20,36 @@ class JWTSecdistConfig {
       : _jwt_secret(val["jwt_secret"].As<JwtSecret>()) {}
 };
 
+class TelegramWebhookSecdistConfig {
+ public:
+  using WebhookSecret = userver::utils::NonLoggable<class WebhookSecretTag, std::string>;
+  const std::string _webhook_secret;
+  TelegramWebhookSecdistConfig(const userver::formats::json::Value &val)
+      : _webhook_secret(val["telegram_webhook_secret"].As<WebhookSecret>(WebhookSecret{})) {}
+};
+
+class SmtpSecdistConfig {
+ public:
+  using SmtpPassword = userver::utils::NonLoggable<class SmtpPasswordTag, std::string>;
+  const std::string _username;
+  const std::string _password;
+  SmtpSecdistConfig(const userver::formats::json::Value &val)
+      : _username(val["smtp_username"].As<std::string>("")),
+        _password(val["smtp_password"].As<SmtpPassword>(SmtpPassword{})) {}
+};
+
+class SmsGatewaySecdistConfig {
+ public:
+  using GatewayToken = userver::utils::NonLoggable<class GatewayTokenTag, std::string>;
+  const std::string _gateway_token;
+  SmsGatewaySecdistConfig(const userver::formats::json::Value &val)
+      : _gateway_token(val["sms_gateway_token"].As<GatewayToken>(GatewayToken{})) {}
+};
+
 std::optional<boost::uuids::uuid> optional_str_to_uuid(const std::optional<std::string> &converted);
 
 std::optional<std::string> optional_uuid_to_str(const std::optional<boost::uuids::uuid> &converted);
+
+// Path of the attachment inside attachments_dir, nullopt if file_name isn't a plain file name
+std::optional<std::string> resolve_attachment_path(const std::string &attachments_dir, const std::string &file_name);
 }
\ No newline at end of file
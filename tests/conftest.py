@@ -1,8 +1,12 @@
+import json
 import pathlib
 
 import pytest
 from testsuite.databases.pgsql import discover
 
+from smtp_sink import SmtpSink
+from telegram_api import TelegramApi
+
 pytest_plugins = ['pytest_userver.plugins.postgresql']
 
 # TODO: get rid of secdist workaround
@@ -22,12 +26,70 @@ def service_source_dir():
 
 
 @pytest.fixture(scope='session')
-def prepare_service_config():
+def smtp_sink():
+    """Local SMTP server collecting the sent emails"""
+    sink = SmtpSink()
+    sink.start()
+    yield sink
+    sink.stop()
+
+
+@pytest.fixture
+def email_sink(smtp_sink):
+    smtp_sink.pop_messages()
+    return smtp_sink
+
+
+@pytest.fixture(scope='session')
+def secdist():
+    """Secrets the service is started with"""
+    with open(SERVICE_SOURCE_DIR / 'configs/secure_data.json') as secdist_file:
+        return json.load(secdist_file)
+
+
+@pytest.fixture
+def telegram_api(mockserver):
+    """Bot API mock recording the messages sent by the bots"""
+    api = TelegramApi()
+
+    @mockserver.json_handler('/telegram/', prefix=True)
+    async def _bot_api(request):
+        return await api.handle(request)
+
+    return api
+
+
+@pytest.fixture(scope='session')
+def prepare_service_config(smtp_sink, mockserver_info):
     def patch_config(config, config_vars):
         components = config['components_manager']['components']
         components['default-secdist-provider']['config'] = str(
             SERVICE_SOURCE_DIR / 'configs/secure_data.json',
         )
+        for component in ('template-manager', 'notification-manager'):
+            components[component]['attachments-dir'] = str(
+                SERVICE_SOURCE_DIR / 'tests/attachments',
+            )
+        components['telegram-bot-client']['api-base-url'] = mockserver_info.url('telegram')
+        # A single handler slot, so that a test can keep it busy
+        components['telegram-notifications-bot']['max-concurrent-updates'] = 1
+        components['email-sender'].update({
+            'host': 'localhost',
+            'port': smtp_sink.port,
+            'from-address': 'ens@localhost',
+            'max-recipients-per-message': 2,
+        })
+        components['sms-gateway'].update({
+            'url': mockserver_info.url('sms/bulk'),
+            'sender-id': 'ENS',
+            'max-recipients-per-request': 2,
+            'retries': 1,
+        })
+        # Progress streams end quickly, so that the tests read them whole
+        components['handler-notifications-batchProgress'].update({
+            'update-interval': '50ms',
+            'max-duration': '500ms',
+        })
 
     return patch_config
 
@@ -0,0 +1,97 @@
+import base64
+import email
+import email.policy
+import socketserver
+import threading
+import typing
+
+# Recipients with this local part prefix are refused by the sink
+REJECTED_PREFIX = "rejected"
+
+
+class SmtpSinkHandler(socketserver.StreamRequestHandler):
+    def reply(self, line: str):
+        self.wfile.write((line + "\r\n").encode())
+        self.wfile.flush()
+
+    def handle(self):
+        sink = self.server.sink
+        self.reply("220 localhost ESMTP sink")
+        mail_from, rcpt_to = None, []
+        while True:
+            line = self.rfile.readline()
+            if not line:
+                return
+            command = line.decode().rstrip("\r\n")
+            verb = command.split(" ", 1)[0].upper()
+            if verb == "EHLO":
+                self.reply("250-localhost")
+                self.reply("250 PIPELINING")
+            elif verb == "MAIL":
+                mail_from, rcpt_to = command[len("MAIL FROM:"):].strip("<>"), []
+                self.reply("250 OK")
+            elif verb == "RCPT":
+                recipient = command[len("RCPT TO:"):].strip("<>")
+                if recipient.startswith(REJECTED_PREFIX):
+                    self.reply("550 No such user")
+                    continue
+                rcpt_to.append(recipient)
+                self.reply("250 OK")
+            elif verb == "DATA":
+                if mail_from is None or not rcpt_to:
+                    self.reply("554 No valid recipients")
+                    continue
+                self.reply("354 End data with <CR><LF>.<CR><LF>")
+                data = []
+                while True:
+                    data_line = self.rfile.readline()
+                    if data_line in (b".\r\n", b""):
+                        break
+                    data.append(data_line[1:] if data_line.startswith(b"..") else data_line)
+                sink.add_message(mail_from, rcpt_to, b"".join(data))
+                mail_from, rcpt_to = None, []
+                self.reply("250 OK")
+            elif verb == "RSET":
+                mail_from, rcpt_to = None, []
+                self.reply("250 OK")
+            elif verb == "QUIT":
+                self.reply("221 Bye")
+                return
+            else:
+                self.reply("502 Command not implemented")
+
+
+class SmtpSink:
+    def __init__(self):
+        self._server = socketserver.ThreadingTCPServer(("127.0.0.1", 0), SmtpSinkHandler)
+        self._server.daemon_threads = True
+        self._server.sink = self
+        self._lock = threading.Lock()
+        self._messages = []
+        self._thread = threading.Thread(target=self._server.serve_forever, daemon=True)
+
+    @property
+    def port(self) -> int:
+        return self._server.server_address[1]
+
+    def start(self):
+        self._thread.start()
+
+    def stop(self):
+        self._server.shutdown()
+        self._server.server_close()
+
+    def add_message(self, mail_from: str, rcpt_to: typing.List[str], data: bytes):
+        message = email.message_from_bytes(data, policy=email.policy.default)
+        with self._lock:
+            self._messages.append({
+                "mail_from": mail_from,
+                "rcpt_to": rcpt_to,
+                "subject": str(message["Subject"]),
+                "body": base64.b64decode(message.get_payload()).decode(),
+            })
+
+    def pop_messages(self) -> typing.List[dict]:
+        with self._lock:
+            messages, self._messages = self._messages, []
+        return messages
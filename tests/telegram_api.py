@@ -0,0 +1,56 @@
+import asyncio
+import itertools
+import typing
+
+
+class TelegramApi:
+    """Bot API of the telegram bots, the sent messages are recorded in the order they are received"""
+
+    def __init__(self):
+        self._message_ids = itertools.count(1)
+        self._released = asyncio.Event()
+        self._released.set()
+        self.messages: typing.List[dict] = []
+        # Error replies to the messages sent to the chats
+        self.chat_errors: typing.Dict[int, dict] = {}
+        self.callback_answers: typing.List[dict] = []
+
+    def hold_messages(self):
+        """Replies to the sent messages are held back until release_messages"""
+        self._released.clear()
+
+    def release_messages(self):
+        self._released.set()
+
+    async def wait_messages(self, count: int, timeout: float = 10.0):
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + timeout
+        while len(self.messages) < count:
+            assert loop.time() < deadline, f"{len(self.messages)} of {count} telegram messages were sent"
+            await asyncio.sleep(0.01)
+
+    async def handle(self, request) -> dict:
+        method = request.path.rsplit("/", 1)[-1]
+        if method == "getUpdates":
+            # Long polling requests end without updates
+            await asyncio.sleep(0.1)
+            return {"ok": True, "result": []}
+        if method == "answerCallbackQuery":
+            self.callback_answers.append(request.json)
+            return {"ok": True, "result": True}
+        if method == "sendMessage":
+            message = request.json
+            self.messages.append(message)
+            await self._released.wait()
+            if message["chat_id"] in self.chat_errors:
+                return self.chat_errors[message["chat_id"]]
+            return {
+                "ok": True,
+                "result": {
+                    "message_id": next(self._message_ids),
+                    "date": 1700000000,
+                    "chat": {"id": message["chat_id"], "type": "private"},
+                    "text": message["text"],
+                },
+            }
+        return {"ok": False, "error_code": 404, "description": "Not Found"}
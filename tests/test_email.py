@@ -0,0 +1,58 @@
+import utils
+
+
+async def test_send_batch_email_200(service_client, pgsql, email_sink):
+    emails = ["first@example.com", "second@example.com"]
+    access_token, recipient_ids = await utils.create_recipient_group(service_client,
+                                                                     [{"email": email} for email in emails])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 3, pgsql)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(response.json()) == 2
+    assert len(db_notifications) == 2
+    assert all(notification[0] == "Mail" for notification in db_notifications)
+    assert sorted(str(notification[5]) for notification in db_notifications) == sorted(recipient_ids)
+    assert len(messages) == 1
+    assert messages[0]["mail_from"] == "ens@localhost"
+    assert sorted(messages[0]["rcpt_to"]) == sorted(emails)
+    assert messages[0]["subject"] == "Evacuation"
+    assert messages[0]["body"] == "Leave the building"
+
+
+async def test_send_batch_email_utf8_200(service_client, email_sink):
+    template_name = "Эвакуация"
+    message_text = "Покиньте здание.\n.\nНемедленно"
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": "first@example.com"}],
+                                                      template_name, message_text)
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(messages) == 1
+    assert messages[0]["subject"] == template_name
+    assert messages[0]["body"] == message_text
+
+
+async def test_send_batch_email_recipients_split_200(service_client, email_sink):
+    emails = ["first@example.com", "second@example.com", "third@example.com"]
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": email} for email in emails])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(messages) == 2
+    assert all(len(message["rcpt_to"]) <= 2 for message in messages)
+    assert sorted(rcpt for message in messages for rcpt in message["rcpt_to"]) == sorted(emails)
+
+
+async def test_send_batch_email_rejected_recipient_200(service_client, email_sink):
+    emails = ["first@example.com", "rejected@example.com"]
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": email} for email in emails])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(messages) == 1
+    assert messages[0]["rcpt_to"] == ["first@example.com"]
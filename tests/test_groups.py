@@ -780,3 +780,54 @@ async def test_delete_group_404_incorrect_group_id(service_client):
     await utils.delete_group(service_client, group_id, access_token)
     response = await utils.delete_group(service_client, group_id, access_token)
     assert response.status == 404
+
+
+async def test_set_group_telegram_channel_200(service_client, pgsql):
+    name = "test_group_1"
+    active = True
+    channel_id = -1001234567890
+    access_token, group_id = await create_group_w_confirmation(service_client, name, active)
+    response = await utils.set_group_telegram_channel(service_client, group_id, channel_id, access_token)
+    db_group = await utils.db_get_group(group_id, pgsql)
+    assert response.status == 200
+    assert db_group[5] == channel_id
+
+
+async def test_set_group_telegram_channel_200_reset(service_client, pgsql):
+    name = "test_group_1"
+    active = True
+    access_token, group_id = await create_group_w_confirmation(service_client, name, active)
+    await utils.set_group_telegram_channel(service_client, group_id, -1001234567890, access_token)
+    response = await utils.set_group_telegram_channel(service_client, group_id, access_token=access_token)
+    db_group = await utils.db_get_group(group_id, pgsql)
+    assert response.status == 200
+    assert db_group[5] is None
+
+
+async def test_set_group_telegram_channel_401_missing_token(service_client, pgsql):
+    name = "test_group_1"
+    active = True
+    access_token, group_id = await create_group_w_confirmation(service_client, name, active)
+    response = await utils.set_group_telegram_channel(service_client, group_id, -1001234567890)
+    db_group = await utils.db_get_group(group_id, pgsql)
+    assert response.status == 401
+    assert db_group[5] is None
+
+
+async def test_set_group_telegram_channel_404_non_integer_channel_id(service_client, pgsql):
+    name = "test_group_1"
+    active = True
+    access_token, group_id = await create_group_w_confirmation(service_client, name, active)
+    response = await utils.set_group_telegram_channel(service_client, group_id, "incorrect channel_id", access_token)
+    db_group = await utils.db_get_group(group_id, pgsql)
+    assert response.status == 404
+    assert db_group[5] is None
+
+
+async def test_set_group_telegram_channel_404_incorrect_group_id(service_client):
+    name = "test_group_1"
+    active = True
+    access_token, group_id = await create_group_w_confirmation(service_client, name, active)
+    await utils.delete_group(service_client, group_id, access_token)
+    response = await utils.set_group_telegram_channel(service_client, group_id, -1001234567890, access_token)
+    assert response.status == 404
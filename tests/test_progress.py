@@ -0,0 +1,75 @@
+import utils
+
+
+async def test_batch_progress_200_unsent(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.get_batch_progress(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert response.headers["Content-Type"].startswith("text/event-stream")
+    events = utils.parse_progress_events(response.text)
+    assert len(events) == 1
+    assert events[0] == {"targeted": 0, "sent": 0, "failed": 0, "pending": 0, "responded": 0, "finished": False}
+    # The client reconnects to the stream of an unfinished batch
+    assert "event: end" not in response.text
+
+
+async def test_batch_progress_200_sent(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": "first@example.com"},
+                                                                       {"email": "second@example.com"}],
+                                                      "Drill", "Fire drill at noon")
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    await utils.send_batch(service_client, batch_id, access_token)
+    response = await utils.get_batch_progress(service_client, batch_id, access_token)
+    assert response.status == 200
+    events = utils.parse_progress_events(response.text)
+    # The stream of a finished batch stays open for the responses and ends with an end event
+    assert events == [{"targeted": 2, "sent": 2, "failed": 0, "pending": 0, "responded": 0, "finished": True}]
+    assert response.text.endswith("event: end\ndata: {}\n\n")
+
+
+async def test_batch_progress_401_missing_token(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.get_batch_progress(service_client, batch_id)
+    assert response.status == 401
+
+
+async def test_batch_progress_404_incorrect_batch_id(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.get_batch_progress(service_client, "00000000-0000-0000-0000-000000000000", access_token)
+    assert response.status == 404
+
+
+async def test_batch_summary_200_sent(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": "first@example.com"},
+                                                                       {"email": "second@example.com"}],
+                                                      "Drill", "Fire drill at noon")
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    await utils.send_batch(service_client, batch_id, access_token)
+    response = await utils.get_batch_summary(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert response.json() == {"targeted": 2, "sent": 2, "failed": 0, "pending": 0, "responded": 0, "finished": True}
+
+
+async def test_batch_summary_200_stored_counters(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    # Counters written by another instance of the service
+    await utils.db_set_batch_counters(batch_id, 10, 6, 1, 4, False, pgsql)
+    response = await utils.get_batch_summary(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert response.json() == {"targeted": 10, "sent": 6, "failed": 1, "pending": 3, "responded": 4, "finished": False}
+
+
+async def test_batch_summary_401_missing_token(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.get_batch_summary(service_client, batch_id)
+    assert response.status == 401
+
+
+async def test_batch_summary_404_incorrect_batch_id(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.get_batch_summary(service_client, "00000000-0000-0000-0000-000000000000", access_token)
+    assert response.status == 404
@@ -444,3 +444,48 @@ async def test_delete_recipient_404_incorrect_recipient_id(service_client):
     await utils.delete_recipient(service_client, recipient_id, access_token)
     response = await utils.delete_recipient(service_client, recipient_id, access_token)
     assert response.status == 404
+
+
+async def test_set_recipient_preferred_channel_200(service_client, pgsql):
+    access_token, recipient_id = await create_recipient_w_confirmation(service_client, "test_recipient_1",
+                                                                       "example@domain.com", "+1234567")
+    response = await utils.set_recipient_preferred_channel(service_client, recipient_id, "SMS", access_token)
+    db_recipient = await utils.db_get_recipient(recipient_id, pgsql)
+    assert response.status == 200
+    assert db_recipient[6] == "SMS"
+
+
+async def test_set_recipient_preferred_channel_200_reset(service_client, pgsql):
+    access_token, recipient_id = await create_recipient_w_confirmation(service_client, "test_recipient_1",
+                                                                       "example@domain.com", "+1234567")
+    await utils.set_recipient_preferred_channel(service_client, recipient_id, "SMS", access_token)
+    response = await utils.set_recipient_preferred_channel(service_client, recipient_id, access_token=access_token)
+    db_recipient = await utils.db_get_recipient(recipient_id, pgsql)
+    assert response.status == 200
+    assert db_recipient[6] is None
+
+
+async def test_set_recipient_preferred_channel_401_missing_token(service_client, pgsql):
+    _, recipient_id = await create_recipient_w_confirmation(service_client, "test_recipient_1", "example@domain.com")
+    response = await utils.set_recipient_preferred_channel(service_client, recipient_id, "Mail")
+    db_recipient = await utils.db_get_recipient(recipient_id, pgsql)
+    assert response.status == 401
+    assert db_recipient[6] is None
+
+
+async def test_set_recipient_preferred_channel_404_incorrect_recipient_id(service_client):
+    access_token, recipient_id = await create_recipient_w_confirmation(service_client, "test_recipient_1",
+                                                                       "example@domain.com")
+    await utils.delete_recipient(service_client, recipient_id, access_token)
+    response = await utils.set_recipient_preferred_channel(service_client, recipient_id, "Mail", access_token)
+    assert response.status == 404
+
+
+async def test_set_recipient_preferred_channel_422_incorrect_channel(service_client, pgsql):
+    access_token, recipient_id = await create_recipient_w_confirmation(service_client, "test_recipient_1",
+                                                                       "example@domain.com")
+    for channel in ("Pigeon", "TelegramChannel"):
+        response = await utils.set_recipient_preferred_channel(service_client, recipient_id, channel, access_token)
+        assert response.status == 422
+    db_recipient = await utils.db_get_recipient(recipient_id, pgsql)
+    assert db_recipient[6] is None
@@ -0,0 +1,103 @@
+import asyncio
+import json
+
+import utils
+
+
+async def test_get_batch_responses_200_no_responses(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.get_batch_responses(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert response.json() == {"Safe": 0, "NeedHelp": 0}
+
+
+async def test_get_batch_responses_200(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    await utils.db_set_batch_response_tally(batch_id, "Safe", 42, pgsql)
+    await utils.db_set_batch_response_tally(batch_id, "NeedHelp", 3, pgsql)
+    response = await utils.get_batch_responses(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert response.json() == {"Safe": 42, "NeedHelp": 3}
+
+
+async def test_get_batch_responses_401_missing_token(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.get_batch_responses(service_client, batch_id)
+    assert response.status == 401
+
+
+async def test_get_batch_responses_404_incorrect_batch_id(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.get_batch_responses(service_client, "00000000-0000-0000-0000-000000000000", access_token)
+    assert response.status == 404
+
+
+async def test_get_batch_responses_404_other_user_batch(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    other_access_token = (await utils.create_user("test_user_2", "1234", service_client)).json()["access_token"]
+    response = await utils.get_batch_responses(service_client, batch_id, other_access_token)
+    assert response.status == 404
+
+
+def callback_query_update(update_id: int, callback_data: str) -> dict:
+    return {
+        "update_id": update_id,
+        "callback_query": {
+            "id": str(update_id),
+            "from": {"id": 1, "is_bot": False, "first_name": "Recipient"},
+            "chat_instance": "1",
+            "data": callback_data,
+        },
+    }
+
+
+async def wait_batch_responses(service_client, batch_id: str, access_token: str, expected: dict,
+                               timeout: float = 10.0) -> dict:
+    # Responses reach the tallies once the writer has flushed them
+    loop = asyncio.get_running_loop()
+    deadline = loop.time() + timeout
+    while True:
+        responses = (await utils.get_batch_responses(service_client, batch_id, access_token)).json()
+        if responses == expected or loop.time() >= deadline:
+            return responses
+        await asyncio.sleep(0.05)
+
+
+async def test_push_callback_query_200_responses(service_client, pgsql, secdist, telegram_api):
+    access_token, _ = await utils.create_recipient_group(service_client, [{"telegram_id": 1}])
+    await utils.db_add_telegram_contacts([1], pgsql)
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    await utils.send_batch(service_client, batch_id, access_token)
+    await telegram_api.wait_messages(1)
+    reply_markup = telegram_api.messages[0]["reply_markup"]
+    if isinstance(reply_markup, str):
+        reply_markup = json.loads(reply_markup)
+    safe_data, need_help_data = [button["callback_data"] for button in reply_markup["inline_keyboard"][0]]
+    secret = secdist["telegram_webhook_secret"]
+
+    response = await utils.push_telegram_update(service_client, callback_query_update(1, safe_data), secret)
+    safe_responses = await wait_batch_responses(service_client, batch_id, access_token, {"Safe": 1, "NeedHelp": 0})
+    safe_rows = await utils.db_get_notification_responses(batch_id, pgsql)
+    assert response.status == 200
+    assert safe_responses == {"Safe": 1, "NeedHelp": 0}
+    assert [row[1:] for row in safe_rows] == [("Safe", 1)]
+
+    # A repeated click of the same button isn't counted again
+    await utils.push_telegram_update(service_client, callback_query_update(2, safe_data), secret)
+    # Past the flush of the responses writer
+    await asyncio.sleep(0.3)
+    repeated_responses = (await utils.get_batch_responses(service_client, batch_id, access_token)).json()
+    assert repeated_responses == {"Safe": 1, "NeedHelp": 0}
+
+    # The response moves to the new status
+    await utils.push_telegram_update(service_client, callback_query_update(3, need_help_data), secret)
+    changed_responses = await wait_batch_responses(service_client, batch_id, access_token, {"Safe": 0, "NeedHelp": 1})
+    changed_rows = await utils.db_get_notification_responses(batch_id, pgsql)
+    assert changed_responses == {"Safe": 0, "NeedHelp": 1}
+    assert [row[1:] for row in changed_rows] == [("NeedHelp", 1)]
+    assert changed_rows[0][0] == safe_rows[0][0]
+    assert len(telegram_api.callback_answers) == 3
@@ -0,0 +1,129 @@
+import utils
+
+
+async def test_send_batch_channel_priority_200(service_client, pgsql, mockserver, email_sink):
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        return {"rejected": []}
+
+    access_token, _ = await utils.create_recipient_group(service_client, [
+        {"email": "first@example.com", "phone_number": "+123456789"},
+    ])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 2, pgsql)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(db_notifications) == 1
+    assert db_notifications[0][0] == "Mail"
+    assert len(messages) == 1
+    assert _sms_bulk.times_called == 0
+
+
+async def test_send_batch_preferred_channel_200(service_client, pgsql, mockserver, email_sink):
+    submissions = []
+
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        submissions.append(request.json)
+        return {"rejected": []}
+
+    access_token, recipient_ids = await utils.create_recipient_group(service_client, [
+        {"email": "first@example.com", "phone_number": "+123456789", "preferred_channel": "SMS"},
+        {"email": "second@example.com", "phone_number": "+987654321"},
+    ])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 3, pgsql)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert len(db_notifications) == 2
+    assert {str(notification[5]): notification[0] for notification in db_notifications} == {
+        recipient_ids[0]: "SMS",
+        recipient_ids[1]: "Mail",
+    }
+    assert len(submissions) == 1
+    assert submissions[0]["recipients"] == ["+123456789"]
+    assert len(messages) == 1
+    assert messages[0]["rcpt_to"] == ["second@example.com"]
+
+
+async def test_send_batch_fallback_on_failure_200(service_client, pgsql, mockserver, email_sink):
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        return mockserver.make_response(status=500)
+
+    access_token, _ = await utils.create_recipient_group(service_client, [
+        {"email": "first@example.com", "phone_number": "+123456789", "preferred_channel": "SMS"},
+    ])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 2, pgsql)
+    messages = email_sink.pop_messages()
+    assert response.status == 200
+    assert _sms_bulk.times_called == 1
+    assert len(db_notifications) == 1
+    assert db_notifications[0][0] == "Mail"
+    assert len(messages) == 1
+    assert messages[0]["rcpt_to"] == ["first@example.com"]
+
+
+async def test_send_batch_fallback_on_rejection_200(service_client, pgsql, mockserver, email_sink):
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        return {"rejected": []}
+
+    access_token, _ = await utils.create_recipient_group(service_client, [
+        {"email": "rejected@example.com", "phone_number": "+123456789"},
+    ])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 2, pgsql)
+    assert response.status == 200
+    assert email_sink.pop_messages() == []
+    assert _sms_bulk.times_called == 1
+    assert len(db_notifications) == 1
+    assert db_notifications[0][0] == "SMS"
+
+
+async def test_create_batch_priority_200(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [
+        {"email": "first@example.com"},
+    ])
+    response = await utils.create_batch(service_client, access_token, "Emergency")
+    batch_id = response.json()
+    db_batch = await utils.db_get_batch(batch_id, pgsql)
+    assert response.status == 200
+    assert db_batch[3] == "Emergency"
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert len(email_sink.pop_messages()) == 1
+
+
+async def test_create_batch_default_priority_200(service_client, pgsql):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.create_batch(service_client, access_token)
+    db_batch = await utils.db_get_batch(response.json(), pgsql)
+    assert response.status == 200
+    assert db_batch[3] == "Routine"
+
+
+async def test_create_batch_incorrect_priority_422(service_client):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.create_batch(service_client, access_token, "Urgent")
+    assert response.status == 422
+
+
+async def test_send_batches_of_tenant_tiers_200(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [
+        {"email": "first@example.com"},
+    ])
+    db_user = await utils.db_get_user_by_name("test_user_1", pgsql)
+    assert db_user[4] == "Standard"
+    await utils.db_set_user_tier("test_user_1", "Premium", pgsql)
+    batch_ids = [(await utils.create_batch(service_client, access_token, priority)).json()
+                 for priority in ["Routine", "Emergency"]]
+    for batch_id in batch_ids:
+        response = await utils.send_batch(service_client, batch_id, access_token)
+        assert response.status == 200
+    assert len(email_sink.pop_messages()) == 2
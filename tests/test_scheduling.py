@@ -0,0 +1,58 @@
+import asyncio
+import time
+
+import utils
+
+
+def now_ms() -> int:
+    return int(time.time() * 1000)
+
+
+async def test_schedule_batch_due_200(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": "first@example.com"}],
+                                                      "Drill", "Fire drill at noon")
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.schedule_batch(service_client, batch_id, str(now_ms() - 1000), access_token)
+    assert response.status == 200
+    db_notifications = []
+    for _ in range(100):
+        db_notifications = await utils.db_get_batch_notifications(batch_id, 2, pgsql)
+        if db_notifications:
+            break
+        await asyncio.sleep(0.05)
+    db_batch = await utils.db_get_batch(batch_id, pgsql)
+    assert len(db_notifications) == 1
+    assert db_batch[0]
+    assert db_batch[4] is None
+    assert len(email_sink.pop_messages()) == 1
+
+
+async def test_schedule_batch_future_200(service_client, pgsql, email_sink):
+    access_token, _ = await utils.create_recipient_group(service_client, [{"email": "first@example.com"}],
+                                                      "Drill", "Fire drill at noon")
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    scheduled_at = now_ms() + 3600 * 1000
+    response = await utils.schedule_batch(service_client, batch_id, str(scheduled_at), access_token)
+    db_batch = await utils.db_get_batch(batch_id, pgsql)
+    assert response.status == 200
+    assert not db_batch[0]
+    assert db_batch[4] == scheduled_at
+    response = await utils.schedule_batch(service_client, batch_id, access_token=access_token)
+    db_batch = await utils.db_get_batch(batch_id, pgsql)
+    assert response.status == 200
+    assert db_batch[4] is None
+    assert email_sink.pop_messages() == []
+
+
+async def test_schedule_batch_not_found_404(service_client):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    response = await utils.schedule_batch(service_client, "00000000-0000-0000-0000-000000000000",
+                                          str(now_ms()), access_token)
+    assert response.status == 404
+
+
+async def test_schedule_batch_incorrect_time_422(service_client):
+    access_token = (await utils.create_user("test_user_1", "1234", service_client)).json()["access_token"]
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.schedule_batch(service_client, batch_id, "tomorrow", access_token)
+    assert response.status == 422
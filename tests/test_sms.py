@@ -0,0 +1,96 @@
+import utils
+
+
+async def test_send_batch_sms_gsm7_200(service_client, pgsql, mockserver):
+    submissions = []
+
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        submissions.append(request.json)
+        return {"rejected": []}
+
+    phone_numbers = ["+123456789", "+987654321"]
+    access_token, recipient_ids = await utils.create_recipient_group(
+        service_client, [{"phone_number": phone_number} for phone_number in phone_numbers])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 3, pgsql)
+    assert response.status == 200
+    assert len(db_notifications) == 2
+    assert all(notification[0] == "SMS" for notification in db_notifications)
+    assert sorted(str(notification[5]) for notification in db_notifications) == sorted(recipient_ids)
+    assert len(submissions) == 1
+    assert submissions[0]["sender"] == "ENS"
+    assert submissions[0]["encoding"] == "GSM7"
+    assert submissions[0]["segments"] == 1
+    assert submissions[0]["text"] == "Leave the building"
+    assert sorted(submissions[0]["recipients"]) == sorted(phone_numbers)
+
+
+async def test_send_batch_sms_ucs2_segments_200(service_client, mockserver):
+    submissions = []
+
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        submissions.append(request.json)
+        return {"rejected": []}
+
+    message_text = "Ж" * 71
+    access_token, _ = await utils.create_recipient_group(service_client, [{"phone_number": "+123456789"}],
+                                                      message_text=message_text)
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert len(submissions) == 1
+    assert submissions[0]["encoding"] == "UCS2"
+    assert submissions[0]["segments"] == 2
+    assert submissions[0]["text"] == message_text
+
+
+async def test_send_batch_sms_recipients_split_200(service_client, mockserver):
+    submissions = []
+
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        submissions.append(request.json)
+        return {"rejected": []}
+
+    phone_numbers = ["+111111111", "+222222222", "+333333333"]
+    access_token, _ = await utils.create_recipient_group(
+        service_client, [{"phone_number": phone_number} for phone_number in phone_numbers])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert len(submissions) == 2
+    assert all(len(submission["recipients"]) <= 2 for submission in submissions)
+    assert sorted(number for submission in submissions for number in submission["recipients"]) == sorted(phone_numbers)
+
+
+async def test_send_batch_sms_phone_number_normalized_200(service_client, mockserver):
+    submissions = []
+
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        submissions.append(request.json)
+        return {"rejected": []}
+
+    access_token, _ = await utils.create_recipient_group(service_client, [{"phone_number": "+1 (234) 567-89"}])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    assert response.status == 200
+    assert len(submissions) == 1
+    assert submissions[0]["recipients"] == ["+123456789"]
+
+
+async def test_send_batch_sms_gateway_error_200(service_client, pgsql, mockserver):
+    @mockserver.json_handler('/sms/bulk')
+    def _sms_bulk(request):
+        return mockserver.make_response(status=500)
+
+    access_token, _ = await utils.create_recipient_group(service_client, [{"phone_number": "+123456789"}])
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_notifications = await utils.db_get_batch_notifications(batch_id, 2, pgsql)
+    assert response.status == 200
+    assert _sms_bulk.times_called == 1
+    assert len(db_notifications) == 1
@@ -0,0 +1,79 @@
+import asyncio
+
+import utils
+
+
+async def test_send_batch_telegram_migrated_chat_200(service_client, pgsql, telegram_api):
+    # The migrated chat is reached through two recipients of the batch
+    access_token, recipient_ids = await utils.create_recipient_group(service_client, [
+        {"telegram_id": 5},
+        {"telegram_id": 5},
+        {"telegram_id": 6},
+    ])
+    await utils.db_add_telegram_contacts([5, 6], pgsql)
+    telegram_api.chat_errors[5] = {
+        "ok": False,
+        "error_code": 400,
+        "description": "Bad Request: group chat was upgraded to a supergroup chat",
+        "parameters": {"migrate_to_chat_id": -1005},
+    }
+    batch_id = (await utils.create_batch(service_client, access_token)).json()
+    response = await utils.send_batch(service_client, batch_id, access_token)
+    db_recipients = [await utils.db_get_recipient(recipient_id, pgsql) for recipient_id in recipient_ids]
+    assert response.status == 200
+    assert sorted(message["chat_id"] for message in telegram_api.messages) == [5, 5, 6]
+    assert await utils.db_get_telegram_contacts(pgsql) == [(-1005, True), (5, False), (6, True)]
+    assert [recipient[3] for recipient in db_recipients] == [-1005, -1005, 6]
+
+
+async def test_send_batch_telegram_emergency_overtakes_routine_200(service_client, pgsql, telegram_api):
+    routine_ids = list(range(1001, 1041))
+    emergency_ids = list(range(2001, 2006))
+    routine_token, _ = await utils.create_recipient_group(service_client,
+                                                          [{"telegram_id": i} for i in routine_ids],
+                                                          "Check", "Routine check", "test_user_1")
+    emergency_token, _ = await utils.create_recipient_group(service_client,
+                                                            [{"telegram_id": i} for i in emergency_ids],
+                                                            "Evacuation", "Leave the building", "test_user_2")
+    await utils.db_add_telegram_contacts(routine_ids + emergency_ids, pgsql)
+    routine_batch_id = (await utils.create_batch(service_client, routine_token, "Routine")).json()
+    emergency_batch_id = (await utils.create_batch(service_client, emergency_token, "Emergency")).json()
+    routine_send = asyncio.create_task(utils.send_batch(service_client, routine_batch_id, routine_token))
+    await telegram_api.wait_messages(5)
+    emergency_response = await utils.send_batch(service_client, emergency_batch_id, emergency_token)
+    routine_response = await routine_send
+    chat_ids = [message["chat_id"] for message in telegram_api.messages]
+    emergency_positions = [i for i, chat_id in enumerate(chat_ids) if chat_id in emergency_ids]
+    assert emergency_response.status == 200
+    assert routine_response.status == 200
+    assert sorted(chat_ids) == routine_ids + emergency_ids
+    assert len(emergency_positions) == len(emergency_ids)
+    # The Routine lane gets a single slot of every 17 while the emergency messages wait
+    assert emergency_positions[-1] - emergency_positions[0] <= len(emergency_ids)
+
+
+async def test_send_batch_telegram_tier_weights_200(service_client, pgsql, telegram_api):
+    premium_ids = list(range(1001, 1041))
+    basic_ids = list(range(2001, 2041))
+    premium_token, _ = await utils.create_recipient_group(service_client,
+                                                          [{"telegram_id": i} for i in premium_ids],
+                                                          "Check", "Routine check", "test_user_1")
+    basic_token, _ = await utils.create_recipient_group(service_client,
+                                                        [{"telegram_id": i} for i in basic_ids],
+                                                        "Check", "Routine check", "test_user_2")
+    await utils.db_set_user_tier("test_user_1", "Premium", pgsql)
+    await utils.db_set_user_tier("test_user_2", "Basic", pgsql)
+    await utils.db_add_telegram_contacts(premium_ids + basic_ids, pgsql)
+    premium_batch_id = (await utils.create_batch(service_client, premium_token)).json()
+    basic_batch_id = (await utils.create_batch(service_client, basic_token)).json()
+    responses = await asyncio.gather(
+        utils.send_batch(service_client, premium_batch_id, premium_token),
+        utils.send_batch(service_client, basic_batch_id, basic_token),
+    )
+    chat_ids = [message["chat_id"] for message in telegram_api.messages]
+    last_premium_position = max(i for i, chat_id in enumerate(chat_ids) if chat_id in premium_ids)
+    basic_sent = sum(1 for chat_id in chat_ids[:last_premium_position] if chat_id in basic_ids)
+    assert [response.status for response in responses] == [200, 200]
+    assert sorted(chat_ids) == premium_ids + basic_ids
+    # Premium tenants get 4 sends of every 5 while a Basic one sends in the same lane
+    assert basic_sent <= len(premium_ids) // 4 + 4
@@ -0,0 +1,83 @@
+import asyncio
+
+import pytest
+
+import utils
+
+UPDATE = {
+    "update_id": 1,
+    "message": {
+        "message_id": 1,
+        "date": 1700000000,
+        "chat": {"id": 1, "type": "private"},
+        "text": "/send_notifications",
+    },
+}
+
+
+def long_polling_mode(config, config_vars):
+    config_vars["telegram-update-mode"] = "long-polling"
+
+
+async def test_push_update_200_send_notifications(service_client, pgsql, secdist, telegram_api):
+    response = await utils.push_telegram_update(service_client, UPDATE, secdist["telegram_webhook_secret"])
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT user_id, active, bot_index FROM ens_schema.telegram_contact")
+    assert response.status == 200
+    assert cursor.fetchall() == [(1, True, 0)]
+    assert len(telegram_api.messages) == 1
+    assert telegram_api.messages[0]["chat_id"] == 1
+
+
+async def test_push_update_200_stop_notifications(service_client, pgsql, secdist, telegram_api):
+    stop_update = {**UPDATE, "update_id": 2, "message": {**UPDATE["message"], "text": "/stop_notifications"}}
+    await utils.push_telegram_update(service_client, UPDATE, secdist["telegram_webhook_secret"])
+    response = await utils.push_telegram_update(service_client, stop_update, secdist["telegram_webhook_secret"])
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT user_id, active FROM ens_schema.telegram_contact")
+    assert response.status == 200
+    assert cursor.fetchall() == [(1, False)]
+    assert len(telegram_api.messages) == 2
+
+
+async def test_push_update_401_missing_secret(service_client, pgsql):
+    response = await utils.push_telegram_update(service_client, UPDATE)
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT * FROM ens_schema.telegram_contact")
+    assert response.status == 401
+    assert len(cursor.fetchall()) == 0
+
+
+async def test_push_update_401_incorrect_secret(service_client, pgsql):
+    response = await utils.push_telegram_update(service_client, UPDATE, "incorrect_secret")
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT * FROM ens_schema.telegram_contact")
+    assert response.status == 401
+    assert len(cursor.fetchall()) == 0
+
+
+async def test_push_update_429_handlers_busy(service_client, pgsql, secdist, telegram_api):
+    other_update = {**UPDATE, "update_id": 2, "message": {**UPDATE["message"], "chat": {"id": 2, "type": "private"}}}
+    # The reply of the first update is held back, so that its handler keeps the only slot
+    telegram_api.hold_messages()
+    first_push = asyncio.create_task(
+        utils.push_telegram_update(service_client, UPDATE, secdist["telegram_webhook_secret"]))
+    await telegram_api.wait_messages(1)
+    response = await utils.push_telegram_update(service_client, other_update, secdist["telegram_webhook_secret"])
+    telegram_api.release_messages()
+    first_response = await first_push
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT user_id FROM ens_schema.telegram_contact")
+    assert response.status == 429
+    assert first_response.status == 200
+    assert cursor.fetchall() == [(1,)]
+
+
+@pytest.mark.uservice_oneshot(config_hooks=[long_polling_mode])
+async def test_push_update_404_long_polling_mode(service_client, pgsql, secdist, telegram_api):
+    response = await utils.push_telegram_update(service_client, UPDATE, secdist["telegram_webhook_secret"])
+    cursor = pgsql[utils.DB_NAME].cursor()
+    cursor.execute("SELECT * FROM ens_schema.telegram_contact")
+    assert response.status == 404
+    assert len(cursor.fetchall()) == 0
+    assert len(telegram_api.messages) == 0
@@ -391,3 +391,57 @@ async def test_delete_template_404_incorrect_template_id(service_client):
     await utils.delete_template(service_client, template_id, access_token)
     response = await utils.delete_template(service_client, template_id, access_token)
     assert response.status == 404
+
+
+async def test_set_template_attachment_200(service_client, pgsql):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    response = await utils.set_template_attachment(service_client, template_id, "evacuation_plan.txt", access_token)
+    db_template = await utils.db_get_template(template_id, pgsql)
+    assert response.status == 200
+    assert db_template[4] == "evacuation_plan.txt"
+
+
+async def test_set_template_attachment_200_remove(service_client, pgsql):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    await utils.set_template_attachment(service_client, template_id, "evacuation_plan.txt", access_token)
+    response = await utils.set_template_attachment(service_client, template_id, access_token=access_token)
+    db_template = await utils.db_get_template(template_id, pgsql)
+    assert response.status == 200
+    assert db_template[4] is None
+
+
+async def test_set_template_attachment_401_missing_token(service_client, pgsql):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    response = await utils.set_template_attachment(service_client, template_id, "evacuation_plan.txt")
+    db_template = await utils.db_get_template(template_id, pgsql)
+    assert response.status == 401
+    assert db_template[4] is None
+
+
+async def test_set_template_attachment_404_incorrect_template_id(service_client):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    await utils.delete_template(service_client, template_id, access_token)
+    response = await utils.set_template_attachment(service_client, template_id, "evacuation_plan.txt", access_token)
+    assert response.status == 404
+
+
+async def test_set_template_attachment_422_missing_file(service_client, pgsql):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    response = await utils.set_template_attachment(service_client, template_id, "missing_plan.pdf", access_token)
+    db_template = await utils.db_get_template(template_id, pgsql)
+    assert response.status == 422
+    assert db_template[4] is None
+
+
+async def test_set_template_attachment_422_outside_attachments_dir(service_client, pgsql):
+    access_token, template_id = await create_template_w_confirmation(service_client, "test_template_1",
+                                                                     "message_text")
+    response = await utils.set_template_attachment(service_client, template_id, "../conftest.py", access_token)
+    db_template = await utils.db_get_template(template_id, pgsql)
+    assert response.status == 422
+    assert db_template[4] is None
@@ -77,6 +77,15 @@ async def db_get_users(rows_num: int, pgsql) -> typing.List[tuple]:
     return records
 
 
+async def db_set_user_tier(name: str, tier: str, pgsql) -> None:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "UPDATE ens_schema.user "
+        "SET tier = %s "
+        "WHERE name = %s", (tier, name),
+    )
+
+
 async def create_recipient(service_client, name: str, email: str = "", phone_number: str = "",
                            telegram_id: str = "", access_token: str = ""):
     payload = compact_dict({
@@ -155,6 +164,18 @@ async def delete_recipient(service_client, recipient_id: str, access_token: str
     return response
 
 
+async def set_recipient_preferred_channel(service_client, recipient_id: str, channel: str = "",
+                                          access_token: str = ""):
+    params = compact_dict({"recipient_id": recipient_id, "channel": channel})
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.put(
+        '/recipients/setPreferredChannel',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
 async def db_get_recipient_draft(draft_id: str, pgsql) -> typing.Optional[tuple]:
     cursor = pgsql[DB_NAME].cursor()
     cursor.execute(
@@ -278,6 +299,17 @@ async def delete_template(service_client, template_id: str, access_token: str =
     return response
 
 
+async def set_template_attachment(service_client, template_id: str, file_name: str = "", access_token: str = ""):
+    params = compact_dict({"template_id": template_id, "file_name": file_name})
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.put(
+        '/templates/setAttachment',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
 async def db_get_template_draft(draft_id: str, pgsql) -> typing.Optional[tuple]:
     cursor = pgsql[DB_NAME].cursor()
     cursor.execute(
@@ -452,6 +484,18 @@ async def delete_group(service_client, group_id: str, access_token: str = ""):
     return response
 
 
+async def set_group_telegram_channel(service_client, group_id: str, channel_id: typing.Union[int, str] = "",
+                                     access_token: str = ""):
+    params = compact_dict({"group_id": group_id, "channel_id": channel_id})
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.put(
+        '/groups/setTelegramChannel',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
 async def db_get_group_draft(draft_id: str, pgsql) -> typing.Optional[tuple]:
     cursor = pgsql[DB_NAME].cursor()
     cursor.execute(
@@ -512,3 +556,191 @@ async def db_get_groups(rows_num: int, pgsql) -> typing.List[tuple]:
     )
     records = cursor.fetchmany(rows_num)
     return records
+
+
+async def create_recipient_group(service_client, recipients: typing.List[dict], template_name: str = "Evacuation",
+                                 message_text: str = "Leave the building",
+                                 user_name: str = "test_user_1") -> typing.Tuple[str, typing.List[str]]:
+    """Creates a user with a template and an active group of the recipients.
+    Recipients are described by email, phone_number, telegram_id and preferred_channel keys"""
+    access_token = (await create_user(user_name, "1234", service_client)).json()["access_token"]
+    template_draft_id = (await create_template(service_client, template_name, message_text,
+                                               access_token)).json()["draft_id"]
+    template_id = (await templates_confirm_creation(service_client, template_draft_id, access_token)).json()[
+        "notification_template_id"]
+    group_draft_id = (await create_group(service_client, "test_group_1", True, template_id,
+                                         access_token)).json()["draft_id"]
+    group_id = (await groups_confirm_creation(service_client, group_draft_id, access_token)).json()[
+        "recipient_group_id"]
+    recipient_ids = []
+    for i, recipient in enumerate(recipients):
+        recipient_draft_id = (await create_recipient(service_client, f"test_recipient_{i}",
+                                                     recipient.get("email", ""),
+                                                     recipient.get("phone_number", ""),
+                                                     recipient.get("telegram_id", ""),
+                                                     access_token)).json()["draft_id"]
+        recipient_id = (await recipients_confirm_creation(service_client, recipient_draft_id,
+                                                          access_token)).json()["recipient_id"]
+        if "preferred_channel" in recipient:
+            await set_recipient_preferred_channel(service_client, recipient_id, recipient["preferred_channel"],
+                                                  access_token)
+        await add_recipient_to_group(service_client, group_id, recipient_id, access_token)
+        recipient_ids.append(recipient_id)
+    return access_token, recipient_ids
+
+
+async def push_telegram_update(service_client, update: dict, secret_token: str = ""):
+    headers = compact_dict({"X-Telegram-Bot-Api-Secret-Token": secret_token})
+    response = await service_client.post(
+        '/telegram/webhook',
+        data=json.dumps(update),
+        headers=headers,
+    )
+    return response
+
+
+async def db_add_telegram_contacts(telegram_ids: typing.List[int], pgsql) -> None:
+    cursor = pgsql[DB_NAME].cursor()
+    for telegram_id in telegram_ids:
+        cursor.execute(
+            "INSERT INTO ens_schema.telegram_contact "
+            "(user_id, active) "
+            "VALUES (%s, true)", (telegram_id,),
+        )
+
+
+async def db_get_telegram_contacts(pgsql) -> typing.List[tuple]:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "SELECT user_id, active "
+        "FROM ens_schema.telegram_contact "
+        "ORDER BY user_id"
+    )
+    return cursor.fetchall()
+
+
+async def db_get_notification_responses(batch_id: str, pgsql) -> typing.List[tuple]:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "SELECT notification_id, status, telegram_id "
+        "FROM ens_schema.notification_response "
+        "WHERE batch_id = %s", (batch_id,),
+    )
+    return cursor.fetchall()
+
+
+async def create_batch(service_client, access_token: str = "", priority: str = ""):
+    params = compact_dict({"priority": priority})
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.post(
+        '/notifications/createBatch',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+async def schedule_batch(service_client, batch_id: str, scheduled_at: str = "", access_token: str = ""):
+    params = compact_dict({"batch_id": batch_id, "scheduled_at": scheduled_at})
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.put(
+        '/notifications/scheduleBatch',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+async def db_get_batch(batch_id: str, pgsql) -> typing.Optional[tuple]:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "SELECT * "
+        "FROM ens_schema.notifications_batch "
+        "WHERE batch_id = %s", (batch_id,),
+    )
+    record = cursor.fetchone()
+    return record
+
+
+async def send_batch(service_client, batch_id: str, access_token: str = ""):
+    params = {"batch_id": batch_id}
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.put(
+        '/notifications/sendBatch',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+async def db_get_batch_notifications(batch_id: str, rows_num: int, pgsql) -> typing.List[tuple]:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "SELECT * "
+        "FROM ens_schema.notification "
+        "WHERE batch_id = %s", (batch_id,),
+    )
+    records = cursor.fetchmany(rows_num)
+    return records
+
+
+async def get_batch_responses(service_client, batch_id: str, access_token: str = ""):
+    params = {"batch_id": batch_id}
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.get(
+        '/notifications/batchResponses',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+async def db_set_batch_response_tally(batch_id: str, status: str, responses: int, pgsql) -> None:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "INSERT INTO ens_schema.batch_response_tally "
+        "(batch_id, status, responses) "
+        "VALUES (%s, %s, %s)", (batch_id, status, responses),
+    )
+
+
+async def get_batch_progress(service_client, batch_id: str, access_token: str = ""):
+    params = {"batch_id": batch_id}
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.get(
+        '/notifications/batchProgress',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+def parse_progress_events(body: str) -> typing.List[dict]:
+    events = []
+    for message in body.split("\n\n"):
+        lines = message.split("\n")
+        if "event: progress" in lines:
+            data = next(line for line in lines if line.startswith("data: "))
+            events.append(json.loads(data[len("data: "):]))
+    return events
+
+
+async def get_batch_summary(service_client, batch_id: str, access_token: str = ""):
+    params = {"batch_id": batch_id}
+    headers = compact_dict({"Authorization": access_token})
+    response = await service_client.get(
+        '/notifications/batchSummary',
+        params=params,
+        headers=headers,
+    )
+    return response
+
+
+async def db_set_batch_counters(batch_id: str, targeted: int, sent: int, failed: int, responded: int,
+                                finished: bool, pgsql) -> None:
+    cursor = pgsql[DB_NAME].cursor()
+    cursor.execute(
+        "INSERT INTO ens_schema.batch_counters "
+        "(batch_id, targeted, sent, failed, responded, finished) "
+        "VALUES (%s, %s, %s, %s, %s, %s)", (batch_id, targeted, sent, failed, responded, finished),
+    )
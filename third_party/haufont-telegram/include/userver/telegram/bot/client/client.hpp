@@ -1,5 +1,6 @@
 #pragma once
 
+#include <userver/telegram/bot/requests/answer_callback_query.hpp>
 #include <userver/telegram/bot/requests/close.hpp>
 #include <userver/telegram/bot/requests/copy_message.hpp>
 #include <userver/telegram/bot/requests/forward_message.hpp>
@@ -33,6 +34,10 @@ class Client {
  public:
   ~Client() = default;
 
+  virtual AnswerCallbackQueryRequest AnswerCallbackQuery(
+      const AnswerCallbackQueryMethod::Parameters& parameters,
+      const RequestOptions& request_options) = 0;
+
   virtual CloseRequest Close(const RequestOptions& request_options) = 0;
 
   virtual CopyMessageRequest CopyMessage(
@@ -6,6 +6,10 @@
 #include "userver/components/loggable_component_base.hpp"
 #include "userver/utils/strong_typedef.hpp"
 #include "userver/formats/json.hpp"
+#include "userver/utils/assert.hpp"
+
+#include <string>
+#include <vector>
 
 USERVER_NAMESPACE_BEGIN
 
@@ -14,9 +18,28 @@ namespace telegram::bot {
 class BotSecdistConfig {
  public:
   using BotToken = userver::utils::NonLoggable<class BotTokenTag, std::string>;
+  /// Tokens of all the bots of the pool, `bot_tokens` if present,
+  /// otherwise the single `bot_token`
+  const std::vector<std::string> bot_tokens_;
   const std::string bot_token_;
   BotSecdistConfig(const userver::formats::json::Value &val)
-      : bot_token_(val["bot_token"].As<BotToken>()) {}
+      : bot_tokens_(ParseBotTokens(val)),
+        bot_token_(bot_tokens_.front()) {}
+
+ private:
+  static std::vector<std::string> ParseBotTokens(
+      const userver::formats::json::Value &val) {
+    std::vector<std::string> tokens;
+    if (val.HasMember("bot_tokens")) {
+      for (const auto& token : val["bot_tokens"]) {
+        tokens.push_back(token.As<BotToken>());
+      }
+    } else {
+      tokens.push_back(val["bot_token"].As<BotToken>());
+    }
+    UINVARIANT(!tokens.empty(), "At least one bot token is required");
+    return tokens;
+  }
 };
 
 class TelegramBotClient : public components::LoggableComponentBase {
@@ -28,11 +51,15 @@ public:
 
   static yaml_config::Schema GetStaticConfigSchema();
 
+  /// @brief Client of the first bot of the pool.
   ClientPtr GetClient();
 
+  /// @brief Clients of all the bots of the pool, one per bot token.
+  const std::vector<ClientPtr>& GetClients();
+
 private:
   BotSecdistConfig secdist_config_;
-  ClientPtr client_;
+  std::vector<ClientPtr> clients_;
 };
 
 }  // namespace telegram::bot
@@ -1,12 +1,18 @@
 #pragma once
 
 #include <userver/telegram/bot/client/client_fwd.hpp>
+#include <userver/telegram/bot/requests/get_updates.hpp>
 #include <userver/telegram/bot/types/update.hpp>
 
 #include "userver/components/component.hpp"
 #include "userver/components/loggable_component_base.hpp"
-#include "userver/concurrent/background_task_storage.hpp"
-#include "userver/utils/periodic_task.hpp"
+#include "userver/engine/semaphore.hpp"
+#include "userver/engine/task/task_with_result.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 USERVER_NAMESPACE_BEGIN
 
@@ -16,6 +22,13 @@ class TelegramBotLongPoller : public components::LoggableComponentBase {
 public:
   static constexpr std::string_view kName = "telegram-bot-long-poller";
 
+  enum class UpdateMode {
+    /// Updates are received with getUpdates requests
+    kLongPolling,
+    /// Updates are pushed to the service by Telegram
+    kWebhook
+  };
+
   TelegramBotLongPoller(const components::ComponentConfig& config,
                         const components::ComponentContext& context);
 
@@ -29,21 +42,70 @@ public:
 
   ClientPtr GetClient();
 
+  /// @brief Clients of all the bots of the pool, updates of every bot are
+  /// received and passed to HandleUpdate with the client of that bot.
+  const std::vector<ClientPtr>& GetClients() const;
+
+  /// @brief Offset following the last update of the bot whose handling
+  /// has finished.
+  std::int64_t GetCommittedOffset(std::size_t bot_index = 0) const;
+
+  UpdateMode GetUpdateMode() const;
+
+  /// @brief Handles an update pushed to the bot in the calling task.
+  /// @returns false without handling the update if all handler slots
+  /// are busy.
+  /// @note Shares max-concurrent-updates handler slots with long polling.
+  bool TryHandlePushedUpdate(Update update, std::size_t bot_index = 0);
+
+protected:
+  /// @brief Whether this instance may poll the updates of the bot now.
+  /// Checked before every getUpdates request and every polling-frequency
+  /// while one is in flight, instances sharing the bot tokens override it
+  /// to elect a single poller per bot.
+  virtual bool IsPollingAllowed(std::size_t bot_index);
+
+  /// @brief Offset polling of the bot starts from, called whenever polling
+  /// (re)starts after it has been disallowed.
+  virtual std::int64_t LoadOffset(std::size_t bot_index);
+
+  /// @brief Called once all updates before the offset are handled.
+  virtual void CommitOffset(std::size_t bot_index, std::int64_t offset);
+
 private:
-  void FetchAndHandleUpdates();
+  struct PollingState {
+    std::size_t bot_index = 0;
 
-  std::vector<Update> FetchUpdates();
+    ClientPtr client;
 
-  ClientPtr client_;
+    /// Offset following the last received update, advanced as soon as
+    /// updates are received. getUpdates requests are sent with it, updates
+    /// below it that are received again are dropped as duplicates.
+    std::int64_t fetch_offset = 0;
 
-  std::int64_t offset_ = 0;
+    /// Offset advanced only after all updates of a batch are handled and
+    /// passed to CommitOffset, polling restarts from it.
+    std::atomic<std::int64_t> committed_offset = 0;
+
+    engine::TaskWithResult<void> polling_task;
+  };
+
+  void PollUpdates(PollingState& state);
+
+  RequestFuture<GetUpdatesMethod> StartFetchUpdates(PollingState& state);
+
+  void HandleUpdates(std::vector<Update> updates, const ClientPtr& client);
+
+  const std::vector<ClientPtr> clients_;
+
+  std::vector<std::unique_ptr<PollingState>> polling_states_;
+
+  const UpdateMode update_mode_;
 
   const std::chrono::milliseconds polling_frequency_;
   const std::chrono::milliseconds polling_timeout_;
 
-  utils::PeriodicTask periodic_;
-
-  concurrent::BackgroundTaskStorage task_storage_;
+  engine::Semaphore handlers_semaphore_;
 };
 
 }  // namespace telegram::bot
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "userver/clients/http/response.hpp"
+
+USERVER_NAMESPACE_BEGIN
+
+namespace telegram::bot {
+
+/// @brief Lightweight reply of a send method.
+/// @note Only the delivery acknowledgement fields are extracted from the
+/// response body, the rest of the reply (the sent Message tree) is skipped
+/// without being materialized.
+struct AckReply {
+  /// @brief True if the request was successful.
+  bool ok = false;
+
+  /// @brief Error code, set if the request was unsuccessful.
+  std::optional<int> error_code;
+
+  /// @brief Human-readable description of the result.
+  std::optional<std::string> description;
+
+  /// @brief In case of exceeding flood control, the number of seconds left
+  /// to wait before the request can be repeated.
+  std::optional<std::chrono::seconds> retry_after;
+
+  /// @brief The group has been migrated to a supergroup with the specified
+  /// identifier.
+  std::optional<std::int64_t> migrate_to_chat_id;
+
+  /// @brief Unique message identifier of the sent message.
+  std::optional<std::int64_t> message_id;
+
+  /// @brief Identifier of the file attached to the sent message, which can
+  /// be used to send the same file again without uploading it.
+  /// @note The largest size is taken for photos.
+  std::optional<std::string> file_id;
+};
+
+/// @brief Extracts AckReply fields from a raw Bot API response body.
+/// @throws formats::json::ParseException if the body is not a JSON object.
+AckReply ParseAckReply(std::string_view body);
+
+/// @brief Extracts AckReply fields from the Bot API response.
+/// @note Unlike ParseResponseDataFromJson, an unsuccessful reply is returned
+/// to the caller instead of being thrown.
+AckReply ParseAckReply(const clients::http::Response& response);
+
+}  // namespace telegram::bot
+
+USERVER_NAMESPACE_END
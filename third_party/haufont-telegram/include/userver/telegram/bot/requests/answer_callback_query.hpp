@@ -0,0 +1,68 @@
+#pragma once
+
+#include <userver/telegram/bot/requests/request.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "userver/formats/json_fwd.hpp"
+
+USERVER_NAMESPACE_BEGIN
+
+namespace telegram::bot {
+
+/// @brief Use this method to send answers to callback queries sent from
+/// inline keyboards. The answer will be displayed to the user as
+/// a notification at the top of the chat screen or as an alert.
+/// @see https://core.telegram.org/bots/api#answercallbackquery
+struct AnswerCallbackQueryMethod {
+  static constexpr std::string_view kName = "answerCallbackQuery";
+
+  static constexpr auto kHttpMethod = clients::http::HttpMethod::kPost;
+
+  struct Parameters{
+    Parameters(std::string _callback_query_id);
+
+    /// @brief Unique identifier for the query to be answered.
+    std::string callback_query_id;
+
+    /// @brief Text of the notification.
+    /// @note If not specified, nothing will be shown to the user,
+    /// 0-200 characters.
+    std::optional<std::string> text;
+
+    /// @brief If True, an alert will be shown by the client instead of
+    /// a notification at the top of the chat screen.
+    std::optional<bool> show_alert;
+
+    /// @brief URL that will be opened by the user's client.
+    std::optional<std::string> url;
+
+    /// @brief The maximum amount of time in seconds that the result of
+    /// the callback query may be cached client-side.
+    std::optional<std::int64_t> cache_time;
+  };
+
+  /// @brief On success, True is returned.
+  using Reply = bool;
+
+  static void FillRequestData(clients::http::Request& request,
+                              const Parameters& parameters);
+
+  static Reply ParseResponseData(clients::http::Response& response);
+};
+
+AnswerCallbackQueryMethod::Parameters Parse(
+    const formats::json::Value& json,
+    formats::parse::To<AnswerCallbackQueryMethod::Parameters>);
+
+formats::json::Value Serialize(
+    const AnswerCallbackQueryMethod::Parameters& parameters,
+    formats::serialize::To<formats::json::Value>);
+
+using AnswerCallbackQueryRequest = Request<AnswerCallbackQueryMethod>;
+
+}  // namespace telegram::bot
+
+USERVER_NAMESPACE_END
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <userver/telegram/bot/requests/ack_reply.hpp>
 #include <userver/telegram/bot/utils/token.hpp>
 
 #include "userver/clients/http/request.hpp"
+#include "userver/clients/http/response_future.hpp"
 
 USERVER_NAMESPACE_BEGIN
 
@@ -17,6 +19,44 @@ struct RequestOptions {
   size_t retries = 2;
 };
 
+/// @brief Handle of a request started by Request::PerformAsync.
+/// @note Destroying the handle before the reply is received cancels the
+/// request.
+template <typename method>
+class [[nodiscard]] RequestFuture {
+ public:
+  using Method = method;
+
+  explicit RequestFuture(clients::http::ResponseFuture&& response_future)
+      : response_future_(std::move(response_future)) {}
+
+  /// @brief Waits for the reply and parses it into Method::Reply.
+  typename Method::Reply Get() {
+    auto response = response_future_.Get();
+    return Method::ParseResponseData(*response);
+  }
+
+  /// @brief Waits for the reply and extracts only the delivery
+  /// acknowledgement fields.
+  AckReply GetAck() {
+    auto response = response_future_.Get();
+    return ParseAckReply(*response);
+  }
+
+  /// @brief Waits for the reply without parsing it.
+  std::future_status Wait() { return response_future_.Wait(); }
+
+  void Cancel() { response_future_.Cancel(); }
+
+  /// @brief Allows waiting on several handles with engine::WaitAny.
+  engine::impl::ContextAccessor* TryGetContextAccessor() {
+    return response_future_.TryGetContextAccessor();
+  }
+
+ private:
+  clients::http::ResponseFuture response_future_;
+};
+
 template <typename method>
 class [[nodiscard]] Request {
  public:
@@ -38,6 +78,20 @@ class [[nodiscard]] Request {
     return Method::ParseResponseData(*response);
   }
 
+  /// @brief Performs the request, extracting only the delivery
+  /// acknowledgement fields instead of the full Method::Reply.
+  /// @note Use for send methods whose reply is not needed by the caller.
+  AckReply PerformAck() {
+    auto response = http_request_.perform();
+    return ParseAckReply(*response);
+  }
+
+  /// @brief Starts the request without waiting for the reply, so that a
+  /// single coroutine can keep many requests in flight.
+  RequestFuture<Method> PerformAsync() {
+    return RequestFuture<Method>{http_request_.async_perform()};
+  }
+
  private:
   void SetRequestOptions(const RequestOptions& request_options) {
     http_request_.timeout(request_options.timeout)
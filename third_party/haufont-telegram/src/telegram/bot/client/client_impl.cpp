@@ -15,6 +15,12 @@ ClientImpl::ClientImpl(clients::http::Client& http_client,
       api_base_url_(std::move(api_base_url)),
       file_base_url_(std::move(file_base_url)) {}
 
+AnswerCallbackQueryRequest ClientImpl::AnswerCallbackQuery(
+    const AnswerCallbackQueryMethod::Parameters& parameters,
+    const RequestOptions& request_options) {
+  return FormRequest<AnswerCallbackQueryRequest>(parameters, request_options);
+}
+
 CloseRequest ClientImpl::Close(const RequestOptions& request_options) {
   return FormRequest<CloseRequest>(CloseMethod::Parameters{}, request_options);
 }
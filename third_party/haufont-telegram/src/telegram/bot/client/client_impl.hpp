@@ -15,6 +15,10 @@ public:
              std::string api_base_url,
              std::string file_base_url);
 
+  AnswerCallbackQueryRequest AnswerCallbackQuery(
+      const AnswerCallbackQueryMethod::Parameters& parameters,
+      const RequestOptions& request_options) override;
+
   CloseRequest Close(const RequestOptions& request_options) override;
 
   CopyMessageRequest CopyMessage(
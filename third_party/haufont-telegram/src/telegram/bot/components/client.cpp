@@ -14,16 +14,21 @@ namespace {
 
 constexpr std::string_view kDefaultApiBaseUrl = "https://api.telegram.org";
 
-ClientPtr MakeClient(clients::http::Client& httpClient,
-                     const components::ComponentConfig& config,
-                     const BotSecdistConfig& secdist_config) {
+std::vector<ClientPtr> MakeClients(clients::http::Client& httpClient,
+                                   const components::ComponentConfig& config,
+                                   const BotSecdistConfig& secdist_config) {
   auto apiBaseURL = config["api-base-url"].As<std::string>(kDefaultApiBaseUrl);
   auto fileBaseUrl = config["file-base-url"].As<std::string>(apiBaseURL);
 
-  return std::make_shared<ClientImpl>(httpClient,
-                                      secdist_config.bot_token_,
-                                      std::move(apiBaseURL),
-                                      std::move(fileBaseUrl));
+  std::vector<ClientPtr> clients;
+  clients.reserve(secdist_config.bot_tokens_.size());
+  for (const std::string& bot_token : secdist_config.bot_tokens_) {
+    clients.push_back(std::make_shared<ClientImpl>(httpClient,
+                                                   bot_token,
+                                                   apiBaseURL,
+                                                   fileBaseUrl));
+  }
+  return clients;
 }
 
 }  // namespace
@@ -35,13 +40,17 @@ TelegramBotClient::TelegramBotClient(
       secdist_config_(
           context.FindComponent<userver::components::Secdist>().Get().Get<BotSecdistConfig>()
       ),
-      client_(MakeClient(
+      clients_(MakeClients(
         context.FindComponent<components::HttpClient>().GetHttpClient(),
         config,
         secdist_config_)){}
 
 ClientPtr TelegramBotClient::GetClient() {
-    return client_;
+    return clients_.front();
+}
+
+const std::vector<ClientPtr>& TelegramBotClient::GetClients() {
+    return clients_;
 }
 
 yaml_config::Schema TelegramBotClient::GetStaticConfigSchema() {
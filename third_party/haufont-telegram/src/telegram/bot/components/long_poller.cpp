@@ -3,6 +3,15 @@
 #include <userver/telegram/bot/client/client.hpp>
 #include <userver/telegram/bot/components/client.hpp>
 
+#include <algorithm>
+#include <optional>
+
+#include "userver/engine/deadline.hpp"
+#include "userver/engine/sleep.hpp"
+#include "userver/engine/task/cancel.hpp"
+#include "userver/engine/wait_any.hpp"
+#include "userver/utils/assert.hpp"
+#include "userver/utils/async.hpp"
 #include "userver/yaml_config/merge_schemas.hpp"
 
 USERVER_NAMESPACE_BEGIN
@@ -12,34 +21,68 @@ constexpr std::chrono::milliseconds kDefaultPollingFrequency =
     std::chrono::seconds{1};
 constexpr std::chrono::milliseconds kDefaultPollingTimeout =
     std::chrono::minutes{10};
+constexpr std::size_t kDefaultMaxConcurrentUpdates = 64;
 }  // namespace
 
 namespace telegram::bot {
 
+namespace {
+
+TelegramBotLongPoller::UpdateMode ParseUpdateMode(const std::string& mode) {
+  if (mode == "webhook") {
+    return TelegramBotLongPoller::UpdateMode::kWebhook;
+  }
+  UINVARIANT(mode == "long-polling",
+             fmt::format("Unknown update-mode: {}", mode));
+  return TelegramBotLongPoller::UpdateMode::kLongPolling;
+}
+
+}  // namespace
+
 TelegramBotLongPoller::TelegramBotLongPoller(
     const components::ComponentConfig& config,
     const components::ComponentContext& context)
     : components::LoggableComponentBase(config, context)
-    , client_(context.FindComponent<TelegramBotClient>()
-                .GetClient())
+    , clients_(context.FindComponent<TelegramBotClient>()
+                .GetClients())
+    , update_mode_(ParseUpdateMode(
+          config["update-mode"].As<std::string>("long-polling")))
     , polling_frequency_(
           config["polling-frequency"].As<std::chrono::milliseconds>(
             kDefaultPollingFrequency))
     , polling_timeout_(
         config["polling-timeout"].As<std::chrono::milliseconds>(
-            kDefaultPollingTimeout)) {}
+            kDefaultPollingTimeout))
+    , handlers_semaphore_(
+        config["max-concurrent-updates"].As<std::size_t>(
+            kDefaultMaxConcurrentUpdates)) {
+  for (std::size_t i = 0; i < clients_.size(); ++i) {
+    auto state = std::make_unique<PollingState>();
+    state->bot_index = i;
+    state->client = clients_[i];
+    polling_states_.push_back(std::move(state));
+  }
+}
 
 void TelegramBotLongPoller::OnAllComponentsLoaded() {
-  periodic_.Start(
-    fmt::format("{}/long_polling_periodic_task", kName),
-    {polling_frequency_},
-    [this] { FetchAndHandleUpdates(); }
-  );
+  if (update_mode_ != UpdateMode::kLongPolling) {
+    return;
+  }
+  for (std::size_t i = 0; i < polling_states_.size(); ++i) {
+    PollingState& state = *polling_states_[i];
+    state.polling_task = utils::Async(
+      fmt::format("{}/long_polling_task/{}", kName, i),
+      [this, &state] { PollUpdates(state); }
+    );
+  }
 }
 
 void TelegramBotLongPoller::OnAllComponentsAreStopping() {
-  periodic_.Stop();
-  task_storage_.CancelAndWait();
+  for (auto& state : polling_states_) {
+    if (state->polling_task.IsValid()) {
+      state->polling_task.SyncCancel();
+    }
+  }
 }
 
 yaml_config::Schema TelegramBotLongPoller::GetStaticConfigSchema() {
@@ -48,53 +91,190 @@ type: object
 description: Component that provides updates via long polling
 additionalProperties: false
 properties:
+    update-mode:
+        type: string
+        description: How updates are received, either by long polling or
+                     pushed to the service by a webhook
+        defaultDescription: long-polling
+        enum:
+          - long-polling
+          - webhook
     polling-frequency:
         type: string
-        description: The frequency with which updates from telegram will
-                     be polled
+        description: Delay before polling again after a failed attempt to
+                     receive updates, also the period whether polling is
+                     still allowed is checked while a request is in flight
         defaultDescription: 1s
     polling-timeout:
         type: string
         description: Timeout in seconds for long polling
         defaultDescription: 60s
+    max-concurrent-updates:
+        type: integer
+        description: Maximum number of updates handled at the same time.
+                     Receiving of new updates is suspended until a handler
+                     slot is released
+        defaultDescription: 64
+        minimum: 1
 )");
 }
 
 ClientPtr TelegramBotLongPoller::GetClient() {
-  return client_;
+  return clients_.front();
 }
 
-void TelegramBotLongPoller::FetchAndHandleUpdates() {
-  std::vector<Update> updates;
-  try {
-    updates = FetchUpdates();
-  } catch (std::exception& ex) {
-    LOG_ERROR() << "Error receiving updates: " << ex.what();
-    return;
+const std::vector<ClientPtr>& TelegramBotLongPoller::GetClients() const {
+  return clients_;
+}
+
+std::int64_t TelegramBotLongPoller::GetCommittedOffset(
+    std::size_t bot_index) const {
+  return polling_states_.at(bot_index)->committed_offset.load();
+}
+
+TelegramBotLongPoller::UpdateMode TelegramBotLongPoller::GetUpdateMode() const {
+  return update_mode_;
+}
+
+bool TelegramBotLongPoller::TryHandlePushedUpdate(Update update,
+                                                  std::size_t bot_index) {
+  const ClientPtr& client = clients_.at(bot_index);
+  engine::SemaphoreLock lock{handlers_semaphore_, std::defer_lock};
+  if (!lock.TryLock()) {
+    return false;
   }
-  for (Update& update : updates) {
-    std::int64_t update_id = update.update_id;
-    std::string task_name = fmt::format("{}/handle_update/{}",
-                                        kName, update_id);
-    auto handle_update = [this] (Update update) {
-      HandleUpdate(std::move(update), client_);
-    };
-    task_storage_.AsyncDetach(std::move(task_name),
-                              handle_update, std::move(update));
-    offset_ = std::max(offset_, update_id + 1);
+  HandleUpdate(std::move(update), client);
+  return true;
+}
+
+bool TelegramBotLongPoller::IsPollingAllowed(std::size_t) {
+  return true;
+}
+
+std::int64_t TelegramBotLongPoller::LoadOffset(std::size_t bot_index) {
+  return polling_states_.at(bot_index)->fetch_offset;
+}
+
+void TelegramBotLongPoller::CommitOffset(std::size_t, std::int64_t) {}
+
+void TelegramBotLongPoller::PollUpdates(PollingState& state) {
+  std::optional<RequestFuture<GetUpdatesMethod>> pending_fetch;
+  bool offset_loaded = false;
+  while (!engine::current_task::ShouldCancel()) {
+    if (!IsPollingAllowed(state.bot_index)) {
+      // Updates are polled by another instance, the request in flight
+      // is abandoned and the offset is loaded again once polling resumes
+      pending_fetch.reset();
+      offset_loaded = false;
+      engine::InterruptibleSleepFor(polling_frequency_);
+      continue;
+    }
+    if (!offset_loaded) {
+      try {
+        state.fetch_offset = LoadOffset(state.bot_index);
+      } catch (std::exception& ex) {
+        LOG_ERROR() << "Error loading updates offset: " << ex.what();
+        engine::InterruptibleSleepFor(polling_frequency_);
+        continue;
+      }
+      state.committed_offset = state.fetch_offset;
+      offset_loaded = true;
+    }
+    if (!pending_fetch) {
+      pending_fetch = StartFetchUpdates(state);
+    }
+    // The long poll is awaited in slices, so that a poller which is no
+    // longer allowed to poll doesn't keep it open
+    if (!engine::WaitAnyUntil(
+             engine::Deadline::FromDuration(polling_frequency_),
+             *pending_fetch)) {
+      continue;
+    }
+    std::vector<Update> updates;
+    try {
+      updates = pending_fetch->Get();
+    } catch (std::exception& ex) {
+      pending_fetch.reset();
+      if (engine::current_task::ShouldCancel()) {
+        return;
+      }
+      LOG_ERROR() << "Error receiving updates: " << ex.what();
+      engine::InterruptibleSleepFor(polling_frequency_);
+      continue;
+    }
+    pending_fetch.reset();
+    // Updates below the offset are received again when polling restarts
+    // from a committed offset older than the last fetched one
+    updates.erase(std::remove_if(updates.begin(), updates.end(),
+                                 [&state](const Update& update) {
+                                   return update.update_id < state.fetch_offset;
+                                 }),
+                  updates.end());
+    if (updates.empty()) {
+      continue;
+    }
+    for (const Update& update : updates) {
+      state.fetch_offset = std::max(state.fetch_offset, update.update_id + 1);
+    }
+    const std::int64_t batch_offset = state.fetch_offset;
+    // The next request is sent while the batch is being handled and asks
+    // for the updates following it, so that the batch isn't fetched twice.
+    // Telegram forgets the batch then, a restart resumes polling from the
+    // offset committed once the batch is handled
+    if (IsPollingAllowed(state.bot_index)) {
+      pending_fetch = StartFetchUpdates(state);
+    }
+    HandleUpdates(std::move(updates), state.client);
+    state.committed_offset = batch_offset;
+    try {
+      CommitOffset(state.bot_index, batch_offset);
+    } catch (std::exception& ex) {
+      LOG_ERROR() << "Error committing updates offset: " << ex.what();
+    }
   }
 }
 
-std::vector<Update> TelegramBotLongPoller::FetchUpdates() {
+RequestFuture<GetUpdatesMethod> TelegramBotLongPoller::StartFetchUpdates(
+    PollingState& state) {
   GetUpdatesMethod::Parameters parameters;
-  parameters.offset = offset_;
+  parameters.offset = state.fetch_offset;
   parameters.limit = 100;
   parameters.timeout =
       std::chrono::duration_cast<std::chrono::seconds>(polling_timeout_);
   RequestOptions request_options;
   request_options.timeout = polling_timeout_ + std::chrono::seconds{1};
   request_options.retries = 1;
-  return client_->GetUpdates(parameters, request_options).Perform();
+  return state.client->GetUpdates(parameters, request_options).PerformAsync();
+}
+
+void TelegramBotLongPoller::HandleUpdates(std::vector<Update> updates,
+                                          const ClientPtr& client) {
+  std::vector<engine::TaskWithResult<void>> handlers;
+  handlers.reserve(updates.size());
+  for (Update& update : updates) {
+    // Blocks until one of the running handlers finishes
+    engine::SemaphoreLock lock{handlers_semaphore_};
+    if (!lock) {
+      break;
+    }
+    std::string task_name = fmt::format("{}/handle_update/{}",
+                                        kName, update.update_id);
+    handlers.push_back(utils::Async(
+      std::move(task_name),
+      [this, client, lock = std::move(lock)] (Update update) {
+        const std::int64_t update_id = update.update_id;
+        try {
+          HandleUpdate(std::move(update), client);
+        } catch (std::exception& ex) {
+          LOG_ERROR() << "Error handling update " << update_id
+                      << ": " << ex.what();
+        }
+      },
+      std::move(update)));
+  }
+  for (auto& handler : handlers) {
+    handler.Wait();
+  }
 }
 
 }  // namespace telegram::bot
@@ -0,0 +1,330 @@
+#include <userver/telegram/bot/requests/ack_reply.hpp>
+
+#include <charconv>
+
+#include <fmt/format.h>
+
+#include "userver/formats/json/exception.hpp"
+
+USERVER_NAMESPACE_BEGIN
+
+namespace telegram::bot {
+
+namespace {
+
+/// @brief On-demand scanner over a Bot API reply.
+/// Only the requested members are decoded, everything else is skipped
+/// in place without building a DOM.
+class AckScanner {
+ public:
+  explicit AckScanner(std::string_view body) : body_(body) {}
+
+  AckReply Scan() {
+    AckReply reply;
+    ForEachMember([this, &reply](std::string_view key) {
+      if (key == "ok") {
+        reply.ok = ReadBool();
+      } else if (key == "error_code") {
+        if (!ConsumeNull()) {
+          reply.error_code = static_cast<int>(ReadInteger());
+        }
+      } else if (key == "description") {
+        if (!ConsumeNull()) {
+          reply.description = ReadString();
+        }
+      } else if (key == "parameters" && Peek() == '{') {
+        ForEachMember([this, &reply](std::string_view key) {
+          if (ConsumeNull()) {
+            return;
+          }
+          if (key == "retry_after") {
+            reply.retry_after = std::chrono::seconds{ReadInteger()};
+          } else if (key == "migrate_to_chat_id") {
+            reply.migrate_to_chat_id = ReadInteger();
+          } else {
+            SkipValue();
+          }
+        });
+      } else if (key == "result" && Peek() == '{') {
+        ForEachMember([this, &reply](std::string_view key) {
+          if (ConsumeNull()) {
+            return;
+          }
+          if (key == "message_id") {
+            reply.message_id = ReadInteger();
+          } else if (key == "photo" && Peek() == '[') {
+            // Sizes are listed in ascending order, the last one is the largest
+            ForEachElement([this, &reply] { ScanFileId(reply); });
+          } else if (IsFileKey(key) && Peek() == '{') {
+            ScanFileId(reply);
+          } else {
+            SkipValue();
+          }
+        });
+      } else {
+        SkipValue();
+      }
+    });
+    return reply;
+  }
+
+ private:
+  template <typename OnMember>
+  void ForEachMember(OnMember&& on_member) {
+    Expect('{');
+    if (Consume('}')) {
+      return;
+    }
+    while (true) {
+      const std::string_view key = ReadRawString();
+      Expect(':');
+      SkipWhitespace();
+      on_member(key);
+      if (Consume(',')) {
+        continue;
+      }
+      Expect('}');
+      return;
+    }
+  }
+
+  template <typename OnElement>
+  void ForEachElement(OnElement&& on_element) {
+    Expect('[');
+    if (Consume(']')) {
+      return;
+    }
+    while (true) {
+      SkipWhitespace();
+      on_element();
+      if (Consume(',')) {
+        continue;
+      }
+      Expect(']');
+      return;
+    }
+  }
+
+  void SkipArray() {
+    ForEachElement([this] { SkipValue(); });
+  }
+
+  static bool IsFileKey(std::string_view key) {
+    return key == "document" || key == "animation" || key == "audio" ||
+           key == "video" || key == "video_note" || key == "voice";
+  }
+
+  void ScanFileId(AckReply& reply) {
+    if (Peek() != '{') {
+      SkipValue();
+      return;
+    }
+    ForEachMember([this, &reply](std::string_view key) {
+      if (key == "file_id" && Peek() == '"') {
+        reply.file_id = ReadString();
+      } else {
+        SkipValue();
+      }
+    });
+  }
+
+  void SkipValue() {
+    switch (Peek()) {
+      case '"':
+        ReadRawString();
+        return;
+      case '{':
+        ForEachMember([this](std::string_view) { SkipValue(); });
+        return;
+      case '[':
+        SkipArray();
+        return;
+      default:
+        SkipScalar();
+        return;
+    }
+  }
+
+  void SkipScalar() {
+    const size_t begin = pos_;
+    while (pos_ < body_.size() && !IsDelimiter(body_[pos_])) {
+      ++pos_;
+    }
+    if (pos_ == begin) {
+      Fail("value expected");
+    }
+  }
+
+  bool ConsumeNull() {
+    SkipWhitespace();
+    if (body_.substr(pos_, 4) == "null") {
+      pos_ += 4;
+      return true;
+    }
+    return false;
+  }
+
+  bool ReadBool() {
+    SkipWhitespace();
+    if (body_.substr(pos_, 4) == "true") {
+      pos_ += 4;
+      return true;
+    }
+    if (body_.substr(pos_, 5) == "false") {
+      pos_ += 5;
+      return false;
+    }
+    Fail("boolean expected");
+  }
+
+  std::int64_t ReadInteger() {
+    SkipWhitespace();
+    std::int64_t value = 0;
+    const char* begin = body_.data() + pos_;
+    const char* end = body_.data() + body_.size();
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc{} || (ptr != end && !IsDelimiter(*ptr))) {
+      Fail("integer expected");
+    }
+    pos_ += ptr - begin;
+    return value;
+  }
+
+  /// @returns string contents with escape sequences left as is
+  std::string_view ReadRawString() {
+    Expect('"');
+    const size_t begin = pos_;
+    while (pos_ < body_.size() && body_[pos_] != '"') {
+      pos_ += (body_[pos_] == '\\') ? 2 : 1;
+    }
+    if (pos_ >= body_.size()) {
+      Fail("unterminated string");
+    }
+    return body_.substr(begin, pos_++ - begin);
+  }
+
+  std::string ReadString() {
+    const std::string_view raw = ReadRawString();
+    std::string result;
+    result.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] != '\\') {
+        result.push_back(raw[i]);
+        continue;
+      }
+      const char escaped = raw[++i];
+      switch (escaped) {
+        case 'b': result.push_back('\b'); break;
+        case 'f': result.push_back('\f'); break;
+        case 'n': result.push_back('\n'); break;
+        case 'r': result.push_back('\r'); break;
+        case 't': result.push_back('\t'); break;
+        case 'u': {
+          std::uint32_t code_point = ReadHex4(raw, i + 1);
+          i += 4;
+          if (0xD800 <= code_point && code_point < 0xDC00 &&
+              raw.substr(i + 1, 2) == "\\u") {
+            const std::uint32_t low = ReadHex4(raw, i + 3);
+            if (0xDC00 <= low && low < 0xE000) {
+              code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                           (low - 0xDC00);
+              i += 6;
+            }
+          }
+          AppendUtf8(result, code_point);
+          break;
+        }
+        default: result.push_back(escaped); break;
+      }
+    }
+    return result;
+  }
+
+  std::uint32_t ReadHex4(std::string_view raw, size_t pos) {
+    std::uint32_t value = 0;
+    const char* begin = raw.data() + pos;
+    if (pos + 4 > raw.size() ||
+        std::from_chars(begin, begin + 4, value, 16).ptr != begin + 4) {
+      Fail("invalid unicode escape");
+    }
+    return value;
+  }
+
+  static void AppendUtf8(std::string& out, std::uint32_t code_point) {
+    if (code_point < 0x80) {
+      out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+      out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+  }
+
+  static bool IsDelimiter(char c) {
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' ||
+           c == '\r' || c == '\n';
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < body_.size() &&
+           (body_[pos_] == ' ' || body_[pos_] == '\t' ||
+            body_[pos_] == '\r' || body_[pos_] == '\n')) {
+      ++pos_;
+    }
+  }
+
+  char Peek() {
+    SkipWhitespace();
+    return pos_ < body_.size() ? body_[pos_] : '\0';
+  }
+
+  bool Consume(char c) {
+    if (Peek() != c) {
+      return false;
+    }
+    ++pos_;
+    return true;
+  }
+
+  void Expect(char c) {
+    if (!Consume(c)) {
+      Fail(fmt::format("'{}' expected", c));
+    }
+  }
+
+  [[noreturn]] void Fail(std::string_view what) {
+    throw formats::json::ParseException(
+        fmt::format("Malformed Bot API reply at offset {}: {}", pos_, what));
+  }
+
+  const std::string_view body_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+AckReply ParseAckReply(std::string_view body) {
+  return AckScanner{body}.Scan();
+}
+
+AckReply ParseAckReply(const clients::http::Response& response) {
+  try {
+    return ParseAckReply(response.body_view());
+  } catch (const formats::json::ParseException&) {
+    // Not a Bot API reply at all (e.g. a proxy error page)
+    response.raise_for_status();
+    throw;
+  }
+}
+
+}  // namespace telegram::bot
+
+USERVER_NAMESPACE_END
@@ -0,0 +1,134 @@
+#include <userver/telegram/bot/requests/ack_reply.hpp>
+
+#include <gtest/gtest.h>
+
+#include <userver/formats/json/exception.hpp>
+
+USERVER_NAMESPACE_BEGIN
+
+namespace telegram::bot {
+
+TEST(AckReply, SentMessage) {
+  const AckReply reply = ParseAckReply(R"({
+    "ok": true,
+    "result": {
+      "message_id": 42,
+      "from": {"id": 1, "is_bot": true, "first_name": "ens"},
+      "chat": {"id": -1001234567890, "type": "supergroup", "title": "Evacuation"},
+      "date": 1700000000,
+      "text": "Leave the building",
+      "entities": [{"offset": 0, "length": 5, "type": "bold"}]
+    }
+  })");
+  EXPECT_TRUE(reply.ok);
+  EXPECT_EQ(reply.message_id, 42);
+  EXPECT_FALSE(reply.error_code.has_value());
+  EXPECT_FALSE(reply.description.has_value());
+  EXPECT_FALSE(reply.file_id.has_value());
+}
+
+TEST(AckReply, ErrorWithRetryAfter) {
+  const AckReply reply = ParseAckReply(
+      R"({"ok":false,"error_code":429,"description":"Too Many Requests: retry after 7",)"
+      R"("parameters":{"retry_after":7}})");
+  EXPECT_FALSE(reply.ok);
+  EXPECT_EQ(reply.error_code, 429);
+  EXPECT_EQ(reply.description, "Too Many Requests: retry after 7");
+  EXPECT_EQ(reply.retry_after, std::chrono::seconds{7});
+  EXPECT_FALSE(reply.migrate_to_chat_id.has_value());
+  EXPECT_FALSE(reply.message_id.has_value());
+}
+
+TEST(AckReply, ErrorWithMigration) {
+  const AckReply reply = ParseAckReply(
+      R"({"ok":false,"error_code":400,"description":"Bad Request: group chat was upgraded to a supergroup chat",)"
+      R"("parameters":{"migrate_to_chat_id":-1001234567890,"unknown":{"nested":[1,{"a":null}]}}})");
+  EXPECT_EQ(reply.error_code, 400);
+  EXPECT_EQ(reply.migrate_to_chat_id, -1001234567890);
+  EXPECT_FALSE(reply.retry_after.has_value());
+}
+
+TEST(AckReply, EscapedStrings) {
+  const AckReply reply = ParseAckReply(
+      R"({"ok":false,"error_code":403,)"
+      R"("description":"Forbidden: \"bot\" was blocked\\kicked\n\u00e9\u2014\ud83d\udea8\/"})");
+  EXPECT_EQ(reply.description, "Forbidden: \"bot\" was blocked\\kicked\n\xc3\xa9\xe2\x80\x94\xf0\x9f\x9a\xa8/");
+}
+
+TEST(AckReply, EscapedQuoteInSkippedValue) {
+  const AckReply reply = ParseAckReply(
+      R"({"ok":true,"result":{"text":"say \"hi\", then } or ]","message_id":7}})");
+  EXPECT_TRUE(reply.ok);
+  EXPECT_EQ(reply.message_id, 7);
+}
+
+TEST(AckReply, NullFields) {
+  const AckReply reply = ParseAckReply(
+      R"({"ok":false,"error_code":null,"description":null,)"
+      R"("parameters":{"retry_after":null,"migrate_to_chat_id":null},"result":null})");
+  EXPECT_FALSE(reply.ok);
+  EXPECT_FALSE(reply.error_code.has_value());
+  EXPECT_FALSE(reply.description.has_value());
+  EXPECT_FALSE(reply.retry_after.has_value());
+  EXPECT_FALSE(reply.migrate_to_chat_id.has_value());
+}
+
+TEST(AckReply, NullResultMembers) {
+  const AckReply reply = ParseAckReply(R"({"ok":true,"result":{"message_id":3,"photo":null,"document":null}})");
+  EXPECT_EQ(reply.message_id, 3);
+  EXPECT_FALSE(reply.file_id.has_value());
+}
+
+TEST(AckReply, PhotoSizesTakeLargest) {
+  const AckReply reply = ParseAckReply(R"({"ok":true,"result":{"message_id":5,"photo":[)"
+                                       R"({"file_id":"small","file_unique_id":"s","width":90,"height":90},)"
+                                       R"({"file_id":"medium","file_unique_id":"m","width":320,"height":320},)"
+                                       R"({"file_id":"large","file_unique_id":"l","width":800,"height":800}]}})");
+  EXPECT_EQ(reply.message_id, 5);
+  EXPECT_EQ(reply.file_id, "large");
+}
+
+TEST(AckReply, EmptyPhotoSizes) {
+  const AckReply reply = ParseAckReply(R"({"ok":true,"result":{"message_id":5,"photo":[]}})");
+  EXPECT_EQ(reply.message_id, 5);
+  EXPECT_FALSE(reply.file_id.has_value());
+}
+
+TEST(AckReply, DocumentFileId) {
+  const AckReply reply = ParseAckReply(R"({"ok":true,"result":{"message_id":6,)"
+                                       R"("document":{"file_name":"plan.pdf","thumbnail":{"file_id":"thumb"},)"
+                                       R"("file_id":"doc","file_size":1024}}})");
+  EXPECT_EQ(reply.file_id, "doc");
+}
+
+TEST(AckReply, UnknownNestedObjects) {
+  const AckReply reply = ParseAckReply(R"({
+    "ok" : true ,
+    "extra": {"deep": {"deeper": [[], [{}], {"k": [true, false, null, -1.5e3]}]}},
+    "result": {
+      "reply_markup": {"inline_keyboard": [[{"text": "Safe", "callback_data": "s:1"}]]},
+      "message_id": 8,
+      "message_id_like": 9
+    },
+    "trailing": "value"
+  })");
+  EXPECT_TRUE(reply.ok);
+  EXPECT_EQ(reply.message_id, 8);
+}
+
+TEST(AckReply, NonObjectResult) {
+  const AckReply reply = ParseAckReply(R"({"ok":true,"result":true})");
+  EXPECT_TRUE(reply.ok);
+  EXPECT_FALSE(reply.message_id.has_value());
+}
+
+TEST(AckReply, MalformedBody) {
+  EXPECT_THROW(ParseAckReply("<html>Bad Gateway</html>"), formats::json::ParseException);
+  EXPECT_THROW(ParseAckReply(R"({"ok":true,"description":"unterminated})"), formats::json::ParseException);
+  EXPECT_THROW(ParseAckReply(R"({"ok":true,"result":{"message_id":12abc}})"), formats::json::ParseException);
+  EXPECT_THROW(ParseAckReply(R"({"ok":true)"), formats::json::ParseException);
+}
+
+}  // namespace telegram::bot
+
+USERVER_NAMESPACE_END
@@ -0,0 +1,75 @@
+#include <userver/telegram/bot/requests/answer_callback_query.hpp>
+
+#include <telegram/bot/formats/parse.hpp>
+#include <telegram/bot/formats/serialize.hpp>
+#include <telegram/bot/formats/value_builder.hpp>
+#include <telegram/bot/requests/request_data.hpp>
+
+#include "userver/formats/json.hpp"
+#include "userver/formats/parse/common_containers.hpp"
+#include "userver/formats/serialize/common_containers.hpp"
+
+USERVER_NAMESPACE_BEGIN
+
+namespace telegram::bot {
+
+namespace impl {
+
+template <class Value>
+AnswerCallbackQueryMethod::Parameters Parse(
+    const Value& data,
+    formats::parse::To<AnswerCallbackQueryMethod::Parameters>) {
+  AnswerCallbackQueryMethod::Parameters parameters{
+    data["callback_query_id"].template As<std::string>()
+  };
+  parameters.text = data["text"].template As<std::optional<std::string>>();
+  parameters.show_alert = data["show_alert"].template As<std::optional<bool>>();
+  parameters.url = data["url"].template As<std::optional<std::string>>();
+  parameters.cache_time = data["cache_time"].template As<std::optional<std::int64_t>>();
+  return parameters;
+}
+
+template <class Value>
+Value Serialize(const AnswerCallbackQueryMethod::Parameters& parameters,
+                formats::serialize::To<Value>) {
+  typename Value::Builder builder;
+  builder["callback_query_id"] = parameters.callback_query_id;
+  SetIfNotNull(builder, "text", parameters.text);
+  SetIfNotNull(builder, "show_alert", parameters.show_alert);
+  SetIfNotNull(builder, "url", parameters.url);
+  SetIfNotNull(builder, "cache_time", parameters.cache_time);
+  return builder.ExtractValue();
+}
+
+}  // namespace impl
+
+AnswerCallbackQueryMethod::Parameters::Parameters(
+    std::string _callback_query_id)
+  : callback_query_id(std::move(_callback_query_id)) {}
+
+void AnswerCallbackQueryMethod::FillRequestData(
+    clients::http::Request& request,
+    const Parameters& parameters) {
+  FillRequestDataAsJson<AnswerCallbackQueryMethod>(request, parameters);
+}
+
+AnswerCallbackQueryMethod::Reply AnswerCallbackQueryMethod::ParseResponseData(
+    clients::http::Response& response) {
+  return ParseResponseDataFromJson<AnswerCallbackQueryMethod>(response);
+}
+
+AnswerCallbackQueryMethod::Parameters Parse(
+    const formats::json::Value& json,
+    formats::parse::To<AnswerCallbackQueryMethod::Parameters> to) {
+  return impl::Parse(json, to);
+}
+
+formats::json::Value Serialize(
+    const AnswerCallbackQueryMethod::Parameters& parameters,
+    formats::serialize::To<formats::json::Value> to) {
+  return impl::Serialize(parameters, to);
+}
+
+}  // namespace telegram::bot
+
+USERVER_NAMESPACE_END